@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef ARTIFACT_CACHE
+#define ARTIFACT_CACHE
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 按内容寻址的构建产物缓存，键为 (基准模块哈希, 规范化配置哈希, 工具链版本)。
+// 目录结构：<root>/objects/<key[0:2]>/<key>/<artifact>，写入先落到 <root>/tmp 再 rename，
+// 多个评估进程可共享同一目录；超过容量上限时按条目最近访问时间淘汰。
+class ArtifactCache {
+    public:
+        // maxBytes 为 0 表示不限容量
+        explicit ArtifactCache(string root, uint64_t maxBytes = 0);
+
+        static string hashFile(const string &path);
+        static string hashString(const string &text);
+        // 各节的条目顺序不影响结果：先按条目序列化结果排序再哈希
+        static string hashConfig(const nlohmann::json &config);
+        static string makeKey(const string &moduleHash, const string &configHash, const string &toolchain);
+
+        // 命中时把产物复制到 dest 并刷新条目的访问时间；不用硬链接，调用方原地修改 dest 不会波及缓存
+        bool get(const string &key, const string &artifact, const string &dest);
+        // 把 src 存为 key 下的 artifact，已存在时不覆盖；存入后按容量上限淘汰
+        bool put(const string &key, const string &artifact, const string &src);
+        // 淘汰最久未用的条目直到总大小不超过上限，返回删除的条目数
+        unsigned prune();
+
+        const string &root() const { return root_; }
+
+    private:
+        string entryDir(const string &key) const;
+
+        string root_;
+        uint64_t maxBytes_;
+};
+
+#endif
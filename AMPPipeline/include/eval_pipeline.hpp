@@ -0,0 +1,154 @@
+#pragma once
+
+#ifndef EVAL_PIPELINE
+#define EVAL_PIPELINE
+
+#include <nlohmann/json.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "measurement.hpp"
+#include "race.hpp"
+
+using namespace std;
+
+// 与 AMPPipeline/runtime 中插桩运行时的约定一致
+constexpr int AMP_NONFINITE_EXIT = 86;
+constexpr int AMP_WATCHDOG_EXIT = 87;
+
+// 有界阻塞队列：满时 push 阻塞，close 之后 pop 取完剩余元素返回 false
+template <typename T>
+class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+        void push(T value) {
+            unique_lock<mutex> lock(mutex_);
+            notFull_.wait(lock, [&] { return items_.size() < capacity_; });
+            items_.push_back(std::move(value));
+            notEmpty_.notify_one();
+        }
+
+        bool pop(T &value) {
+            unique_lock<mutex> lock(mutex_);
+            notEmpty_.wait(lock, [&] { return !items_.empty() || closed_; });
+            if (items_.empty()) return false;
+            value = std::move(items_.front());
+            items_.pop_front();
+            notFull_.notify_one();
+            return true;
+        }
+
+        void close() {
+            lock_guard<mutex> lock(mutex_);
+            closed_ = true;
+            notEmpty_.notify_all();
+        }
+
+    private:
+        size_t capacity_;
+        deque<T> items_;
+        bool closed_ = false;
+        mutex mutex_;
+        condition_variable notFull_, notEmpty_;
+};
+
+// 一次评估的全部命令参数，与 FitnessEvaluator 的流程对应
+struct EvalOptions {
+    string opt = "opt", llc = "llc", clang = "clang";
+    string libmix;                 // MixPrecision 插件
+    string module;                 // 基准模块 hpllink.ll
+    nlohmann::json baseline;       // 基准配置，逐步降精从它出发
+    vector<string> plArgs;         // 每步 pl 的附加参数（-amp-quiet 等），可含 {dir} 与 {step}
+    vector<string> lastPlArgs;     // 只加在最后一步（-check-finite 等）
+    vector<string> o2Passes;       // 放在 default<O2> 之前的插桩 pass
+    vector<string> o2Args;         // 可含 {dir}
+    vector<string> cflags;         // 链接用的 clang 参数（目标、-static 等）
+    vector<string> linkInputs;     // 插桩运行时等附加链接输入
+    vector<string> runner;         // 启动器，如 qemu-aarch64 -L /usr/aarch64-linux-gnu
+    vector<string> runArgs;        // 被测程序参数
+    unsigned testNum = 1;          // 不竞赛时的运行次数，以最后一次计分
+    RaceOptions race;              // 竞赛时运行 minRuns 到 maxRuns 次，以平均计分
+    IsolationOptions build;              // 降精、-O2、llc 与链接的子进程
+    vector<IsolationOptions> execute;    // 每个运行线程一份，各自绑定独占的 CPU；为空则不隔离
+    double baselineGflops[3] = {4.5471, 7.5516, 9.6609};  // min/mean/max，与评估器一致
+    string workDir = "amp_eval";
+};
+
+struct Individual {
+    size_t index = 0;
+    string id;
+    nlohmann::json config;
+    string dir;
+    string ir;                     // 当前阶段的输入/输出 IR
+    string executable;
+    string output;                 // 最后一次运行的 stdout
+    double runSeconds = 0, runCpuSeconds = 0;  // 最后一次运行的墙钟与 CPU 时间
+    vector<int> runCpus;
+    map<string, double> counters;  // 最后一次运行的硬件计数，不可用时为空
+    vector<double> raceScores;     // 竞赛时每次运行的得分（final_marks）
+    RaceInterval raceInterval;
+    string raceDecision;
+    map<string, double> stageSeconds;
+    string failedStage, error;
+    double passRate = 0, minGflops = 0, meanGflops = 0, maxGflops = 0;
+    double fitness = numeric_limits<double>::infinity();
+
+    nlohmann::json toJSON() const;
+};
+
+// 与 config/conversion_steps.py 相同：double 到 half 先经 float 一步
+vector<nlohmann::json> conversionSteps(const nlohmann::json &current, const nlohmann::json &target);
+
+// 降精（pl 各步）-> -O2 -> llc 与链接 -> 运行，各阶段有自己的工作线程与有界队列，不同个体的阶段相互重叠。
+// 某个阶段失败的个体不再进入后续阶段，直接输出
+class EvalPipeline {
+    public:
+        struct StageJobs {
+            unsigned transform = 1, optimize = 1, codegen = 1, execute = 1;
+        };
+
+        EvalPipeline(EvalOptions options, StageJobs jobs, size_t queueDepth);
+
+        // 结果按完成顺序回调，回调之间互斥
+        void run(vector<Individual> &individuals, const function<void(const Individual &)> &onResult);
+
+        // 各阶段累计的工作时间
+        const map<string, double> &busySeconds() const { return busy_; }
+
+    private:
+        // worker 为本阶段内的工作线程序号
+        bool transform(Individual &individual, unsigned worker);
+        bool optimize(Individual &individual, unsigned worker);
+        bool codegen(Individual &individual, unsigned worker);
+        bool execute(Individual &individual, unsigned worker);
+        bool step(Individual &individual, const vector<string> &command, const string &what);
+
+        struct RunMetrics {
+            double passRate = 0, minGflops = 0, meanGflops = 0, maxGflops = 0;
+            double fitness = 0;
+        };
+        RunMetrics parseMetrics(const string &output) const;
+
+        // 竞赛的对手：外部给定的最优或本批中目前最好的个体，运行线程之间共享
+        bool currentIncumbent(RaceInterval &incumbent);
+        void offerIncumbent(const RaceInterval &interval, bool worse);
+
+        EvalOptions options_;
+        StageJobs jobs_;
+        size_t queueDepth_;
+        map<string, double> busy_;
+        mutex busyMutex_;
+        RaceInterval incumbent_;
+        bool hasIncumbent_ = false;
+        mutex raceMutex_;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef FORK_SERVER_RUNNER
+#define FORK_SERVER_RUNNER
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "measurement.hpp"
+
+using namespace std;
+
+struct RunResult {
+    bool ok = false;           // 与服务端通信是否正常
+    bool timedOut = false;
+    int exitCode = -1;         // 正常退出时的返回码
+    int signal = 0;            // 被信号终止时的信号编号
+    double seconds = 0;        // 从发出请求到收到状态的墙钟时间
+    string output;             // 子进程 stdout
+    string errorOutput;        // 子进程 stderr（如 __amp_report_nonfinite 报告的变量）
+    map<string, double> counters;  // 本次运行的硬件计数（服务端计数前后之差），未启用时为空
+};
+
+// 启动一次被测程序（可经由 qemu-aarch64 等启动器），之后通过
+// forkserver_protocol.h 中的协议反复请求运行，每次运行由程序内的桩代码 fork 出来
+class ForkServer {
+    public:
+        // command: 启动器与被测程序，如 {"qemu-aarch64", "-L", "/usr/aarch64-linux-gnu", "./hpl"}
+        ForkServer(vector<string> command, string workDir = ".");
+        ~ForkServer();
+
+        // 在 start 之前设置；绑核与 ASLR 作用于服务端，fork 出的每次运行随之继承
+        void setIsolation(const IsolationOptions &isolation) { isolation_ = isolation; }
+        bool countersAvailable() const { return counters_.available(); }
+
+        // 启动服务端并等待握手，失败时 error 中给出原因
+        bool start(double timeoutSec, string &error);
+        // 以 args 作为 argv[1..] 运行一次；timeoutSec 为 0 表示不限时
+        RunResult run(const vector<string> &args, double timeoutSec);
+        void stop();
+
+        bool running() const { return serverPid_ > 0; }
+
+    private:
+        bool readStatus(void *buf, size_t len, double timeoutSec);
+
+        vector<string> command_;
+        string workDir_;
+        pid_t serverPid_ = -1;
+        int ctlFd_ = -1;   // 写请求
+        int stFd_ = -1;    // 读状态
+        unsigned runId_ = 0;
+        IsolationOptions isolation_;
+        PerfCounters counters_;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef AMP_FORKSERVER_PROTOCOL
+#define AMP_FORKSERVER_PROTOCOL
+
+/*
+ * runner 与被测程序中 fork server 桩代码之间的约定，C 桩代码与 C++ runner 共用。
+ * 控制管道 runner -> 服务端，状态管道 服务端 -> runner，文件描述符沿用 AFL 的 198/199。
+ *
+ * 握手：服务端启动后向状态管道写 uint32 AMP_FORKSRV_HELLO。
+ * 请求：uint32 长度 + 以 '\0' 分隔的字符串：stdout 输出文件路径、stderr 输出文件路径、argv[1]、argv[2]、...
+ * 路径为空时不重定向。
+ * 响应：int32 子进程 pid，子进程结束后再写 int32 waitpid 状态。
+ * runner 关闭控制管道后服务端退出。
+ */
+
+#define AMP_FORKSRV_CTL_FD 198
+#define AMP_FORKSRV_ST_FD 199
+
+/* 只有设置了该环境变量，桩代码才进入 fork server 模式，否则程序照常运行 */
+#define AMP_FORKSRV_ENV "AMP_FORKSRV"
+
+#define AMP_FORKSRV_HELLO 0x414d5032u /* "AMP2"，请求中加入 stderr 路径后递增，旧桩代码握手失败 */
+#define AMP_FORKSRV_MAX_REQUEST (64 * 1024)
+#define AMP_FORKSRV_MAX_ARGS 256
+
+#endif
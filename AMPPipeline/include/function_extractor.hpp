@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef FUNCTION_EXTRACTOR
+#define FUNCTION_EXTRACTOR
+
+#include <llvm/IR/Module.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 与 llvm-extract 类似，从完整模块中取出指定函数及其（直接调用可达的）被调函数，
+// 其余函数只留声明，再删掉不再被引用的全局变量与声明。全局构造/析构函数一并去掉，
+// 抽出的内核不依赖完整程序的初始化。
+// addHarness 另外生成 main：按录制文件（MixPrecision record-call pass 产生）恢复参数后
+// 反复调用目标函数并计时，回放运行时见 runtime/amp_replay.c。
+class FunctionExtractor {
+    public:
+        bool extract(llvm::Module &M, const vector<string> &roots, bool withCallees, string &error);
+        bool addHarness(llvm::Module &M, const string &function, string &error);
+
+        const set<string> &kept() const { return kept_; }
+        // 抽取后仍被引用、链接时需要由别处提供的函数（库函数以外的通常说明抽取范围不够）
+        const vector<string> &unresolved() const { return unresolved_; }
+
+    private:
+        void collect(llvm::Module &M, const vector<string> &roots, bool withCallees);
+        static void removeDeadGlobals(llvm::Module &M, const set<string> &keep);
+
+        set<string> kept_;
+        vector<string> unresolved_;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef INCREMENTAL_CODEGEN
+#define INCREMENTAL_CODEGEN
+
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "artifact_cache.hpp"
+
+using namespace std;
+
+// 按函数增量生成目标代码：把模块拆成每个函数一个子模块（全局变量单独一个），
+// 以子模块 IR 的哈希为键到 ArtifactCache 中取目标文件，只对未命中的子模块做代码生成。
+// 两个配置只差几个变量时，绝大多数函数降精、-O2 之后的 IR 不变，可以直接复用目标文件。
+class IncrementalCodegen {
+    public:
+        struct Stats {
+            unsigned parts = 0;
+            unsigned hits = 0;
+        };
+
+        // outDir 存放本次用到的全部目标文件，cache 为 nullptr 时每次都重新生成
+        IncrementalCodegen(string outDir, ArtifactCache *cache);
+
+        // 成功时 objects 为链接所需的全部目标文件，失败时 error 中给出原因
+        bool run(llvm::Module &M, vector<string> &objects, string &error);
+
+        const Stats &stats() const { return stats_; }
+
+    private:
+        // 拆分前把局部链接的符号改为隐藏的外部符号，子模块之间才能互相引用
+        static void externalizeLocals(llvm::Module &M);
+        bool createTargetMachine(llvm::Module &M, string &error);
+        bool emitObject(llvm::Module &part, const string &path, string &error);
+        bool compilePart(llvm::Module &part, const string &name, vector<string> &objects, string &error);
+
+        string outDir_;
+        ArtifactCache *cache_;
+        unique_ptr<llvm::TargetMachine> TM_;
+        string toolchain_;
+        Stats stats_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef LOOP_THROUGHPUT
+#define LOOP_THROUGHPUT
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Module.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 用 llvm-mca 静态估计最内层循环每次迭代的周期数：在循环头与回边块中插入
+// LLVM-MCA-BEGIN/END 注释形式的内联汇编，按目标 CPU 的调度模型生成汇编，
+// 交给 llvm-mca 分析，每个区域的 Block RThroughput 即每次迭代的周期数。
+// 循环按循环头相对函数入口的块频率加权汇总，用于在运行 qemu 之前给配置排序。
+// 代码生成后标记顺序不对的循环不参与分析，只计入 skipped()。
+class LoopThroughput {
+    public:
+        struct LoopEstimate {
+            string function;
+            unsigned line = 0;
+            string region;
+            double cyclesPerIteration = 0;
+            double weight = 0;        // 循环头块频率 / 函数入口块频率
+        };
+
+        LoopThroughput(string cpu, string mcaPath) : cpu_(std::move(cpu)), mcaPath_(std::move(mcaPath)) {}
+
+        // functions 为空时分析全部函数
+        bool run(llvm::Module &M, const set<string> &functions, string &error);
+
+        const vector<LoopEstimate> &loops() const { return loops_; }
+        unsigned skipped() const { return skipped_; }
+        double weightedTotal() const;
+
+    private:
+        unsigned markLoops(llvm::Function &F);
+        bool emitAssembly(llvm::Module &M, const string &path, string &error);
+        // 返回标记顺序不对的区域名
+        static set<string> checkMarkers(llvm::ArrayRef<llvm::StringRef> lines);
+        bool runMCA(const string &triple, const string &asmPath, string &error);
+
+        string cpu_;
+        string mcaPath_;
+        vector<LoopEstimate> loops_;
+        unsigned skipped_ = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef MEASUREMENT
+#define MEASUREMENT
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// 被测进程的隔离方式，由 runProcess 与 ForkServer 在 fork 之后、exec 之前施加
+struct IsolationOptions {
+    vector<int> cpus;              // 绑定的 CPU，空为不绑定
+    bool disableASLR = false;      // 关闭地址随机化，消除布局差异带来的抖动
+    bool perfCounters = false;     // 用 perf_event_open 统计被测进程（含其子进程）的硬件计数
+};
+
+// 解析 "0-3,8" 形式的 CPU 列表
+bool parseCpuList(const string &text, vector<int> &cpus);
+// 当前进程允许运行的 CPU
+vector<int> allowedCpus();
+
+// 在 fork 出的子进程中调用，只做系统调用；失败时忽略，照常 exec
+void applyIsolationInChild(const IsolationOptions &isolation);
+
+// cycles、instructions、L1D 与 LLC 读缺失，外加软件计数 task-clock。
+// 各计数单独打开，缺少某个硬件事件（虚拟机、perf_event_paranoid 过高）时只跳过该项；
+// 计数继承给子进程，子进程退出时并入，因此可对 fork server 按运行前后作差
+class PerfCounters {
+    public:
+        PerfCounters() = default;
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+        ~PerfCounters();
+
+        // enableOnExec 时计数从 pid 下一次 exec 开始，调用方须保证此时 pid 尚未 exec
+        bool open(pid_t pid, bool enableOnExec);
+        void close();
+        bool available() const { return !fds_.empty(); }
+
+        // 按 time_enabled/time_running 缩放（计数器复用时），键为 cycles、instructions、l1dMisses、llcMisses、taskClockNs
+        map<string, double> read() const;
+
+    private:
+        vector<pair<string, int>> fds_;
+};
+
+// 尽量去掉频率抖动：所给 CPU 的 scaling_governor 设为 performance，关闭睿频/boost。
+// 没有写权限的项跳过，析构时恢复原值（进程被杀死时不恢复）
+class CpuFrequencyGuard {
+    public:
+        explicit CpuFrequencyGuard(const vector<int> &cpus);
+        CpuFrequencyGuard(const CpuFrequencyGuard &) = delete;
+        CpuFrequencyGuard &operator=(const CpuFrequencyGuard &) = delete;
+        ~CpuFrequencyGuard();
+
+        // 实际改动了的 sysfs 文件
+        vector<string> applied() const;
+
+    private:
+        bool set(const string &path, const string &value);
+
+        vector<pair<string, string>> saved_;  // 路径 -> 原值
+};
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#ifndef PROCESS_RUNNER
+#define PROCESS_RUNNER
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "measurement.hpp"
+
+using namespace std;
+
+struct ProcessResult {
+    int exitCode = -1;      // 正常退出时的返回码，被信号终止时为 128 + 信号编号，启动失败为 -1
+    double seconds = 0;     // 墙钟时间
+    long peakRSSKiB = 0;    // wait4 给出的峰值常驻内存（Linux 上单位为 KiB）
+    double cpuSeconds = 0;  // 用户态加内核态 CPU 时间，没有硬件计数时作为较稳定的时间
+    map<string, double> counters;  // isolation.perfCounters 时的计数，见 PerfCounters::read
+    string output;          // captureOutput 时的 stdout
+};
+
+// 运行一个子进程并等待结束。cwd 为空时不切换目录；stderr（未捕获时连同 stdout）追加写到 log，
+// log 为空则丢弃。可在多个线程中同时调用：管道带 O_CLOEXEC，不会泄漏给其他线程启动的子进程。
+// isolation 在 exec 之前施加；要计数时子进程先等父进程打开计数器再 exec
+ProcessResult runProcess(const vector<string> &command, const string &cwd, const string &log,
+                         bool captureOutput = false, const IsolationOptions &isolation = {});
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef REPETITION_RACE
+#define REPETITION_RACE
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+struct RaceOptions {
+    bool enabled = false;
+    unsigned minRuns = 1;
+    unsigned maxRuns = 5;
+    double confidence = 0.95;      // 双侧置信水平
+    double noise = 0.02;           // 先验相对标准差：样本太少时标准差不低于 noise * |均值|
+    double incumbent = NAN;        // 外部给定的当前最优（得分越高越好），NAN 为没有
+};
+
+struct RaceInterval {
+    size_t runs = 0;
+    double mean = 0, low = 0, high = 0;
+};
+
+// 顺序统计竞赛：逐次加入一次运行的得分（越高越好），置信区间与当前最优的区间分开即停止。
+// 标准差取样本标准差与先验噪声的较大者，一次运行就能淘汰明显更差的配置；
+// 区间用正态分位数，样本少时由先验噪声兜底
+class RepetitionRace {
+    public:
+        enum class Decision { Continue, Worse, Better, Unresolved, NoIncumbent };
+
+        explicit RepetitionRace(const RaceOptions &options) : options_(options) {}
+
+        void add(double score) { scores_.push_back(score); }
+        const vector<double> &scores() const { return scores_; }
+        RaceInterval interval() const;
+
+        // incumbent 为 nullptr 时跑满 minRuns 即停
+        Decision decide(const RaceInterval *incumbent) const;
+
+        static const char *name(Decision decision);
+
+    private:
+        RaceOptions options_;
+        vector<double> scores_;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#ifndef SYNTHETIC_MODULE
+#define SYNTHETIC_MODULE
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <nlohmann/json.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 合成模块的规模参数，amp-scale 据此扫描 MixPrecision 各 pass 的耗时
+struct SyntheticSpec {
+    unsigned functions = 8;      // 函数个数 f0..f<n-1>
+    unsigned locals = 32;        // 每个函数的 double 局部变量 s0..s<n-1>
+    unsigned pointerDepth = 1;   // 数组参数 a 的指针层数，1 即 double*
+    unsigned uses = 4;           // 每个局部变量在最内层循环中的读改写次数
+    unsigned loopDepth = 2;      // 循环嵌套层数
+
+    string name() const;
+    nlohmann::json toJSON() const;
+};
+
+// 生成 clang -O0 风格的模块：参数先存入 alloca（ParseConfig 的 findAlloca 据此认出参数），
+// 局部变量均为 alloca，循环体内逐个读改写，与 HPL-AI 中降精的对象形状一致
+unique_ptr<llvm::Module> buildSyntheticModule(llvm::LLVMContext &context, const SyntheticSpec &spec);
+
+// 每个函数的前 fraction 比例局部变量改为 float，lowerArgs 时数组参数一并改为 float*
+nlohmann::json buildSyntheticConfig(const SyntheticSpec &spec, double fraction, bool lowerArgs);
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef XGBOOST_MODEL
+#define XGBOOST_MODEL
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 读取 XGBoost save_model 导出的 JSON 模型（gbtree，单输出回归/二分类），本地推理。
+// 所有树的节点展平存放，特征按模型中的下标排列，NaN 表示缺失值，按 default_left 走。
+class XGBoostModel {
+    public:
+        bool load(const string &path, string &error);
+
+        // features 长度为 numFeatures()
+        double predict(const float *features) const;
+        // rows 为 n 行按行存放的特征
+        void predictBatch(const float *rows, size_t n, vector<double> &out) const;
+
+        size_t numFeatures() const { return numFeatures_; }
+        // 模型未带特征名时为 f0, f1, ...
+        const vector<string> &featureNames() const { return featureNames_; }
+        // 不在模型中的特征返回 -1
+        int featureIndex(const string &name) const;
+
+    private:
+        enum class Objective { Identity, Logistic, Exp };
+
+        struct Node {
+            int32_t left = -1;      // -1 为叶节点
+            int32_t right = -1;
+            uint32_t feature = 0;
+            float value = 0;        // 分裂阈值，叶节点为叶子权重
+            bool defaultLeft = false;
+        };
+
+        double transform(double margin) const;
+
+        vector<Node> nodes_;
+        vector<uint32_t> roots_;
+        size_t numFeatures_ = 0;
+        vector<string> featureNames_;
+        map<string, int> featureIndex_;
+        double baseMargin_ = 0;
+        Objective objective_ = Objective::Identity;
+};
+
+#endif
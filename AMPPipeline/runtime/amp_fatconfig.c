@@ -0,0 +1,34 @@
+/*
+ * 多配置 fat binary 的运行时选择，与 MixPrecision fat-config pass 生成的程序一起链接。
+ * 生成的 main 入口调用 __amp_select_config，返回值决定各分派桩调用哪个函数变体。
+ * 首个参数 --amp-config=N 优先于环境变量 AMP_CONFIG；该参数会从 argv 中去掉，
+ * 因此与 fork server 一起使用时每次运行都可以选择不同的配置。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AMP_CONFIG_ENV "AMP_CONFIG"
+#define AMP_CONFIG_ARG "--amp-config="
+
+int __amp_select_config(int *argc, char ***argv, int numConfigs) {
+    const char *text = getenv(AMP_CONFIG_ENV);
+
+    if (*argc > 1 && strncmp((*argv)[1], AMP_CONFIG_ARG, strlen(AMP_CONFIG_ARG)) == 0) {
+        text = (*argv)[1] + strlen(AMP_CONFIG_ARG);
+        /* 把 argv[0] 后移一位覆盖掉该参数 */
+        (*argv)[1] = (*argv)[0];
+        *argv += 1;
+        *argc -= 1;
+    }
+
+    if (!text || !*text) return 0;
+
+    char *end;
+    long index = strtol(text, &end, 10);
+    if (*end != '\0' || index < 0 || index >= numConfigs) {
+        fprintf(stderr, "[amp] invalid config index \"%s\", expected 0..%d\n", text, numConfigs - 1);
+        exit(2);
+    }
+    return (int)index;
+}
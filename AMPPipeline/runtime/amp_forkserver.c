@@ -0,0 +1,108 @@
+/*
+ * fork server 桩代码，与被测程序一起链接。
+ * MixPrecision 的 fork-server pass 把原 main 改名并在新 main 中先调用 __amp_forkserver，
+ * 这样模拟器启动、静态程序加载等开销只发生一次，之后每次运行都从已初始化的进程 fork 出来。
+ * 协议见 AMPPipeline/include/forkserver_protocol.h。
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "forkserver_protocol.h"
+
+static char request[AMP_FORKSRV_MAX_REQUEST + 1];
+static char *runArgv[AMP_FORKSRV_MAX_ARGS + 2];
+
+static int readFull(int fd, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int writeFull(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void redirect(const char *path, int target) {
+    if (!path[0]) return;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) _exit(127);
+    dup2(fd, target);
+    close(fd);
+}
+
+/* 子进程：按请求重定向 stdout、stderr 并换上本次运行的 argv */
+static void setupChild(uint32_t len, int *argc, char ***argv) {
+    close(AMP_FORKSRV_CTL_FD);
+    close(AMP_FORKSRV_ST_FD);
+
+    int n = 0, field = 0;
+    runArgv[n++] = (*argc > 0) ? (*argv)[0] : "a.out";
+    for (uint32_t pos = 0; pos < len; field++) {
+        char *s = request + pos;
+        size_t sl = strnlen(s, len - pos);
+        if (field == 0) {
+            redirect(s, STDOUT_FILENO);
+        } else if (field == 1) {
+            redirect(s, STDERR_FILENO);
+        } else if (n <= AMP_FORKSRV_MAX_ARGS) {
+            runArgv[n++] = s;
+        }
+        pos += (uint32_t)sl + 1;
+    }
+    runArgv[n] = NULL;
+
+    *argc = n;
+    *argv = runArgv;
+}
+
+void __amp_forkserver(int *argc, char ***argv) {
+    if (!getenv(AMP_FORKSRV_ENV)) return;
+
+    /* 没有 runner 接管状态管道时按普通程序运行 */
+    uint32_t hello = AMP_FORKSRV_HELLO;
+    if (writeFull(AMP_FORKSRV_ST_FD, &hello, sizeof(hello)) != 0) return;
+
+    for (;;) {
+        uint32_t len;
+        if (readFull(AMP_FORKSRV_CTL_FD, &len, sizeof(len)) != 0) _exit(0);
+        if (len > AMP_FORKSRV_MAX_REQUEST || readFull(AMP_FORKSRV_CTL_FD, request, len) != 0) _exit(1);
+        request[len] = '\0';
+
+        /* 避免缓冲区中的内容在每个子进程里重复输出 */
+        fflush(stdout);
+        fflush(stderr);
+
+        pid_t pid = fork();
+        if (pid < 0) _exit(1);
+        if (pid == 0) {
+            setupChild(len, argc, argv);
+            return;
+        }
+
+        int32_t pidValue = (int32_t)pid;
+        if (writeFull(AMP_FORKSRV_ST_FD, &pidValue, sizeof(pidValue)) != 0) _exit(1);
+
+        int status;
+        if (waitpid(pid, &status, 0) < 0) _exit(1);
+        int32_t statusValue = (int32_t)status;
+        if (writeFull(AMP_FORKSRV_ST_FD, &statusValue, sizeof(statusValue)) != 0) _exit(1);
+    }
+}
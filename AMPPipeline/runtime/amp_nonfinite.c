@@ -0,0 +1,23 @@
+/*
+ * 非有限值检查的报错入口，与 -check-finite 插桩后的程序一起链接。
+ * 掩码中每一位对应 ids 中的一个 ID（超过 64 个时按 64 取模共用一位），
+ * 报告最低的置位对应的 ID 后以 AMP_NONFINITE_EXIT 退出，评估脚本据此识别。
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define AMP_NONFINITE_EXIT 86
+
+void __amp_report_nonfinite(uint64_t mask, const char *const *ids, int count) {
+    int bit = 0;
+    while (bit < 63 && !(mask & ((uint64_t)1 << bit))) bit++;
+
+    fprintf(stderr, "[amp] non-finite value:");
+    for (int i = bit; i < count; i += 64) fprintf(stderr, " %s", ids[i]);
+    fprintf(stderr, "\n");
+    fflush(stderr);
+
+    /* 不执行 atexit 等清理，尽快结束 */
+    _exit(AMP_NONFINITE_EXIT);
+}
@@ -0,0 +1,254 @@
+/*
+ * 调用录制与回放运行时。
+ * 录制端与 MixPrecision record-call pass 插桩后的完整程序一起链接：命中的那次调用把标量参数、
+ * 指针参数所指缓冲区（入口与返回时各一份）写到 AMP_RECORD_OUT（默认 amp_record.bin）。
+ * 回放端与 amp-extract -harness 生成的程序一起链接：读取 AMP_REPLAY_IN（默认 amp_record.bin），
+ * 每次重复前恢复输入缓冲区，调用 AMP_REPLAY_REPS 次（默认 10）并计时，
+ * 最后把缓冲区与录制时（通常为全 double 构建）的结果比较，结果以一行 JSON 写到标准输出。
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define AMP_RECORD_MAGIC "AMPREC1"
+#define AMP_RECORD_DEFAULT "amp_record.bin"
+#define AMP_RECORD_MAX_ARGS 64
+
+/* 与 call_record.hpp 中的 RecordElement 一致 */
+enum { AMP_I8, AMP_I32, AMP_I64, AMP_F16, AMP_F32, AMP_F64, AMP_BF16 };
+/* 参数种类 */
+enum { AMP_ARG_INT, AMP_ARG_FP, AMP_ARG_BUFFER };
+
+struct AmpRecordArg {
+    uint32_t kind;
+    uint32_t element;
+    uint64_t value; /* 标量的位模式，或缓冲区的元素个数 */
+    void *data;
+};
+
+static const size_t elementSize[] = {1, 4, 8, 2, 4, 8, 2};
+
+static struct AmpRecordArg inputs[AMP_RECORD_MAX_ARGS], outputs[AMP_RECORD_MAX_ARGS];
+static uint32_t numArgs;
+static int hasOutput[AMP_RECORD_MAX_ARGS];
+
+static size_t bytesOf(const struct AmpRecordArg *arg) {
+    return arg->kind == AMP_ARG_BUFFER ? arg->value * elementSize[arg->element] : 0;
+}
+
+/* ---------------- 录制 ---------------- */
+
+static uint64_t calls;
+static int recording, recorded;
+
+int __amp_record_enter(uint64_t index) {
+    if (recording || recorded || ++calls != index) return 0;
+    recording = 1;
+    return 1;
+}
+
+void __amp_record_scalar(int active, int arg, int kind, uint64_t bits) {
+    if (!active || arg >= AMP_RECORD_MAX_ARGS) return;
+    inputs[arg] = (struct AmpRecordArg){(uint32_t)kind, AMP_I8, bits, NULL};
+    if ((uint32_t)arg + 1 > numArgs) numArgs = arg + 1;
+}
+
+static void copyBuffer(struct AmpRecordArg *dst, const void *ptr, uint64_t count, int element) {
+    *dst = (struct AmpRecordArg){AMP_ARG_BUFFER, (uint32_t)element, ptr ? count : 0, NULL};
+    size_t bytes = bytesOf(dst);
+    if (bytes) {
+        dst->data = malloc(bytes);
+        memcpy(dst->data, ptr, bytes);
+    }
+}
+
+void __amp_record_buffer(int active, int arg, const void *ptr, uint64_t count, int element) {
+    if (!active || arg >= AMP_RECORD_MAX_ARGS) return;
+    copyBuffer(&inputs[arg], ptr, count, element);
+    if ((uint32_t)arg + 1 > numArgs) numArgs = arg + 1;
+}
+
+void __amp_record_output(int active, int arg, const void *ptr, uint64_t count, int element) {
+    if (!active || arg >= AMP_RECORD_MAX_ARGS) return;
+    copyBuffer(&outputs[arg], ptr, count, element);
+    hasOutput[arg] = 1;
+}
+
+static void writeArg(FILE *out, const struct AmpRecordArg *arg) {
+    fwrite(&arg->kind, sizeof(uint32_t), 1, out);
+    fwrite(&arg->element, sizeof(uint32_t), 1, out);
+    fwrite(&arg->value, sizeof(uint64_t), 1, out);
+    if (bytesOf(arg)) fwrite(arg->data, 1, bytesOf(arg), out);
+}
+
+void __amp_record_finish(int active) {
+    if (!active) return;
+    recording = 0;
+    recorded = 1;
+
+    const char *path = getenv("AMP_RECORD_OUT");
+    FILE *out = fopen(path && *path ? path : AMP_RECORD_DEFAULT, "wb");
+    if (!out) {
+        perror("[amp-record]");
+        return;
+    }
+    fwrite(AMP_RECORD_MAGIC, 1, 8, out);
+    fwrite(&numArgs, sizeof(uint32_t), 1, out);
+    for (uint32_t i = 0; i < numArgs; i++) writeArg(out, &inputs[i]);
+
+    uint32_t numOutputs = 0;
+    for (uint32_t i = 0; i < numArgs; i++) numOutputs += hasOutput[i];
+    fwrite(&numOutputs, sizeof(uint32_t), 1, out);
+    for (uint32_t i = 0; i < numArgs; i++) {
+        if (!hasOutput[i]) continue;
+        fwrite(&i, sizeof(uint32_t), 1, out);
+        writeArg(out, &outputs[i]);
+    }
+    fclose(out);
+    fprintf(stderr, "[amp-record] call %llu recorded, %u argument(s)\n", (unsigned long long)calls, numArgs);
+}
+
+/* ---------------- 回放 ---------------- */
+
+static void *working[AMP_RECORD_MAX_ARGS];
+static double *seconds;
+static int reps, rep;
+static struct timespec started;
+
+static int readArg(FILE *in, struct AmpRecordArg *arg) {
+    if (fread(&arg->kind, sizeof(uint32_t), 1, in) != 1 || fread(&arg->element, sizeof(uint32_t), 1, in) != 1 ||
+        fread(&arg->value, sizeof(uint64_t), 1, in) != 1 || arg->element > AMP_BF16)
+        return 0;
+    size_t bytes = bytesOf(arg);
+    arg->data = NULL;
+    if (!bytes) return 1;
+    arg->data = malloc(bytes);
+    return arg->data && fread(arg->data, 1, bytes, in) == bytes;
+}
+
+static void replayFail(const char *what) {
+    fprintf(stderr, "[amp-replay] %s\n", what);
+    exit(1);
+}
+
+void __amp_replay_open(void) {
+    const char *path = getenv("AMP_REPLAY_IN");
+    FILE *in = fopen(path && *path ? path : AMP_RECORD_DEFAULT, "rb");
+    if (!in) replayFail("cannot open record file");
+
+    char magic[8];
+    if (fread(magic, 1, 8, in) != 8 || memcmp(magic, AMP_RECORD_MAGIC, 8) != 0) replayFail("not a record file");
+    if (fread(&numArgs, sizeof(uint32_t), 1, in) != 1 || numArgs > AMP_RECORD_MAX_ARGS) replayFail("bad header");
+    for (uint32_t i = 0; i < numArgs; i++) {
+        if (!readArg(in, &inputs[i])) replayFail("truncated arguments");
+    }
+    uint32_t numOutputs;
+    if (fread(&numOutputs, sizeof(uint32_t), 1, in) != 1) replayFail("truncated outputs");
+    for (uint32_t k = 0; k < numOutputs; k++) {
+        uint32_t i;
+        if (fread(&i, sizeof(uint32_t), 1, in) != 1 || i >= numArgs || !readArg(in, &outputs[i]))
+            replayFail("truncated outputs");
+        hasOutput[i] = 1;
+    }
+    fclose(in);
+
+    /* 工作缓冲区按 64 字节对齐，与输入分开，每次重复前恢复 */
+    for (uint32_t i = 0; i < numArgs; i++) {
+        size_t bytes = bytesOf(&inputs[i]);
+        if (bytes) working[i] = aligned_alloc(64, (bytes + 63) / 64 * 64);
+    }
+
+    const char *env = getenv("AMP_REPLAY_REPS");
+    reps = env && atoi(env) > 0 ? atoi(env) : 10;
+    seconds = calloc(reps, sizeof(double));
+}
+
+int __amp_replay_reps(void) { return reps; }
+
+void __amp_replay_reset(void) {
+    for (uint32_t i = 0; i < numArgs; i++) {
+        if (working[i]) memcpy(working[i], inputs[i].data, bytesOf(&inputs[i]));
+    }
+}
+
+int64_t __amp_replay_int(int arg) { return (int64_t)inputs[arg].value; }
+
+double __amp_replay_fp(int arg) {
+    double value;
+    memcpy(&value, &inputs[arg].value, sizeof(double));
+    return value;
+}
+
+void *__amp_replay_ptr(int arg) { return working[arg]; }
+
+void __amp_replay_begin(void) { clock_gettime(CLOCK_MONOTONIC, &started); }
+
+void __amp_replay_end(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (rep < reps) seconds[rep++] = (now.tv_sec - started.tv_sec) + (now.tv_nsec - started.tv_nsec) * 1e-9;
+}
+
+static double halfToDouble(uint16_t h) {
+    int exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    double value = exponent == 0    ? ldexp(mantissa, -24)
+                   : exponent == 31 ? (mantissa ? NAN : INFINITY)
+                                    : ldexp(mantissa | 0x400, exponent - 25);
+    return h & 0x8000 ? -value : value;
+}
+
+static double elementAt(const void *data, int element, uint64_t i) {
+    switch (element) {
+        case AMP_I8: return ((const int8_t *)data)[i];
+        case AMP_I32: return ((const int32_t *)data)[i];
+        case AMP_I64: return (double)((const int64_t *)data)[i];
+        case AMP_F16: return halfToDouble(((const uint16_t *)data)[i]);
+        case AMP_F32: return ((const float *)data)[i];
+        case AMP_F64: return ((const double *)data)[i];
+        default: {
+            uint32_t bits = (uint32_t)((const uint16_t *)data)[i] << 16;
+            float value;
+            memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+    }
+}
+
+void __amp_replay_report(void) {
+    double minSeconds = rep ? seconds[0] : 0, sumSeconds = 0;
+    for (int i = 0; i < rep; i++) {
+        if (seconds[i] < minSeconds) minSeconds = seconds[i];
+        sumSeconds += seconds[i];
+    }
+    printf("{\"reps\": %d, \"minSeconds\": %.9f, \"meanSeconds\": %.9f, \"outputs\": [", rep, minSeconds,
+           rep ? sumSeconds / rep : 0.0);
+
+    int first = 1;
+    for (uint32_t i = 0; i < numArgs; i++) {
+        if (!hasOutput[i] || !working[i]) continue;
+        const struct AmpRecordArg *ref = &outputs[i];
+        double maxAbs = 0, maxRel = 0;
+        uint64_t mismatches = 0, nonfinite = 0;
+        for (uint64_t k = 0; k < ref->value; k++) {
+            double expected = elementAt(ref->data, ref->element, k);
+            double actual = elementAt(working[i], ref->element, k);
+            if (!isfinite(actual) && isfinite(expected)) {
+                nonfinite++;
+                continue;
+            }
+            if (actual != expected) mismatches++;
+            double diff = fabs(actual - expected);
+            if (diff > maxAbs) maxAbs = diff;
+            if (expected != 0 && diff / fabs(expected) > maxRel) maxRel = diff / fabs(expected);
+        }
+        printf("%s{\"arg\": %u, \"elements\": %llu, \"maxAbsError\": %.6e, \"maxRelError\": %.6e, "
+               "\"mismatches\": %llu, \"nonfinite\": %llu}",
+               first ? "" : ", ", i, (unsigned long long)ref->value, maxAbs, maxRel, (unsigned long long)mismatches,
+               (unsigned long long)nonfinite);
+        first = 0;
+    }
+    printf("]}\n");
+}
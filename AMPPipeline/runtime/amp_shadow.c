@@ -0,0 +1,120 @@
+/*
+ * 影子值运行时，与 MixPrecision shadow-value pass 插桩后的程序一起链接。
+ * 影子内存是按地址直接映射的表，冲突时后写的覆盖先写的。每个槽同时记下写入时的程序值，
+ * 读出时程序值已不同（memcpy、libc、整数写入、复用的栈槽等未插桩代码改写过内存）
+ * 说明影子已失效，与读不到一样退回程序值。
+ * 程序退出时按变量把相对误差与 ULP 偏差写到 AMP_SHADOW_OUT（默认 amp_shadow.json），
+ * 按平均相对误差从大到小排列。
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AMP_SHADOW_ENV "AMP_SHADOW_OUT"
+#define AMP_SHADOW_DEFAULT "amp_shadow.json"
+#define AMP_SHADOW_TABLE_BITS 20
+#define AMP_SHADOW_MAX_VARS 4096
+
+struct AmpShadowSlot {
+    uintptr_t addr;
+    double value;
+    uint64_t program; /* 写入时程序值（扩展到 double）的位模式 */
+};
+
+struct AmpShadowStats {
+    unsigned long samples;
+    unsigned long nonfinite;
+    double maxRel, sumRel;
+    double maxUlp, sumUlp;
+};
+
+static struct AmpShadowSlot table[1u << AMP_SHADOW_TABLE_BITS];
+static struct AmpShadowStats stats[AMP_SHADOW_MAX_VARS];
+static const char *names[AMP_SHADOW_MAX_VARS];
+static int numVars;
+
+static inline struct AmpShadowSlot *slotOf(uintptr_t addr) {
+    uintptr_t key = (addr >> 1) ^ (addr >> (AMP_SHADOW_TABLE_BITS + 1));
+    return &table[key & ((1u << AMP_SHADOW_TABLE_BITS) - 1)];
+}
+
+static inline uint64_t bitsOf(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double __amp_shadow_load(const void *addr, double value) {
+    struct AmpShadowSlot *slot = slotOf((uintptr_t)addr);
+    if (slot->addr == (uintptr_t)addr && slot->program == bitsOf(value)) return slot->value;
+    return value;
+}
+
+void __amp_shadow_store(const void *addr, double shadow, double value) {
+    struct AmpShadowSlot *slot = slotOf((uintptr_t)addr);
+    slot->addr = (uintptr_t)addr;
+    slot->value = shadow;
+    slot->program = bitsOf(value);
+}
+
+void __amp_shadow_check(int id, double value, double shadow, int bits) {
+    if (id < 0 || id >= numVars) return;
+    struct AmpShadowStats *s = &stats[id];
+    s->samples++;
+    if (!isfinite(value) || !isfinite(shadow)) {
+        s->nonfinite++;
+        return;
+    }
+
+    double diff = fabs(value - shadow);
+    double rel = shadow != 0 ? diff / fabs(shadow) : (value != 0 ? 1.0 : 0.0);
+    /* 以降精类型在影子值处的 ULP 为单位 */
+    double ref = shadow != 0 ? shadow : value;
+    double ulp = ref != 0 ? diff / ldexp(1.0, ilogb(ref) - bits) : 0.0;
+
+    if (rel > s->maxRel) s->maxRel = rel;
+    if (ulp > s->maxUlp) s->maxUlp = ulp;
+    s->sumRel += rel;
+    s->sumUlp += ulp;
+}
+
+static double meanRel(int i) {
+    unsigned long n = stats[i].samples - stats[i].nonfinite;
+    return n ? stats[i].sumRel / n : 0.0;
+}
+
+static int byMeanRel(const void *a, const void *b) {
+    double x = meanRel(*(const int *)a), y = meanRel(*(const int *)b);
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static void report(void) {
+    int order[AMP_SHADOW_MAX_VARS];
+    for (int i = 0; i < numVars; i++) order[i] = i;
+    qsort(order, numVars, sizeof(int), byMeanRel);
+
+    const char *path = getenv(AMP_SHADOW_ENV);
+    FILE *out = fopen(path && *path ? path : AMP_SHADOW_DEFAULT, "w");
+    if (!out) return;
+    fprintf(out, "{\"variables\": [");
+    for (int k = 0; k < numVars; k++) {
+        int i = order[k];
+        unsigned long n = stats[i].samples - stats[i].nonfinite;
+        fprintf(out,
+                "%s\n  {\"id\": \"%s\", \"samples\": %lu, \"nonfinite\": %lu, \"maxRelError\": %.6e, "
+                "\"meanRelError\": %.6e, \"maxUlp\": %.3f, \"meanUlp\": %.3f}",
+                k ? "," : "", names[i], stats[i].samples, stats[i].nonfinite, stats[i].maxRel, meanRel(i),
+                stats[i].maxUlp, n ? stats[i].sumUlp / n : 0.0);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+}
+
+int __amp_shadow_register(const char *const *ids, int count) {
+    if (numVars == 0) atexit(report);
+    int base = numVars;
+    for (int i = 0; i < count && numVars < AMP_SHADOW_MAX_VARS; i++) names[numVars++] = ids[i];
+    return base;
+}
@@ -0,0 +1,111 @@
+/*
+ * 区域计时运行时，与 MixPrecision region-timing pass 插桩后的程序一起链接。
+ * 每个模块在全局构造函数中登记自己的计时表，程序退出时把各区域的累计时间与进入次数
+ * 写到 AMP_TIMING_OUT 指定的文件（默认 amp_timing.json）。
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define AMP_TIMING_ENV "AMP_TIMING_OUT"
+#define AMP_TIMING_DEFAULT "amp_timing.json"
+#define AMP_TIMING_MAX_MODULES 16
+
+/* 与 pass 生成的表布局一致：每项依次为累计计数器差值、进入次数 */
+struct AmpTimingEntry {
+    uint64_t ticks;
+    uint64_t calls;
+};
+
+struct AmpTimingModule {
+    struct AmpTimingEntry *table;
+    const char *const *ids;
+    const char *const *kinds;
+    int count;
+};
+
+static struct AmpTimingModule modules[AMP_TIMING_MAX_MODULES];
+static int numModules;
+static uint64_t startTicks;
+static uint64_t startNanos;
+
+/* 没有可用周期计数器的目标上 pass 直接调用该函数，单位为纳秒 */
+uint64_t __amp_timing_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t readCounter(void) {
+#if defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#elif defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return __amp_timing_now();
+#endif
+}
+
+/* aarch64 直接读 cntfrq_el0；x86 的 TSC 频率没有接口，用整个运行期间与单调时钟的比值估计 */
+static double counterHz(void) {
+#if defined(__aarch64__)
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return (double)freq;
+#elif defined(__x86_64__) || defined(__i386__)
+    uint64_t nanos = __amp_timing_now() - startNanos;
+    return nanos ? (double)(readCounter() - startTicks) * 1e9 / (double)nanos : 0.0;
+#else
+    return 1e9;
+#endif
+}
+
+static void writeString(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static void writeTimings(void) {
+    const char *path = getenv(AMP_TIMING_ENV);
+    FILE *out = fopen(path && *path ? path : AMP_TIMING_DEFAULT, "w");
+    if (!out) return;
+
+    double hz = counterHz();
+    fprintf(out, "{\n  \"counterHz\": %.17g,\n  \"regions\": [", hz);
+    const char *sep = "\n";
+    for (int m = 0; m < numModules; m++) {
+        for (int i = 0; i < modules[m].count; i++) {
+            struct AmpTimingEntry *entry = &modules[m].table[i];
+            fprintf(out, "%s    {\"id\": ", sep);
+            writeString(out, modules[m].ids[i]);
+            fprintf(out, ", \"kind\": ");
+            writeString(out, modules[m].kinds[i]);
+            fprintf(out, ", \"calls\": %llu, \"ticks\": %llu, \"seconds\": %.9g}",
+                    (unsigned long long)entry->calls, (unsigned long long)entry->ticks,
+                    hz > 0 ? (double)entry->ticks / hz : 0.0);
+            sep = ",\n";
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+}
+
+void __amp_timing_register(struct AmpTimingEntry *table, const char *const *ids, const char *const *kinds,
+                           int count) {
+    if (numModules == AMP_TIMING_MAX_MODULES) return;
+    if (numModules == 0) {
+        startTicks = readCounter();
+        startNanos = __amp_timing_now();
+        atexit(writeTimings);
+    }
+    modules[numModules++] = (struct AmpTimingModule){table, ids, kinds, count};
+}
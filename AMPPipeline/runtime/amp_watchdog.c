@@ -0,0 +1,87 @@
+/*
+ * 收敛看门狗运行时，与 MixPrecision convergence-watchdog pass 插桩后的程序一起链接。
+ * 进入循环前调用 __amp_watchdog_begin 重置状态（同一进程可多次求解，如 HPL-AI 的多个规模），
+ * 每次迭代末尾传入当前残差：连续 patience 次没有刷新最小值、残差为 Inf/NaN，
+ * 或自进入循环起超过 budget 秒时，把状态写到 stderr 和 AMP_WATCHDOG_OUT
+ * （默认 amp_watchdog.json），以 AMP_WATCHDOG_EXIT 退出。
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define AMP_WATCHDOG_EXIT 87
+#define AMP_WATCHDOG_ENV "AMP_WATCHDOG_OUT"
+#define AMP_WATCHDOG_DEFAULT "amp_watchdog.json"
+/* 与 MixPrecision/include/watchdog.hpp 中的 WatchdogMax 一致，pass 不会分配超出的编号 */
+#define AMP_WATCHDOG_MAX 16
+
+struct AmpWatchdog {
+    int started;
+    long iterations;
+    long stalled;
+    double best;
+    double startSeconds;
+};
+
+static struct AmpWatchdog watchdogs[AMP_WATCHDOG_MAX];
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void writeStatus(FILE *out, const char *name, const char *reason, const struct AmpWatchdog *w,
+                        double residual, double seconds) {
+    fprintf(out,
+            "{\"watchdog\": \"%s\", \"reason\": \"%s\", \"iterations\": %ld, \"best\": %.17g, "
+            "\"last\": %.17g, \"seconds\": %.6f}\n",
+            name, reason, w->iterations, w->best, isfinite(residual) ? residual : -1.0, seconds);
+}
+
+static void trip(const char *name, const char *reason, const struct AmpWatchdog *w, double residual) {
+    double seconds = nowSeconds() - w->startSeconds;
+
+    fprintf(stderr, "[amp] watchdog ");
+    writeStatus(stderr, name, reason, w, residual, seconds);
+    fflush(stderr);
+
+    const char *path = getenv(AMP_WATCHDOG_ENV);
+    FILE *out = fopen(path && *path ? path : AMP_WATCHDOG_DEFAULT, "w");
+    if (out) {
+        writeStatus(out, name, reason, w, residual, seconds);
+        fclose(out);
+    }
+    _exit(AMP_WATCHDOG_EXIT);
+}
+
+void __amp_watchdog_begin(int id) {
+    if (id < 0 || id >= AMP_WATCHDOG_MAX) return;
+    struct AmpWatchdog *w = &watchdogs[id];
+    w->started = 1;
+    w->iterations = 0;
+    w->stalled = 0;
+    w->best = INFINITY;
+    w->startSeconds = nowSeconds();
+}
+
+void __amp_watchdog_step(int id, double residual, const char *name, int patience, double budget) {
+    if (id < 0 || id >= AMP_WATCHDOG_MAX) return;
+    struct AmpWatchdog *w = &watchdogs[id];
+
+    if (!w->started) __amp_watchdog_begin(id);
+    w->iterations++;
+
+    if (!isfinite(residual)) trip(name, "nonfinite", w, residual);
+
+    if (residual < w->best) {
+        w->best = residual;
+        w->stalled = 0;
+    } else if (patience > 0 && ++w->stalled >= patience) {
+        trip(name, "stalled", w, residual);
+    }
+
+    if (budget > 0 && nowSeconds() - w->startSeconds > budget) trip(name, "timeout", w, residual);
+}
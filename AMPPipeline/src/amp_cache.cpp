@@ -0,0 +1,71 @@
+// amp-cache：评估流水线共享的构建产物缓存
+//
+//   amp-cache key -module hpllink.ll -config config.json -toolchain-file libMix.so
+//   amp-cache get -dir cache <key> exec ./hpl_exec_optimized     # 命中返回 0，未命中返回 1
+//   amp-cache put -dir cache -max-size 4096 <key> exec ./hpl_exec_optimized
+//   amp-cache prune -dir cache -max-size 4096
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <fstream>
+#include <iostream>
+
+#include "artifact_cache.hpp"
+
+using namespace llvm;
+
+static cl::opt<string> Action(cl::Positional, cl::Required, cl::desc("<key|get|put|prune>"));
+static cl::list<string> Args(cl::Positional, cl::ZeroOrMore, cl::desc("<key> <artifact> <path>"));
+static cl::opt<string> CacheDir("dir", cl::desc("Cache directory"), cl::init("amp_cache"));
+static cl::opt<uint64_t> MaxSize("max-size", cl::desc("Cache size limit in MiB, 0 for no limit"), cl::init(0));
+static cl::opt<string> ModulePath("module", cl::desc("Base module (key)"));
+static cl::opt<string> ConfigPath("config", cl::desc("Precision config JSON (key)"));
+static cl::opt<string> Toolchain("toolchain", cl::desc("Toolchain version string (key)"), cl::init(""));
+static cl::list<string> ToolchainFiles(
+    "toolchain-file", cl::desc("File whose content identifies the toolchain, e.g. the pass plugin (key, repeatable)"));
+
+static int fail(const string &message) {
+    errs() << "\033[31m[amp-cache] " << message << "\033[0m\n";
+    return 2;
+}
+
+static int computeKey() {
+    if (ModulePath.empty() || ConfigPath.empty()) return fail("key needs -module and -config");
+    string moduleHash = ArtifactCache::hashFile(ModulePath);
+    if (moduleHash.empty()) return fail("cannot read " + ModulePath);
+
+    std::ifstream in(ConfigPath);
+    nlohmann::json config;
+    try {
+        in >> config;
+    } catch (const std::exception &e) {
+        return fail("bad config " + ConfigPath + ": " + e.what());
+    }
+
+    string toolchain = Toolchain;
+    for (auto &path : ToolchainFiles) {
+        string hash = ArtifactCache::hashFile(path);
+        if (hash.empty()) return fail("cannot read " + path);
+        toolchain += "\n" + hash;
+    }
+    cout << ArtifactCache::makeKey(moduleHash, ArtifactCache::hashConfig(config), toolchain) << endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "content-addressed artifact cache\n");
+
+    if (Action == "key") return computeKey();
+
+    ArtifactCache cache(CacheDir, MaxSize * 1024 * 1024);
+    if (Action == "get" || Action == "put") {
+        if (Args.size() != 3) return fail(Action + " expects <key> <artifact> <path>");
+        if (Action == "get") return cache.get(Args[0], Args[1], Args[2]) ? 0 : 1;
+        return cache.put(Args[0], Args[1], Args[2]) ? 0 : fail("cannot store " + Args[2]);
+    }
+    if (Action == "prune") {
+        errs() << "\033[32m[amp-cache] removed " << cache.prune() << " entr(ies)\033[0m\n";
+        return 0;
+    }
+    return fail("unknown action " + Action);
+}
@@ -0,0 +1,272 @@
+// amp-eval：批量评估一代个体，降精、-O2、llc 与链接、运行四个阶段流水并行
+//
+//   amp-eval -libmix libMix.so -module hpllink.ll -baseline config.json -j 16 population.json > results.jsonl
+//
+// population.json 是 JSON 数组或每行一个 JSON，元素为 {"id": ..., "config": {...}} 或直接是配置。
+// 每个个体在 <work-dir>/individual_<id> 下完成与 FitnessEvaluator 相同的流程，完成一个就向 stdout 输出一行结果。
+// 各阶段有独立的工作线程（-j-transform 等，缺省各占 -j 的四分之一），阶段之间以有界队列相连，
+// 某个个体在运行时下一个个体已在编译，qemu 与 opt 不再轮流空闲。
+//
+// 低噪声测量：-isolate 给每个运行线程独占的 CPU（默认取允许集合末尾的 -cpus-per-run 个），编译阶段的子进程
+// 绑到其余 CPU，并行评估时不再互相抢占；-perf-counters 记录 cycles/instructions/L1D 与 LLC 缺失，
+// 不可用时仍有 CPU 时间；-no-aslr 关闭地址随机化；-fixed-frequency 在有权限时固定调频策略并关闭睿频。
+//
+// 重复竞赛：-race 时每个个体先运行 -race-min 次，之后每次运行后比较得分（final_marks）的置信区间与当前最优
+// （-incumbent 给定，或本批中已完成的最好个体）的区间，分开即停止，最多 -race-max 次。明显更差的配置一次即淘汰，
+// 接近最优的配置才得到足够的重复。
+#include <unistd.h>
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "eval_pipeline.hpp"
+#include "measurement.hpp"
+
+using namespace llvm;
+using nlohmann::json;
+
+static cl::opt<string> Population(cl::Positional, cl::desc("<population.json>"), cl::init("-"));
+static cl::opt<string> Libmix("libmix", cl::Required, cl::desc("MixPrecision pass plugin (libMix.so)"));
+static cl::opt<string> Module("module", cl::Required, cl::desc("Baseline module (hpllink.ll)"));
+static cl::opt<string> Baseline("baseline", cl::Required, cl::desc("Baseline config the conversion steps start from"));
+static cl::opt<string> WorkDir("work-dir", cl::init("amp_eval"), cl::desc("Directory for individual_<id> outputs"));
+static cl::opt<string> Opt("opt", cl::init("opt"), cl::desc("opt executable"));
+static cl::opt<string> Llc("llc", cl::init("llc"), cl::desc("llc executable"));
+static cl::opt<string> Clang("clang", cl::init("clang"), cl::desc("clang executable used for linking"));
+static cl::opt<string> CFlags("cflags", cl::init("--target=aarch64-linux-gnu -march=armv8.2-a+fp16 -O2 -static"),
+                              cl::desc("Link flags, space separated"));
+static cl::list<string> Link("link", cl::desc("Extra link input such as an instrumentation runtime (repeatable)"));
+static cl::opt<string> Runner("runner", cl::init("qemu-aarch64 -L /usr/aarch64-linux-gnu"),
+                              cl::desc("Launcher of the executable, space separated, empty to run it directly"));
+static cl::opt<string> RunArgs("run-args", cl::init("5 300 1600"), cl::desc("Arguments of the executable"));
+static cl::opt<unsigned> TestNum("test-num", cl::init(1), cl::desc("Runs per individual, the last one is scored"));
+static cl::list<string> PlArgs("pl-arg", cl::desc("Extra argument for every pl step, {dir}/{step} are expanded"));
+static cl::list<string> LastPlArgs("last-pl-arg", cl::desc("Extra argument for the last pl step only"));
+static cl::list<string> O2Passes("o2-pass", cl::desc("Pass placed before default<O2> (repeatable)"));
+static cl::list<string> O2Args("o2-arg", cl::desc("Extra argument for the -O2 opt run, {dir} is expanded"));
+static cl::list<double> BaselineGflops("baseline-gflops", cl::CommaSeparated,
+                                       cl::desc("Baseline min,mean,max Gflops of the fitness formula"));
+static cl::opt<unsigned> Jobs("j", cl::init(std::max(1u, std::thread::hardware_concurrency())),
+                              cl::desc("Total worker threads, split evenly across stages"));
+static cl::opt<unsigned> JobsTransform("j-transform", cl::init(0), cl::desc("Workers for pl steps"));
+static cl::opt<unsigned> JobsOptimize("j-optimize", cl::init(0), cl::desc("Workers for -O2"));
+static cl::opt<unsigned> JobsCodegen("j-codegen", cl::init(0), cl::desc("Workers for llc and linking"));
+static cl::opt<unsigned> JobsExecute("j-execute", cl::init(0), cl::desc("Workers running the executables"));
+static cl::opt<unsigned> QueueDepth("queue-depth", cl::init(0),
+                                    cl::desc("Capacity of each inter-stage queue, 0 for twice the consumer count"));
+static cl::opt<bool> Isolate("isolate", cl::desc("Pin every run worker to dedicated CPUs, builds to the rest"));
+static cl::opt<string> RunCpus("run-cpus", cl::desc("CPUs reserved for runs, e.g. 12-15 (implies -isolate)"));
+static cl::opt<unsigned> CpusPerRun("cpus-per-run", cl::init(1), cl::desc("Dedicated CPUs per run worker"));
+static cl::opt<bool> PerfCountersOpt("perf-counters", cl::desc("Record hardware counters of every run"));
+static cl::opt<bool> NoASLR("no-aslr", cl::desc("Disable address space randomization of runs"));
+static cl::opt<bool> FixedFrequency("fixed-frequency",
+                                    cl::desc("Use the performance governor and disable turbo where permitted"));
+
+static cl::opt<bool> Race("race", cl::desc("Repeat runs until the score interval separates from the incumbent"));
+static cl::opt<unsigned> RaceMin("race-min", cl::init(1), cl::desc("Runs before the first racing decision"));
+static cl::opt<unsigned> RaceMax("race-max", cl::init(5), cl::desc("Maximum runs per individual when racing"));
+static cl::opt<double> RaceConfidence("race-confidence", cl::init(0.95), cl::desc("Two-sided confidence level"));
+static cl::opt<double> RaceNoise("race-noise", cl::init(0.02),
+                                 cl::desc("Prior relative standard deviation of one run's score"));
+static cl::opt<double> Incumbent("incumbent", cl::init(NAN), cl::desc("Score (final_marks) of the best config so far"));
+
+static int fail(const string &message) {
+    errs() << "\033[31m[amp-eval] " << message << "\033[0m\n";
+    return 1;
+}
+
+static vector<string> splitArgs(const string &text) {
+    vector<string> args;
+    istringstream in(text);
+    for (string arg; in >> arg;) args.push_back(arg);
+    return args;
+}
+
+static bool readJSON(const string &path, json &value) {
+    std::ifstream in(path);
+    if (!in) return false;
+    value = json::parse(in, nullptr, false);
+    return !value.is_discarded();
+}
+
+// JSON 数组或 JSON lines
+static bool readPopulation(std::istream &in, vector<Individual> &individuals) {
+    string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    vector<json> items;
+    json whole = json::parse(text, nullptr, false);
+    if (!whole.is_discarded() && whole.is_array()) {
+        items.assign(whole.begin(), whole.end());
+    } else {
+        istringstream lines(text);
+        for (string line; std::getline(lines, line);) {
+            if (line.find_first_not_of(" \t\r") == string::npos) continue;
+            json item = json::parse(line, nullptr, false);
+            if (item.is_discarded()) return false;
+            items.push_back(std::move(item));
+        }
+    }
+    for (auto &item : items) {
+        Individual individual;
+        individual.index = individuals.size();
+        if (item.contains("config")) {
+            individual.config = item["config"];
+            individual.id = item.contains("id") ? (item["id"].is_string() ? item["id"].get<string>() : item["id"].dump())
+                                                : to_string(individual.index);
+        } else {
+            individual.config = item;
+            individual.id = to_string(individual.index);
+        }
+        individuals.push_back(std::move(individual));
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "pipelined batch evaluator of precision configs\n");
+
+    EvalOptions options;
+    options.opt = Opt;
+    options.llc = Llc;
+    options.clang = Clang;
+    options.libmix = Libmix;
+    options.module = Module;
+    options.plArgs.assign(PlArgs.begin(), PlArgs.end());
+    options.lastPlArgs.assign(LastPlArgs.begin(), LastPlArgs.end());
+    options.o2Passes.assign(O2Passes.begin(), O2Passes.end());
+    options.o2Args.assign(O2Args.begin(), O2Args.end());
+    options.cflags = splitArgs(CFlags);
+    options.linkInputs.assign(Link.begin(), Link.end());
+    options.runner = splitArgs(Runner);
+    options.runArgs = splitArgs(RunArgs);
+    options.testNum = TestNum;
+    options.race.enabled = Race;
+    options.race.minRuns = RaceMin;
+    options.race.maxRuns = RaceMax;
+    options.race.confidence = RaceConfidence;
+    options.race.noise = RaceNoise;
+    options.race.incumbent = Incumbent;
+    if (Race && (RaceConfidence <= 0 || RaceConfidence >= 1)) return fail("-race-confidence must be in (0, 1)");
+    options.workDir = WorkDir;
+    if (!BaselineGflops.empty()) {
+        if (BaselineGflops.size() != 3) return fail("-baseline-gflops takes min,mean,max");
+        for (int i = 0; i < 3; i++) options.baselineGflops[i] = BaselineGflops[i];
+    }
+    if (!readJSON(Baseline, options.baseline)) return fail("cannot read baseline config " + Baseline);
+
+    // 子进程在个体目录下运行，路径一律转为绝对路径
+    for (string *path : {&options.libmix, &options.module, &options.workDir}) {
+        SmallString<256> absolute(*path);
+        sys::fs::make_absolute(absolute);
+        *path = string(absolute);
+    }
+    for (auto &input : options.linkInputs) {
+        if (!sys::fs::exists(input)) continue;
+        SmallString<256> absolute(input);
+        sys::fs::make_absolute(absolute);
+        input = string(absolute);
+    }
+
+    vector<Individual> individuals;
+    bool parsed;
+    if (Population == "-") {
+        parsed = readPopulation(std::cin, individuals);
+    } else {
+        std::ifstream in(Population.getValue());
+        if (!in) return fail("cannot read " + Population);
+        parsed = readPopulation(in, individuals);
+    }
+    if (!parsed) return fail("malformed population " + Population);
+
+    for (auto &individual : individuals) {
+        individual.dir = options.workDir + "/individual_" + individual.id;
+        if (auto ec = sys::fs::create_directories(individual.dir)) {
+            return fail("cannot create " + individual.dir + ": " + ec.message());
+        }
+    }
+
+    unsigned share = std::max(1u, Jobs / 4);
+    EvalPipeline::StageJobs jobs;
+    jobs.transform = JobsTransform ? JobsTransform : share;
+    jobs.optimize = JobsOptimize ? JobsOptimize : share;
+    jobs.codegen = JobsCodegen ? JobsCodegen : share;
+    jobs.execute = JobsExecute ? JobsExecute : share;
+    size_t depth = QueueDepth ? QueueDepth : 2 * std::max({jobs.transform, jobs.optimize, jobs.codegen, jobs.execute});
+
+    vector<int> allowed = allowedCpus(), runCpus;
+    if (Isolate || !RunCpus.empty()) {
+        if (!RunCpus.empty()) {
+            if (!parseCpuList(RunCpus, runCpus)) return fail("malformed -run-cpus " + RunCpus);
+        } else {
+            // 低编号的 CPU 通常承担更多中断，运行用的 CPU 从末尾取
+            size_t need = size_t(jobs.execute) * std::max(1u, (unsigned)CpusPerRun);
+            if (allowed.size() <= need) {
+                return fail("-isolate needs more than " + to_string(need) + " CPUs, only " +
+                            to_string(allowed.size()) + " available");
+            }
+            runCpus.assign(allowed.end() - need, allowed.end());
+        }
+        if (runCpus.size() < jobs.execute) return fail("fewer run CPUs than -j-execute workers");
+        size_t per = runCpus.size() / jobs.execute;
+        options.execute.resize(jobs.execute);
+        for (unsigned k = 0; k < jobs.execute; k++) {
+            options.execute[k].cpus.assign(runCpus.begin() + k * per, runCpus.begin() + (k + 1) * per);
+        }
+        for (int cpu : allowed) {
+            if (std::find(runCpus.begin(), runCpus.end(), cpu) == runCpus.end()) options.build.cpus.push_back(cpu);
+        }
+        if (options.build.cpus.empty()) {
+            errs() << "\033[31m[amp-eval] no CPU left for builds, they share the run CPUs\033[0m\n";
+        }
+    }
+    if ((PerfCountersOpt || NoASLR) && options.execute.empty()) options.execute.resize(1);
+    for (auto &isolation : options.execute) {
+        isolation.perfCounters = PerfCountersOpt;
+        isolation.disableASLR = NoASLR;
+    }
+    if (PerfCountersOpt) {
+        PerfCounters probe;
+        if (!probe.open(getpid(), false)) {
+            errs() << "\033[31m[amp-eval] perf_event_open unavailable (see /proc/sys/kernel/perf_event_paranoid), "
+                      "reporting CPU time only\033[0m\n";
+        }
+    }
+    unique_ptr<CpuFrequencyGuard> frequencyGuard;
+    if (FixedFrequency) {
+        frequencyGuard = std::make_unique<CpuFrequencyGuard>(runCpus.empty() ? allowed : runCpus);
+        errs() << "\033[32m[amp-eval] fixed frequency: " << frequencyGuard->applied().size()
+               << " sysfs settings changed\033[0m\n";
+    }
+
+    errs() << "\033[32m[amp-eval] " << individuals.size() << " individuals, workers transform=" << jobs.transform
+           << " optimize=" << jobs.optimize << " codegen=" << jobs.codegen << " execute=" << jobs.execute
+           << "\033[0m\n";
+
+    EvalPipeline pipeline(options, jobs, depth);
+    unsigned done = 0, failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    pipeline.run(individuals, [&](const Individual &individual) {
+        done++;
+        if (!individual.failedStage.empty()) failed++;
+        cout << individual.toJSON().dump() << endl;
+    });
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    // 忙碌时间之和远大于墙钟时间说明阶段确实重叠
+    errs() << "\033[32m[amp-eval] " << done << " done, " << failed << " failed in " << format("%.2f", wall.count())
+           << "s, stage busy:";
+    for (auto &[stage, seconds] : pipeline.busySeconds()) errs() << " " << stage << "=" << format("%.2f", seconds) << "s";
+    errs() << "\033[0m\n";
+    return 0;
+}
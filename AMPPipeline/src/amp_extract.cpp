@@ -0,0 +1,67 @@
+// amp-extract：从完整模块中抽出单个内核，配合录制/回放做针对单个函数的快速评估
+//
+//   # 1. 在完整的 double 程序中录下 sgemm 第 3 次调用的参数与结果
+//   opt -load=libmix.so -load-pass-plugin=libmix.so -passes=record-call -record-function=sgemm -record-call=3
+//       '-record-extent=6:%7*%4:f32' '-record-extent=8:%9*%3:f32' '-record-extent=11:%12*%3:f32' hpllink.ll -S -o rec.ll
+//   （上面两行是同一条命令）
+//   clang rec.ll runtime/amp_replay.c -o rec && ./rec            # 写出 amp_record.bin
+//   # 2. 抽出 sgemm 及其被调函数，生成回放用的 main
+//   amp-extract hpllink.ll -func sgemm -harness -o sgemm.ll
+//   # 3. 对 sgemm.ll 按各个配置降精后与 runtime/amp_replay.c 链接运行，输出耗时与相对 double 结果的误差
+//   AMP_REPLAY_IN=amp_record.bin AMP_REPLAY_REPS=20 ./sgemm_replay
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "function_extractor.hpp"
+
+using namespace llvm;
+
+static cl::opt<string> Input(cl::Positional, cl::Required, cl::desc("<input .ll/.bc>"));
+static cl::list<string> Functions("func", cl::OneOrMore, cl::desc("Function to extract, may be repeated"));
+static cl::opt<string> Output("o", cl::desc("Output file"), cl::init("-"));
+static cl::opt<bool> NoCallees("no-callees", cl::desc("Do not extract the functions called by the selected ones"));
+static cl::opt<bool> Harness("harness", cl::desc("Add a main that replays a recorded call of the first -func"));
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "function extractor and replay harness generator\n");
+
+    LLVMContext context;
+    SMDiagnostic diag;
+    unique_ptr<Module> M = parseIRFile(Input, diag, context);
+    if (!M) {
+        diag.print(argv[0], errs());
+        return 1;
+    }
+
+    FunctionExtractor extractor;
+    string error;
+    vector<string> roots(Functions.begin(), Functions.end());
+    if (!extractor.extract(*M, roots, !NoCallees, error) ||
+        (Harness && !extractor.addHarness(*M, roots.front(), error))) {
+        errs() << "\033[31m[amp-extract] " << error << "\033[0m\n";
+        return 1;
+    }
+    if (verifyModule(*M, &errs())) {
+        errs() << "\033[31m[amp-extract] extracted module is broken\033[0m\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    raw_fd_ostream out(Output, ec, sys::fs::OF_Text);
+    if (ec) {
+        errs() << "\033[31m[amp-extract] " << Output << ": " << ec.message() << "\033[0m\n";
+        return 1;
+    }
+    M->print(out, nullptr);
+
+    errs() << "\033[32m[amp-extract] " << extractor.kept().size() << " function(s) extracted\033[0m\n";
+    for (const string &name : extractor.unresolved()) {
+        errs() << "\033[31m[amp-extract] " << name << " is still referenced but was not extracted\033[0m\n";
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// amp-mca：对降精、-O2 之后的模块做静态吞吐估计，不需要运行程序
+//
+//   amp-mca hpllink_optimized.ll -functions sgemm,sgetrf -mcpu tsv110
+//
+// 输出 JSON：各最内层循环每次迭代的周期数、循环头块频率权重，以及加权总和。
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+
+#include "loop_throughput.hpp"
+
+using namespace llvm;
+
+static cl::opt<string> Input(cl::Positional, cl::Required, cl::desc("<input .ll/.bc>"));
+static cl::list<string> Functions("functions", cl::CommaSeparated, cl::desc("Functions to analyse, all by default"));
+// 鲲鹏 920 的核心为 TaiShan v110，LLVM 中有对应的调度模型
+static cl::opt<string> CPU("mcpu", cl::init("tsv110"), cl::desc("CPU whose scheduling model is used"));
+static cl::opt<string> MCA("mca", cl::init("llvm-mca"), cl::desc("llvm-mca executable"));
+
+int main(int argc, char **argv) {
+    InitializeAllTargetInfos();
+    InitializeAllTargets();
+    InitializeAllTargetMCs();
+    InitializeAllAsmPrinters();
+    InitializeAllAsmParsers();
+    cl::ParseCommandLineOptions(argc, argv, "static loop throughput estimate\n");
+
+    LLVMContext context;
+    SMDiagnostic diag;
+    unique_ptr<Module> M = parseIRFile(Input, diag, context);
+    if (!M) {
+        diag.print(argv[0], errs());
+        return 1;
+    }
+
+    LoopThroughput estimate(CPU, MCA);
+    string error;
+    if (!estimate.run(*M, set<string>(Functions.begin(), Functions.end()), error)) {
+        errs() << "\033[31m[amp-mca] " << error << "\033[0m\n";
+        return 1;
+    }
+
+    if (estimate.skipped()) {
+        errs() << "\033[33m[amp-mca] " << estimate.skipped()
+               << " loop(s) skipped, their markers are out of order after codegen\033[0m\n";
+    }
+
+    nlohmann::json loops = nlohmann::json::array();
+    for (auto &loop : estimate.loops()) {
+        loops.push_back({{"function", loop.function},
+                         {"line", loop.line},
+                         {"cyclesPerIteration", loop.cyclesPerIteration},
+                         {"weight", loop.weight}});
+    }
+    nlohmann::json result = {{"cpu", CPU.getValue()}, {"loops", loops}, {"weightedTotal", estimate.weightedTotal()},
+                             {"skippedLoops", estimate.skipped()}};
+    cout << result.dump(2) << endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+// amp-run：经由 fork server 反复运行被测程序，每次运行输出一行 JSON
+//
+//   amp-run -n 3 -timeout 60 -args "5 300 1600" -- qemu-aarch64 -L /usr/aarch64-linux-gnu ./hpl_exec_optimized
+//
+// 被测程序需经 MixPrecision 的 fork-server pass 处理并链接 AMPPipeline/runtime/amp_forkserver.c。
+// -cpus 把服务端（及每次运行）绑到给定 CPU，-perf-counters 为每次运行输出硬件计数，
+// -no-aslr 与 -fixed-frequency 进一步减小抖动，见 measurement.hpp。
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "fork_server_runner.hpp"
+#include "measurement.hpp"
+
+using namespace llvm;
+
+static cl::list<string> Command(cl::Positional, cl::OneOrMore,
+                                cl::desc("-- <launcher...> <binary>"));
+static cl::list<string> RunArgs("args", cl::desc("Arguments of one run, space separated (repeatable)"));
+static cl::opt<unsigned> Repeat("n", cl::desc("Runs per argument set"), cl::init(1));
+static cl::opt<double> Timeout("timeout", cl::desc("Per-run timeout in seconds, 0 for none"), cl::init(0));
+static cl::opt<double> StartTimeout("start-timeout", cl::desc("Handshake timeout in seconds"), cl::init(60));
+static cl::opt<string> WorkDir("C", cl::desc("Working directory of the binary"), cl::init("."));
+static cl::opt<string> Cpus("cpus", cl::desc("Pin the server and its runs to these CPUs, e.g. 3 or 2-3"));
+static cl::opt<bool> PerfCountersOpt("perf-counters", cl::desc("Report hardware counters of every run"));
+static cl::opt<bool> NoASLR("no-aslr", cl::desc("Disable address space randomization"));
+static cl::opt<bool> FixedFrequency("fixed-frequency",
+                                    cl::desc("Use the performance governor and disable turbo where permitted"));
+
+static vector<string> splitArgs(const string &text) {
+    vector<string> args;
+    istringstream in(text);
+    for (string arg; in >> arg;) args.push_back(arg);
+    return args;
+}
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "fork server benchmark runner\n");
+
+    vector<vector<string>> argSets;
+    for (auto &text : RunArgs) argSets.push_back(splitArgs(text));
+    if (argSets.empty()) argSets.emplace_back();
+
+    IsolationOptions isolation;
+    if (!Cpus.empty() && !parseCpuList(Cpus, isolation.cpus)) {
+        errs() << "\033[31m[amp-run] malformed -cpus " << Cpus << "\033[0m\n";
+        return 1;
+    }
+    isolation.perfCounters = PerfCountersOpt;
+    isolation.disableASLR = NoASLR;
+    unique_ptr<CpuFrequencyGuard> frequencyGuard;
+    if (FixedFrequency) {
+        frequencyGuard = std::make_unique<CpuFrequencyGuard>(isolation.cpus.empty() ? allowedCpus() : isolation.cpus);
+    }
+
+    ForkServer server(vector<string>(Command.begin(), Command.end()), WorkDir);
+    server.setIsolation(isolation);
+    string error;
+    if (!server.start(StartTimeout, error)) {
+        errs() << "\033[31m[amp-run] " << error << "\033[0m\n";
+        return 1;
+    }
+    if (PerfCountersOpt && !server.countersAvailable()) {
+        errs() << "\033[31m[amp-run] perf_event_open unavailable, no counters reported\033[0m\n";
+    }
+
+    int failed = 0;
+    for (auto &args : argSets) {
+        for (unsigned i = 0; i < Repeat; i++) {
+            RunResult result = server.run(args, Timeout);
+            nlohmann::json line = {
+                {"args", args},        {"repeat", i},
+                {"ok", result.ok},     {"timedOut", result.timedOut},
+                {"exitCode", result.exitCode}, {"signal", result.signal},
+                {"seconds", result.seconds},   {"stdout", result.output},
+                {"stderr", result.errorOutput},
+            };
+            if (!result.counters.empty()) line["counters"] = result.counters;
+            cout << line.dump() << endl;
+
+            if (!result.ok || result.timedOut || result.exitCode != 0) failed++;
+            if (!server.running()) {
+                errs() << "\033[31m[amp-run] fork server died\033[0m\n";
+                return 1;
+            }
+        }
+    }
+    return failed ? 2 : 0;
+}
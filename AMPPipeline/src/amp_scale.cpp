@@ -0,0 +1,191 @@
+// amp-scale：在合成模块上扫描 MixPrecision 各 pass 的耗时与内存，找出随规模超线性增长的热点
+//
+//   amp-scale -plugin libMix.so -functions 4,16,64 -locals 32,128 -uses 4 -config-fraction 0,0.5,1 -o scale.json
+//
+// 每组规模参数生成一个模块（clang -O0 风格，见 synthetic_module.hpp），每个配置比例生成一份配置，
+// 依次以独立的 opt 进程运行 create-config、parse-config 与 pl，记录墙钟时间（-repeat 次取最小）与峰值 RSS（wait4）；
+// pl 另外带 -amp-stats-out，取回新建/删除指令数与各阶段耗时。
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "process_runner.hpp"
+#include "synthetic_module.hpp"
+
+using namespace llvm;
+using nlohmann::json;
+
+static cl::opt<string> Plugin("plugin", cl::Required, cl::desc("MixPrecision pass plugin (libMix.so)"));
+static cl::opt<string> Opt("opt", cl::init("opt"), cl::desc("opt executable"));
+static cl::list<string> OptArgs("opt-arg", cl::desc("Extra argument for every opt run (repeatable)"));
+static cl::list<unsigned> Functions("functions", cl::CommaSeparated, cl::desc("Function counts to sweep"));
+static cl::list<unsigned> Locals("locals", cl::CommaSeparated, cl::desc("Local variables per function"));
+static cl::list<unsigned> PointerDepth("pointer-depth", cl::CommaSeparated, cl::desc("Pointer depth of the array argument"));
+static cl::list<unsigned> Uses("uses", cl::CommaSeparated, cl::desc("Read-modify-writes per local in the innermost loop"));
+static cl::list<unsigned> LoopDepth("loop-depth", cl::CommaSeparated, cl::desc("Loop nesting depth"));
+static cl::list<double> Fractions("config-fraction", cl::CommaSeparated,
+                                  cl::desc("Fraction of locals lowered to float in each config"));
+static cl::opt<bool> LowerArgs("lower-args", cl::desc("Also lower the array argument of every function"));
+static cl::list<string> Stages("stages", cl::CommaSeparated, cl::desc("Passes to run (create-config,parse-config,pl)"));
+static cl::opt<unsigned> Repeat("repeat", cl::init(1), cl::desc("Runs per measurement, the fastest is reported"));
+static cl::opt<string> WorkDir("work-dir", cl::init("amp_scale"), cl::desc("Directory for modules, configs and logs"));
+static cl::opt<string> Output("o", cl::init("-"), cl::desc("Output JSON file"));
+
+static int fail(const string &message) {
+    errs() << "\033[31m[amp-scale] " << message << "\033[0m\n";
+    return 1;
+}
+
+static json measure(const vector<string> &command, const string &log) {
+    ProcessResult best;
+    sys::fs::remove(log);
+    for (unsigned i = 0; i < std::max(1u, (unsigned)Repeat); i++) {
+        ProcessResult run = runProcess(command, "", log);
+        if (run.exitCode != 0) {
+            best = run;
+            break;
+        }
+        if (i == 0 || run.seconds < best.seconds) best.seconds = run.seconds;
+        best.exitCode = 0;
+        best.peakRSSKiB = std::max(best.peakRSSKiB, run.peakRSSKiB);
+    }
+    json result = {{"seconds", best.seconds}, {"peakRSSKiB", best.peakRSSKiB}, {"exitCode", best.exitCode}};
+    if (best.exitCode != 0) result["log"] = log;
+    return result;
+}
+
+static vector<string> optCommand(const string &passes) {
+    vector<string> command = {Opt, "-load=" + Plugin, "-load-pass-plugin=" + Plugin, "-passes=" + passes,
+                              "-disable-output"};
+    command.insert(command.end(), OptArgs.begin(), OptArgs.end());
+    return command;
+}
+
+static bool writeFile(const string &path, const string &content) {
+    std::ofstream out(path);
+    out << content;
+    return bool(out);
+}
+
+// pl 的 -amp-stats-out：计数器名形如 change-precision.NumInstsCreated
+static void mergePassStats(json &stage, const string &statsPath) {
+    std::ifstream in(statsPath);
+    json stats = json::parse(in, nullptr, false);
+    if (!stats.is_object()) return;
+    json &counters = stats["statistics"];
+    auto counter = [&](const char *name) -> uint64_t {
+        return counters.is_object() && counters.contains(name) ? counters[name].get<uint64_t>() : 0;
+    };
+    stage["instsCreated"] = counter("change-precision.NumInstsCreated");
+    stage["instsErased"] = counter("change-precision.NumInstsErased");
+    stage["variablesChanged"] = counter("change-precision.NumVariablesChanged");
+    stage["phases"] = stats["phases"];
+}
+
+static vector<unsigned> orDefault(const cl::list<unsigned> &values, unsigned fallback) {
+    return values.empty() ? vector<unsigned>{fallback} : vector<unsigned>(values.begin(), values.end());
+}
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "MixPrecision pass scalability benchmark\n");
+
+    if (auto ec = sys::fs::create_directories(WorkDir)) return fail("cannot create " + WorkDir + ": " + ec.message());
+    // create-config 必须能读到这几份过滤列表
+    string excludePath = WorkDir + "/exclude.txt", globalsPath = WorkDir + "/include_global.txt";
+    if (!writeFile(excludePath, "") || !writeFile(globalsPath, "")) return fail("cannot write filter lists");
+
+    vector<double> fractions(Fractions.begin(), Fractions.end());
+    if (fractions.empty()) fractions = {0, 0.25, 0.5, 1};
+    vector<string> stages(Stages.begin(), Stages.end());
+    if (stages.empty()) stages = {"create-config", "parse-config", "pl"};
+
+    json report = {{"plugin", Plugin.getValue()}, {"repeat", (unsigned)Repeat}, {"points", json::array()}};
+    for (unsigned functions : orDefault(Functions, 8))
+    for (unsigned locals : orDefault(Locals, 32))
+    for (unsigned depth : orDefault(PointerDepth, 1))
+    for (unsigned uses : orDefault(Uses, 4))
+    for (unsigned loops : orDefault(LoopDepth, 2)) {
+        SyntheticSpec spec;
+        spec.functions = std::max(1u, functions);
+        spec.locals = std::max(1u, locals);
+        spec.pointerDepth = std::max(1u, depth);
+        spec.uses = uses;
+        spec.loopDepth = loops;
+
+        string base = WorkDir + "/" + spec.name();
+        string modulePath = base + ".ll", includePath = base + ".include.txt";
+        uint64_t instructions = 0;
+        {
+            LLVMContext context;
+            auto M = buildSyntheticModule(context, spec);
+            for (auto &F : *M) instructions += F.getInstructionCount();
+            std::error_code ec;
+            raw_fd_ostream out(modulePath, ec, sys::fs::OF_Text);
+            if (ec) return fail("cannot write " + modulePath + ": " + ec.message());
+            M->print(out, nullptr);
+        }
+        string includeList;
+        for (unsigned id = 0; id < spec.functions; id++) includeList += "f" + to_string(id) + "\n";
+        if (!writeFile(includePath, includeList)) return fail("cannot write " + includePath);
+
+        // create-config 不读配置，每个模块只跑一次
+        json createConfig;
+        if (std::find(stages.begin(), stages.end(), "create-config") != stages.end()) {
+            auto command = optCommand("create-config");
+            command.insert(command.end(), {"-include=" + includePath, "-exclude=" + excludePath,
+                                           "-include_global_vars=" + globalsPath, "-filename=" + base + ".created.json",
+                                           modulePath});
+            createConfig = measure(command, base + ".create-config.log");
+        }
+
+        for (double fraction : fractions) {
+            json config = buildSyntheticConfig(spec, fraction, LowerArgs);
+            string tag = base + "_c" + to_string((unsigned)std::lround(fraction * 100));
+            string configPath = tag + ".json";
+            if (!writeFile(configPath, config.dump(2))) return fail("cannot write " + configPath);
+
+            json point = {{"spec", spec.toJSON()},
+                          {"moduleInstructions", instructions},
+                          {"configFraction", fraction},
+                          {"configEntries", config["localVar"].size()},
+                          {"stages", json::object()}};
+            for (auto &stage : stages) {
+                if (stage == "create-config") {
+                    point["stages"][stage] = createConfig;
+                    continue;
+                }
+                auto command = optCommand(stage);
+                command.insert(command.end(), {"-json-config=" + configPath, "-amp-quiet", modulePath});
+                string statsPath = tag + "." + stage + ".stats.json";
+                if (stage == "pl") command.push_back("-amp-stats-out=" + statsPath);
+                point["stages"][stage] = measure(command, tag + "." + stage + ".log");
+                if (stage == "pl") mergePassStats(point["stages"][stage], statsPath);
+            }
+
+            errs() << "\033[32m[amp-scale] " << spec.name() << " config " << format("%.2f", fraction) << ":";
+            for (auto &[stage, result] : point["stages"].items()) {
+                errs() << " " << stage << "=" << format("%.3f", result.value("seconds", 0.0)) << "s";
+            }
+            errs() << "\033[0m\n";
+            report["points"].push_back(std::move(point));
+        }
+    }
+
+    if (Output == "-") {
+        cout << report.dump(2) << endl;
+        return 0;
+    }
+    std::ofstream out(Output.getValue());
+    if (!out) return fail("cannot write " + Output);
+    out << report.dump(2) << endl;
+    return 0;
+}
@@ -0,0 +1,94 @@
+// amp-surrogate：用导出的 XGBoost JSON 模型给候选配置打分，在编译之前筛掉大部分候选
+//
+//   amp-surrogate -model surrogate.json candidates.jsonl -top 32
+//
+// 输入每行一个候选：{"id": ..., "features": {"<特征名>": 值, ...}}，或直接是特征对象。
+// 缺少的特征按 0 处理，与 GeneticOptimizer._train_native_surrogate 的训练输入一致。
+// 每个候选输出一行 {"id": ..., "score": ...}；
+// -top N 时只输出得分最低的 N 个（适应度越小越好）。
+// 遗传算法设置 GA_SA_AMP_SURROGATE 与 GA_SA_SURROGATE_TOP 后，每代用实测个体的 IR 特征（ir-features 的输出）
+// 与适应度训练模型，导出为 ir_surrogate_native.json，再用它按个体降精后模块的 IR 特征预筛。
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#include "xgboost_model.hpp"
+
+using namespace llvm;
+using json = nlohmann::json;
+
+static cl::opt<string> ModelPath("model", cl::Required, cl::desc("XGBoost JSON model"));
+static cl::opt<string> Input(cl::Positional, cl::init("-"), cl::desc("<candidates.jsonl>, - for stdin"));
+static cl::opt<unsigned> Top("top", cl::init(0), cl::desc("Only print the N lowest scores, 0 for all"));
+
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "native XGBoost surrogate scorer\n");
+    auto runStart = std::chrono::steady_clock::now();
+
+    XGBoostModel model;
+    string error;
+    if (!model.load(ModelPath, error)) {
+        errs() << "\033[31m[amp-surrogate] " << error << "\033[0m\n";
+        return 1;
+    }
+
+    std::ifstream file;
+    if (Input != "-") file.open(Input);
+    std::istream &in = Input == "-" ? std::cin : file;
+    if (!in) {
+        errs() << "\033[31m[amp-surrogate] cannot open " << Input << "\033[0m\n";
+        return 1;
+    }
+
+    // 先把全部候选读成按行存放的特征矩阵，再批量推理
+    size_t width = model.numFeatures();
+    vector<json> ids;
+    vector<float> rows;
+    string line;
+    for (size_t lineNo = 1; std::getline(in, line); lineNo++) {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        json candidate = json::parse(line, nullptr, /*allow_exceptions=*/false);
+        if (!candidate.is_object()) {
+            errs() << "\033[31m[amp-surrogate] line " << lineNo << " is not a JSON object\033[0m\n";
+            return 1;
+        }
+        const json &features = candidate.contains("features") ? candidate["features"] : candidate;
+        // ir-features 只写出模块中出现的特征，缺少的计数即为 0，与训练时的填充一致（不能当作缺失值走 default_left）
+        rows.resize(rows.size() + width, 0.0f);
+        float *row = &rows[rows.size() - width];
+        for (auto &[name, value] : features.items()) {
+            int index = model.featureIndex(name);
+            if (index >= 0 && value.is_number()) row[index] = value.get<float>();
+        }
+        ids.push_back(candidate.value("id", json(ids.size())));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    vector<double> scores;
+    model.predictBatch(rows.data(), ids.size(), scores);
+    double inferSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    vector<size_t> order(ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (Top) {
+        size_t keep = std::min<size_t>(Top, order.size());
+        std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                          [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+        order.resize(keep);
+    }
+    for (size_t i : order) cout << json{{"id", ids[i]}, {"score", scores[i]}}.dump() << "\n";
+
+    // 总耗时含模型加载与输入解析，推理只占其中一部分
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    errs() << "\033[32m[amp-surrogate] scored " << ids.size() << " candidate(s): inference "
+           << format("%.3f", inferSeconds * 1e3) << " ms, total " << format("%.3f", totalSeconds * 1e3)
+           << " ms\033[0m\n";
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA256.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include "artifact_cache.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+ArtifactCache::ArtifactCache(string root, uint64_t maxBytes) : root_(std::move(root)), maxBytes_(maxBytes) {
+    std::error_code ec;
+    fs::create_directories(fs::path(root_) / "objects", ec);
+    fs::create_directories(fs::path(root_) / "tmp", ec);
+}
+
+string ArtifactCache::hashString(const string &text) {
+    return llvm::toHex(llvm::SHA256::hash(llvm::arrayRefFromStringRef(text)), /*LowerCase=*/true);
+}
+
+string ArtifactCache::hashFile(const string &path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) return "";
+    return hashString((*buffer)->getBuffer().str());
+}
+
+string ArtifactCache::hashConfig(const json &config) {
+    json canonical = config;
+    if (canonical.is_object()) {
+        for (auto &[section, entries] : canonical.items()) {
+            if (!entries.is_array()) continue;
+            // json 对象按键有序存储，dump 结果与键的书写顺序无关
+            std::sort(entries.begin(), entries.end(),
+                      [](const json &a, const json &b) { return a.dump() < b.dump(); });
+        }
+    }
+    return hashString(canonical.dump());
+}
+
+string ArtifactCache::makeKey(const string &moduleHash, const string &configHash, const string &toolchain) {
+    return hashString(moduleHash + "\n" + configHash + "\n" + toolchain);
+}
+
+string ArtifactCache::entryDir(const string &key) const {
+    return (fs::path(root_) / "objects" / key.substr(0, 2) / key).string();
+}
+
+bool ArtifactCache::get(const string &key, const string &artifact, const string &dest) {
+    if (key.size() < 2) return false;
+    fs::path entry = entryDir(key);
+    std::error_code ec;
+    if (!fs::is_regular_file(entry / artifact, ec)) return false;
+
+    // 先复制到 dest 旁的临时文件再 rename，并发淘汰时不会留下半个文件
+    fs::path partial = dest + ".amp-cache." + std::to_string(getpid());
+    fs::copy_file(entry / artifact, partial, fs::copy_options::overwrite_existing, ec);
+    if (!ec) fs::rename(partial, dest, ec);
+    if (ec) {
+        fs::remove(partial, ec);
+        return false;
+    }
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool ArtifactCache::put(const string &key, const string &artifact, const string &src) {
+    if (key.size() < 2) return false;
+    fs::path entry = entryDir(key);
+    std::error_code ec;
+    if (fs::is_regular_file(entry / artifact, ec)) return true;
+
+    static std::atomic<unsigned> counter{0};
+    fs::path tmp = fs::path(root_) / "tmp" /
+                   (key + "." + artifact + "." + std::to_string(getpid()) + "." + std::to_string(counter++));
+    fs::create_directories(entry, ec);
+    fs::copy_file(src, tmp, fs::copy_options::overwrite_existing, ec);
+    // 同一文件系统内 rename 是原子的，读者只会看到完整的产物
+    if (!ec) fs::rename(tmp, entry / artifact, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    prune();
+    return true;
+}
+
+unsigned ArtifactCache::prune() {
+    if (!maxBytes_) return 0;
+
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        uint64_t bytes = 0;
+    };
+    vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (auto &shard : fs::directory_iterator(fs::path(root_) / "objects", ec)) {
+        for (auto &dir : fs::directory_iterator(shard.path(), ec)) {
+            Entry entry{dir.path(), fs::last_write_time(dir.path(), ec)};
+            for (auto &file : fs::directory_iterator(dir.path(), ec)) {
+                auto size = file.file_size(ec);
+                if (!ec) entry.bytes += size;
+            }
+            total += entry.bytes;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    unsigned removed = 0;
+    for (auto &entry : entries) {
+        if (total <= maxBytes_) break;
+        fs::remove_all(entry.path, ec);
+        total -= entry.bytes;
+        removed++;
+    }
+
+    // 写入中途被杀的进程会在 tmp 下留下文件，超过一小时的一并清掉
+    auto staleBefore = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (auto &file : fs::directory_iterator(fs::path(root_) / "tmp", ec)) {
+        if (fs::last_write_time(file.path(), ec) < staleBefore) fs::remove(file.path(), ec);
+    }
+    return removed;
+}
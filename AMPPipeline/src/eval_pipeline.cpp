@@ -0,0 +1,360 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+#include "eval_pipeline.hpp"
+#include "process_runner.hpp"
+
+using nlohmann::json;
+
+json Individual::toJSON() const {
+    json result = {{"index", index},
+                   {"id", id},
+                   {"fitness", std::isfinite(fitness) ? json(fitness) : json(nullptr)},
+                   {"passRate", passRate},
+                   {"minGflops", minGflops},
+                   {"meanGflops", meanGflops},
+                   {"maxGflops", maxGflops},
+                   {"stageSeconds", stageSeconds},
+                   {"dir", dir}};
+    if (runSeconds > 0) {
+        json run = {{"seconds", runSeconds}, {"cpuSeconds", runCpuSeconds}, {"cpus", runCpus}};
+        if (!counters.empty()) {
+            run["counters"] = counters;
+            if (counters.count("cycles") && counters.count("instructions") && counters.at("cycles") > 0) {
+                run["ipc"] = counters.at("instructions") / counters.at("cycles");
+            }
+        }
+        result["run"] = run;
+    }
+    if (!raceScores.empty()) {
+        result["race"] = {{"runs", raceScores.size()},  {"scores", raceScores},
+                          {"mean", raceInterval.mean},  {"low", raceInterval.low},
+                          {"high", raceInterval.high},  {"decision", raceDecision}};
+    }
+    if (!failedStage.empty()) {
+        result["failedStage"] = failedStage;
+        result["error"] = error;
+    }
+    return result;
+}
+
+static string varKey(const json &var) {
+    return var.value("function", "") + "." + var.value("name", "");
+}
+
+vector<json> conversionSteps(const json &current, const json &target) {
+    map<string, string> currentTypes;
+    for (auto &var : current.value("localVar", json::array())) currentTypes[varKey(var)] = var.value("type", "");
+
+    map<string, string> needed;  // 变量 -> 目标类型
+    for (auto &var : target.value("localVar", json::array())) {
+        auto it = currentTypes.find(varKey(var));
+        if (it != currentTypes.end() && it->second != var.value("type", "")) needed[it->first] = var.value("type", "");
+    }
+    if (needed.empty()) return {target};
+
+    vector<json> steps;
+    json step1 = current;
+    for (auto &var : step1["localVar"]) {
+        auto it = needed.find(varKey(var));
+        if (it == needed.end()) continue;
+        const string &from = var["type"].get_ref<const string &>(), &to = it->second;
+        bool lowering = (from == "double" && (to == "float" || to == "half")) ||
+                        (from == "double*" && (to == "float*" || to == "half*"));
+        if (!lowering) continue;
+        if (to == "half" || to == "half*") {
+            var["type"] = from.back() == '*' ? "float*" : "float";
+        } else {
+            var["type"] = to;
+        }
+    }
+    if (step1 != current) steps.push_back(step1);
+
+    json step2 = step1;
+    for (auto &var : step2["localVar"]) {
+        auto it = needed.find(varKey(var));
+        if (it != needed.end() && (it->second == "half" || it->second == "half*")) var["type"] = it->second;
+    }
+    if (step2 != step1) steps.push_back(step2);
+
+    if (steps.empty()) return {target};
+    return steps;
+}
+
+EvalPipeline::EvalPipeline(EvalOptions options, StageJobs jobs, size_t queueDepth)
+    : options_(std::move(options)), jobs_(jobs), queueDepth_(queueDepth) {
+    // 外部给定的最优只有一个值，按一次运行计区间
+    if (options_.race.enabled && std::isfinite(options_.race.incumbent)) {
+        RepetitionRace race(options_.race);
+        race.add(options_.race.incumbent);
+        incumbent_ = race.interval();
+        hasIncumbent_ = true;
+    }
+}
+
+bool EvalPipeline::step(Individual &individual, const vector<string> &command, const string &what) {
+    string log = individual.dir + "/pipeline.log";
+    ProcessResult result = runProcess(command, individual.dir, log, false, options_.build);
+    if (result.exitCode == 0) return true;
+    individual.error = what + " failed with exit code " + to_string(result.exitCode) + ", see " + log;
+    return false;
+}
+
+// 参数中的 {dir} 换成个体目录，{step} 换成降精步骤序号，便于每个个体写出自己的统计与备注
+static void replaceAll(string &text, const string &key, const string &value) {
+    for (size_t pos = 0; (pos = text.find(key, pos)) != string::npos; pos += value.size()) {
+        text.replace(pos, key.size(), value);
+    }
+}
+
+static string expandArg(string arg, const string &dir, const string &step) {
+    replaceAll(arg, "{dir}", dir);
+    replaceAll(arg, "{step}", step);
+    return arg;
+}
+
+static bool writeJSON(const string &path, const json &value) {
+    std::ofstream out(path);
+    out << value.dump(4) << "\n";
+    return bool(out);
+}
+
+bool EvalPipeline::transform(Individual &individual, unsigned) {
+    if (!writeJSON(individual.dir + "/config.json", individual.config)) {
+        individual.error = "cannot write to " + individual.dir;
+        return false;
+    }
+    vector<json> steps = conversionSteps(options_.baseline, individual.config);
+    string current = options_.module;
+    for (size_t i = 0; i < steps.size(); i++) {
+        string stepConfig = individual.dir + "/step_" + to_string(i) + "_config.json";
+        string output = individual.dir + "/step_" + to_string(i) + "_optimized.ll";
+        writeJSON(stepConfig, steps[i]);
+        vector<string> command = {options_.opt, "-load=" + options_.libmix, "-load-pass-plugin=" + options_.libmix,
+                                  current, "-S", "-o", output, "-passes=pl", "-json-config=" + stepConfig};
+        for (auto &arg : options_.plArgs) command.push_back(expandArg(arg, individual.dir, to_string(i)));
+        if (i + 1 == steps.size()) {
+            for (auto &arg : options_.lastPlArgs) command.push_back(expandArg(arg, individual.dir, to_string(i)));
+        }
+        if (!step(individual, command, "opt step " + to_string(i))) return false;
+        current = output;
+    }
+    individual.ir = current;
+    return true;
+}
+
+bool EvalPipeline::optimize(Individual &individual, unsigned) {
+    string pipeline;
+    for (auto &pass : options_.o2Passes) pipeline += pass + ",";
+    pipeline += "default<O2>";
+    string output = individual.dir + "/hpllink_optimized.ll";
+    vector<string> command = {options_.opt, "-load=" + options_.libmix, "-load-pass-plugin=" + options_.libmix,
+                              individual.ir, "-S", "-o", output, "-passes=" + pipeline};
+    for (auto &arg : options_.o2Args) command.push_back(expandArg(arg, individual.dir, ""));
+    if (!step(individual, command, "opt -O2")) return false;
+    individual.ir = output;
+    return true;
+}
+
+bool EvalPipeline::codegen(Individual &individual, unsigned) {
+    string assembly = individual.dir + "/hpllink_optimized.s";
+    if (!step(individual, {options_.llc, individual.ir, "-o", assembly}, "llc")) return false;
+
+    individual.executable = individual.dir + "/hpl_exec_optimized";
+    vector<string> command = {options_.clang};
+    command.insert(command.end(), options_.cflags.begin(), options_.cflags.end());
+    command.push_back(assembly);
+    command.insert(command.end(), options_.linkInputs.begin(), options_.linkInputs.end());
+    command.insert(command.end(), {"-o", individual.executable, "-lm"});
+    return step(individual, command, "clang");
+}
+
+bool EvalPipeline::execute(Individual &individual, unsigned worker) {
+    IsolationOptions isolation;
+    if (!options_.execute.empty()) isolation = options_.execute[worker % options_.execute.size()];
+    individual.runCpus = isolation.cpus;
+    vector<string> command = options_.runner;
+    command.push_back(individual.executable);
+    command.insert(command.end(), options_.runArgs.begin(), options_.runArgs.end());
+
+    const RaceOptions &raceOptions = options_.race;
+    RepetitionRace race(raceOptions);
+    RunMetrics total;
+    bool worse = false;
+    unsigned runs = raceOptions.enabled ? std::max(raceOptions.minRuns, raceOptions.maxRuns) : options_.testNum;
+    for (unsigned run = 0; run < std::max(1u, runs); run++) {
+        ProcessResult result = runProcess(command, individual.dir, individual.dir + "/run.log", true, isolation);
+        if (result.exitCode == AMP_NONFINITE_EXIT) {
+            individual.error = "produced a non-finite value";
+            return false;
+        }
+        if (result.exitCode == AMP_WATCHDOG_EXIT) {
+            individual.error = "stopped by convergence watchdog";
+            return false;
+        }
+        if (result.exitCode != 0) {
+            individual.error = "run " + to_string(run + 1) + " failed with exit code " + to_string(result.exitCode);
+            return false;
+        }
+        individual.output = std::move(result.output);
+        individual.runSeconds = result.seconds;
+        individual.runCpuSeconds = result.cpuSeconds;
+        individual.counters = std::move(result.counters);
+        if (!raceOptions.enabled) continue;
+
+        RunMetrics metrics = parseMetrics(individual.output);
+        total.passRate += metrics.passRate;
+        total.minGflops += metrics.minGflops;
+        total.meanGflops += metrics.meanGflops;
+        total.maxGflops += metrics.maxGflops;
+        race.add(-metrics.fitness);
+        RaceInterval incumbent;
+        bool hasIncumbent = currentIncumbent(incumbent);
+        RepetitionRace::Decision decision = race.decide(hasIncumbent ? &incumbent : nullptr);
+        individual.raceDecision = RepetitionRace::name(decision);
+        worse = decision == RepetitionRace::Decision::Worse;
+        if (decision != RepetitionRace::Decision::Continue) break;
+    }
+    std::ofstream(individual.dir + "/optimized_performance.txt") << individual.output;
+
+    if (!raceOptions.enabled) {
+        // 与 FitnessEvaluator 一致，以最后一次运行计分
+        RunMetrics metrics = parseMetrics(individual.output);
+        individual.passRate = metrics.passRate;
+        individual.minGflops = metrics.minGflops;
+        individual.meanGflops = metrics.meanGflops;
+        individual.maxGflops = metrics.maxGflops;
+        individual.fitness = metrics.fitness;
+        return true;
+    }
+
+    // 竞赛时各项取所有运行的平均
+    size_t n = race.scores().size();
+    individual.passRate = total.passRate / n;
+    individual.minGflops = total.minGflops / n;
+    individual.meanGflops = total.meanGflops / n;
+    individual.maxGflops = total.maxGflops / n;
+    individual.raceScores = race.scores();
+    individual.raceInterval = race.interval();
+    individual.fitness = -individual.raceInterval.mean;
+    offerIncumbent(individual.raceInterval, worse);
+    return true;
+}
+
+bool EvalPipeline::currentIncumbent(RaceInterval &incumbent) {
+    lock_guard<mutex> lock(raceMutex_);
+    incumbent = incumbent_;
+    return hasIncumbent_;
+}
+
+// 未被判为更差且均值更高的个体成为新的对手
+void EvalPipeline::offerIncumbent(const RaceInterval &interval, bool worse) {
+    lock_guard<mutex> lock(raceMutex_);
+    if (worse) return;
+    if (hasIncumbent_ && interval.mean <= incumbent_.mean) return;
+    incumbent_ = interval;
+    hasIncumbent_ = true;
+}
+
+// 与 performance_parser.py 相同：优先取汇总行，没有时由逐次的 Performance 行求 min/mean/max
+EvalPipeline::RunMetrics EvalPipeline::parseMetrics(const string &output) const {
+    static const std::regex passing(R"(Passing Rate:\s*([\d.]+)%)");
+    static const std::regex summary(
+        R"(Smallest/Average/Largest Performance\s*=\s*([\d.]+)\s*Gflops,\s*([\d.]+)\s*Gflops,\s*([\d.]+)\s*Gflops)");
+    static const std::regex single(R"(Performance\s*=\s*([\d.]+)\s*Gflops)");
+
+    RunMetrics metrics;
+    vector<double> performances;
+    std::istringstream lines(output);
+    string line;
+    std::smatch match;
+    while (std::getline(lines, line)) {
+        if (std::regex_search(line, match, passing)) metrics.passRate = std::stod(match[1]) / 100.0;
+        if (std::regex_search(line, match, summary)) {
+            metrics.minGflops = std::stod(match[1]);
+            metrics.meanGflops = std::stod(match[2]);
+            metrics.maxGflops = std::stod(match[3]);
+        } else if (std::regex_search(line, match, single)) {
+            performances.push_back(std::stod(match[1]));
+        }
+    }
+    if (metrics.minGflops == 0 && metrics.meanGflops == 0 && metrics.maxGflops == 0 && !performances.empty()) {
+        double sum = 0;
+        for (double p : performances) sum += p;
+        metrics.minGflops = *std::min_element(performances.begin(), performances.end());
+        metrics.maxGflops = *std::max_element(performances.begin(), performances.end());
+        metrics.meanGflops = sum / performances.size();
+    }
+
+    const double *T0 = options_.baselineGflops;
+    double flopsMarks = 100 *
+                        (0.6 * metrics.maxGflops / T0[2] + 0.3 * metrics.meanGflops / T0[1] +
+                         0.1 * metrics.minGflops / T0[0]) /
+                        2;
+    metrics.fitness = -(metrics.passRate * 100 * 0.4 + flopsMarks * 0.6);
+    return metrics;
+}
+
+void EvalPipeline::run(vector<Individual> &individuals, const function<void(const Individual &)> &onResult) {
+    struct Stage {
+        const char *name;
+        unsigned jobs;
+        bool (EvalPipeline::*work)(Individual &, unsigned);
+    };
+    const vector<Stage> stages = {{"transform", jobs_.transform, &EvalPipeline::transform},
+                                  {"optimize", jobs_.optimize, &EvalPipeline::optimize},
+                                  {"codegen", jobs_.codegen, &EvalPipeline::codegen},
+                                  {"execute", jobs_.execute, &EvalPipeline::execute}};
+
+    vector<unique_ptr<BoundedQueue<Individual *>>> queues;
+    vector<unique_ptr<std::atomic<unsigned>>> remaining;
+    for (auto &stage : stages) {
+        queues.push_back(std::make_unique<BoundedQueue<Individual *>>(queueDepth_));
+        remaining.push_back(std::make_unique<std::atomic<unsigned>>(std::max(1u, stage.jobs)));
+    }
+
+    mutex resultMutex;
+    auto finish = [&](Individual &individual) {
+        lock_guard<mutex> lock(resultMutex);
+        onResult(individual);
+    };
+
+    vector<std::thread> workers;
+    for (size_t s = 0; s < stages.size(); s++) {
+        for (unsigned j = 0; j < std::max(1u, stages[s].jobs); j++) {
+            workers.emplace_back([&, s, j] {
+                Individual *individual;
+                while (queues[s]->pop(individual)) {
+                    auto start = std::chrono::steady_clock::now();
+                    bool ok = (this->*stages[s].work)(*individual, j);
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    individual->stageSeconds[stages[s].name] = elapsed.count();
+                    {
+                        lock_guard<mutex> lock(busyMutex_);
+                        busy_[stages[s].name] += elapsed.count();
+                    }
+                    if (!ok) {
+                        individual->failedStage = stages[s].name;
+                        finish(*individual);
+                    } else if (s + 1 < stages.size()) {
+                        queues[s + 1]->push(individual);
+                    } else {
+                        finish(*individual);
+                    }
+                }
+                // 本阶段最后一个工作线程退出时，下一阶段不会再有新的个体
+                if (--*remaining[s] == 0 && s + 1 < stages.size()) queues[s + 1]->close();
+            });
+        }
+    }
+
+    for (auto &individual : individuals) queues[0]->push(&individual);
+    queues[0]->close();
+    for (auto &worker : workers) worker.join();
+}
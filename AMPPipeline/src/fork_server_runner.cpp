@@ -0,0 +1,223 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "forkserver_protocol.h"
+#include "fork_server_runner.hpp"
+
+static bool writeFull(int fd, const void *buf, size_t len) {
+    const char *p = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static string readAndRemove(const string &path) {
+    ifstream in(path);
+    stringstream buffer;
+    buffer << in.rdbuf();
+    unlink(path.c_str());
+    return buffer.str();
+}
+
+ForkServer::ForkServer(vector<string> command, string workDir)
+    : command_(std::move(command)), workDir_(std::move(workDir)) {}
+
+ForkServer::~ForkServer() { stop(); }
+
+bool ForkServer::start(double timeoutSec, string &error) {
+    if (command_.empty()) {
+        error = "empty command";
+        return false;
+    }
+    // 服务端 chdir 之后输出文件也按 workDir_ 拼路径，相对路径会变成 workDir/workDir，先统一成绝对路径
+    char *resolved = realpath(workDir_.c_str(), nullptr);
+    if (!resolved) {
+        error = workDir_ + ": " + strerror(errno);
+        return false;
+    }
+    workDir_ = resolved;
+    free(resolved);
+
+    int ctlPipe[2], stPipe[2], syncPipe[2] = {-1, -1};
+    if (pipe(ctlPipe) || pipe(stPipe) || (isolation_.perfCounters && pipe2(syncPipe, O_CLOEXEC))) {
+        error = string("pipe: ") + strerror(errno);
+        return false;
+    }
+
+    serverPid_ = fork();
+    if (serverPid_ < 0) {
+        error = string("fork: ") + strerror(errno);
+        return false;
+    }
+
+    if (serverPid_ == 0) {
+        // 服务端：把管道放到约定的 198/199 上，其余描述符不带入
+        if (dup2(ctlPipe[0], AMP_FORKSRV_CTL_FD) < 0 || dup2(stPipe[1], AMP_FORKSRV_ST_FD) < 0) _exit(127);
+        close(ctlPipe[0]); close(ctlPipe[1]);
+        close(stPipe[0]); close(stPipe[1]);
+        if (chdir(workDir_.c_str()) != 0) _exit(127);
+        setenv(AMP_FORKSRV_ENV, "1", 1);
+        applyIsolationInChild(isolation_);
+        if (isolation_.perfCounters) {
+            // 等父进程对本进程打开计数器，计数从 exec 开始并继承给每次运行
+            char ready;
+            while (read(syncPipe[0], &ready, 1) < 0 && errno == EINTR) {
+            }
+        }
+
+        vector<char *> argv;
+        for (auto &arg : command_) argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    // 服务端死掉后写控制管道会收到 SIGPIPE；忽略它，让 run() 走失败回退。
+    // 放在 fork 之后设置，避免 SIG_IGN 经 exec 继承给被测程序
+    signal(SIGPIPE, SIG_IGN);
+
+    if (isolation_.perfCounters) {
+        counters_.open(serverPid_, true);
+        while (write(syncPipe[1], "x", 1) < 0 && errno == EINTR) {
+        }
+        close(syncPipe[0]);
+        close(syncPipe[1]);
+    }
+
+    close(ctlPipe[0]);
+    close(stPipe[1]);
+    ctlFd_ = ctlPipe[1];
+    stFd_ = stPipe[0];
+    fcntl(ctlFd_, F_SETFD, FD_CLOEXEC);
+    fcntl(stFd_, F_SETFD, FD_CLOEXEC);
+
+    uint32_t hello = 0;
+    if (!readStatus(&hello, sizeof(hello), timeoutSec) || hello != AMP_FORKSRV_HELLO) {
+        error = "no handshake from fork server (binary not built with the fork-server pass?)";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool ForkServer::readStatus(void *buf, size_t len, double timeoutSec) {
+    using clock = chrono::steady_clock;
+    auto deadline = clock::now() + chrono::duration_cast<clock::duration>(chrono::duration<double>(timeoutSec));
+    char *p = static_cast<char *>(buf);
+
+    while (len > 0) {
+        int waitMs = -1;
+        if (timeoutSec > 0) {
+            auto left = chrono::duration_cast<chrono::milliseconds>(deadline - clock::now()).count();
+            if (left <= 0) return false;
+            waitMs = static_cast<int>(left);
+        }
+        pollfd pfd{stFd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, waitMs);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        ssize_t n = read(stFd_, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+RunResult ForkServer::run(const vector<string> &args, double timeoutSec) {
+    RunResult result;
+    if (!running()) return result;
+
+    // 子进程 stdout 与 stderr 写到临时文件，运行结束后读回
+    string prefix = workDir_ + "/.amp_run_" + to_string(getpid()) + "_" + to_string(runId_++);
+    string outPath = prefix + ".out", errPath = prefix + ".err";
+    string request = outPath;
+    request.push_back('\0');
+    request += errPath;
+    request.push_back('\0');
+    for (auto &arg : args) {
+        request += arg;
+        request.push_back('\0');
+    }
+    uint32_t len = request.size();
+    if (len > AMP_FORKSRV_MAX_REQUEST) return result;
+
+    // 子进程退出时计数并入服务端，服务端在两次请求之间阻塞在读管道上，前后之差即本次运行
+    map<string, double> before = counters_.read();
+    auto begin = chrono::steady_clock::now();
+    if (!writeFull(ctlFd_, &len, sizeof(len)) || !writeFull(ctlFd_, request.data(), len)) {
+        stop();
+        return result;
+    }
+
+    int32_t childPid = -1, status = 0;
+    if (!readStatus(&childPid, sizeof(childPid), timeoutSec)) {
+        stop();
+        return result;
+    }
+
+    if (!readStatus(&status, sizeof(status), timeoutSec)) {
+        // 超时：杀掉本次子进程，服务端随后仍会回报它的状态
+        result.timedOut = true;
+        kill(childPid, SIGKILL);
+        if (!readStatus(&status, sizeof(status), 5.0)) {
+            stop();
+            unlink(outPath.c_str());
+            unlink(errPath.c_str());
+            return result;
+        }
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    result.ok = true;
+    for (auto &[name, value] : counters_.read()) {
+        auto it = before.find(name);
+        result.counters[name] = value - (it == before.end() ? 0 : it->second);
+    }
+
+    if (WIFEXITED(status)) result.exitCode = WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) result.signal = WTERMSIG(status);
+
+    result.output = readAndRemove(outPath);
+    result.errorOutput = readAndRemove(errPath);
+    return result;
+}
+
+void ForkServer::stop() {
+    counters_.close();
+    if (ctlFd_ >= 0) close(ctlFd_);
+    if (stFd_ >= 0) close(stFd_);
+    ctlFd_ = stFd_ = -1;
+
+    if (serverPid_ > 0) {
+        // 关闭控制管道后服务端会自行退出，卡住时再强制结束
+        int status;
+        for (int i = 0; i < 50; i++) {
+            if (waitpid(serverPid_, &status, WNOHANG) != 0) {
+                serverPid_ = -1;
+                return;
+            }
+            usleep(10000);
+        }
+        kill(serverPid_, SIGKILL);
+        waitpid(serverPid_, &status, 0);
+        serverPid_ = -1;
+    }
+}
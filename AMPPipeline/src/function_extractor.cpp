@@ -0,0 +1,166 @@
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+
+#include "function_extractor.hpp"
+
+using namespace llvm;
+
+// 回放运行时，实现在 runtime/amp_replay.c
+static const char *ReplayOpen = "__amp_replay_open";
+static const char *ReplayReps = "__amp_replay_reps";
+static const char *ReplayReset = "__amp_replay_reset";
+static const char *ReplayInt = "__amp_replay_int";
+static const char *ReplayFP = "__amp_replay_fp";
+static const char *ReplayPtr = "__amp_replay_ptr";
+static const char *ReplayBegin = "__amp_replay_begin";
+static const char *ReplayEnd = "__amp_replay_end";
+static const char *ReplayReport = "__amp_replay_report";
+
+void FunctionExtractor::collect(Module &M, const vector<string> &roots, bool withCallees) {
+    vector<Function *> worklist;
+    for (const string &name : roots) {
+        Function *F = M.getFunction(name);
+        if (F && !F->isDeclaration() && kept_.insert(name).second) worklist.push_back(F);
+    }
+    while (withCallees && !worklist.empty()) {
+        Function *F = worklist.back();
+        worklist.pop_back();
+        for (auto &BB : *F) {
+            for (auto &inst : BB) {
+                auto *call = dyn_cast<CallBase>(&inst);
+                Function *callee = call ? call->getCalledFunction() : nullptr;
+                if (!callee || callee->isDeclaration()) continue;
+                if (kept_.insert(callee->getName().str()).second) worklist.push_back(callee);
+            }
+        }
+    }
+}
+
+// 反复删除没有使用者的全局值，直到不再变化；保留的函数不动
+void FunctionExtractor::removeDeadGlobals(Module &M, const set<string> &keep) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        vector<GlobalValue *> dead;
+        for (GlobalValue &GV : M.global_values()) {
+            if (keep.count(GV.getName().str())) continue;
+            GV.removeDeadConstantUsers();
+            if (GV.use_empty()) dead.push_back(&GV);
+        }
+        for (GlobalValue *GV : dead) GV->eraseFromParent();
+        changed = !dead.empty();
+    }
+}
+
+bool FunctionExtractor::extract(Module &M, const vector<string> &roots, bool withCallees, string &error) {
+    kept_.clear();
+    unresolved_.clear();
+    collect(M, roots, withCallees);
+    for (const string &name : roots) {
+        if (!kept_.count(name)) {
+            error = "function " + name + " not found or has no body";
+            return false;
+        }
+    }
+
+    for (const char *name : {"llvm.global_ctors", "llvm.global_dtors", "llvm.used", "llvm.compiler.used"}) {
+        if (GlobalVariable *GV = M.getGlobalVariable(name)) GV->eraseFromParent();
+    }
+
+    // 先把别名替换成被指向的对象，去掉函数体后别名可能失效
+    vector<GlobalAlias *> aliases;
+    for (GlobalAlias &alias : M.aliases()) aliases.push_back(&alias);
+    for (GlobalAlias *alias : aliases) {
+        alias->replaceAllUsesWith(alias->getAliasee());
+        alias->eraseFromParent();
+    }
+
+    vector<Function *> stripped;
+    for (Function &F : M) {
+        if (F.isDeclaration() || kept_.count(F.getName().str())) continue;
+        F.deleteBody();
+        F.setComdat(nullptr);
+        F.setLinkage(GlobalValue::ExternalLinkage);
+        stripped.push_back(&F);
+    }
+    removeDeadGlobals(M, kept_);
+
+    for (Function &F : M) {
+        if (F.isDeclaration() && !F.isIntrinsic() && std::find(stripped.begin(), stripped.end(), &F) != stripped.end()) {
+            unresolved_.push_back(F.getName().str());
+        }
+    }
+    return true;
+}
+
+bool FunctionExtractor::addHarness(Module &M, const string &function, string &error) {
+    Function *target = M.getFunction(function);
+    if (!target || target->isDeclaration()) {
+        error = "function " + function + " not found or has no body";
+        return false;
+    }
+    if (Function *main = M.getFunction("main")) {
+        if (!main->use_empty()) {
+            error = "main is still referenced by the extracted code";
+            return false;
+        }
+        main->eraseFromParent();
+    }
+    // 目标函数在回放程序中保持独立调用，不被内联进计时循环
+    target->setLinkage(GlobalValue::ExternalLinkage);
+    target->addFnAttr(Attribute::NoInline);
+
+    LLVMContext &context = M.getContext();
+    Type *voidTy = Type::getVoidTy(context);
+    Type *int32Ty = Type::getInt32Ty(context);
+    Type *int64Ty = Type::getInt64Ty(context);
+    Type *doubleTy = Type::getDoubleTy(context);
+    Type *ptrTy = PointerType::getUnqual(context);
+    auto declare = [&](const char *name, Type *result, ArrayRef<Type *> params) {
+        return M.getOrInsertFunction(name, FunctionType::get(result, params, false));
+    };
+
+    Function *main = Function::Create(FunctionType::get(int32Ty, false), GlobalValue::ExternalLinkage, "main", M);
+    BasicBlock *entry = BasicBlock::Create(context, "entry", main);
+    BasicBlock *loop = BasicBlock::Create(context, "loop", main);
+    BasicBlock *exit = BasicBlock::Create(context, "exit", main);
+
+    IRBuilder<> builder(entry);
+    builder.CreateCall(declare(ReplayOpen, voidTy, {}));
+    Value *reps = builder.CreateCall(declare(ReplayReps, int32Ty, {}), {}, "reps");
+    builder.CreateBr(loop);
+
+    // 每次重复都从录制的输入重新开始，参数按目标函数的类型从运行时取回
+    builder.SetInsertPoint(loop);
+    PHINode *rep = builder.CreatePHI(int32Ty, 2, "rep");
+    builder.CreateCall(declare(ReplayReset, voidTy, {}));
+    vector<Value *> args;
+    for (Argument &arg : target->args()) {
+        Type *type = arg.getType();
+        Value *index = builder.getInt32(arg.getArgNo());
+        if (type->isIntegerTy()) {
+            args.push_back(builder.CreateSExtOrTrunc(builder.CreateCall(declare(ReplayInt, int64Ty, {int32Ty}), {index}), type));
+        } else if (type->isFloatingPointTy()) {
+            Value *value = builder.CreateCall(declare(ReplayFP, doubleTy, {int32Ty}), {index});
+            args.push_back(type->isDoubleTy() ? value : builder.CreateFPTrunc(value, type));
+        } else if (type->isPointerTy()) {
+            args.push_back(builder.CreateCall(declare(ReplayPtr, ptrTy, {int32Ty}), {index}));
+        } else {
+            error = "argument " + std::to_string(arg.getArgNo()) + " of " + function + " has an unsupported type";
+            main->eraseFromParent();
+            return false;
+        }
+    }
+    builder.CreateCall(declare(ReplayBegin, voidTy, {}));
+    builder.CreateCall(target, args);
+    builder.CreateCall(declare(ReplayEnd, voidTy, {}));
+    Value *next = builder.CreateAdd(rep, builder.getInt32(1));
+    builder.CreateCondBr(builder.CreateICmpSLT(next, reps), loop, exit);
+    rep->addIncoming(builder.getInt32(0), entry);
+    rep->addIncoming(next, loop);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateCall(declare(ReplayReport, voidTy, {}));
+    builder.CreateRet(builder.getInt32(0));
+    return true;
+}
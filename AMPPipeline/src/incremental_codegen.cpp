@@ -0,0 +1,126 @@
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+
+#include "incremental_codegen.hpp"
+
+using namespace llvm;
+
+IncrementalCodegen::IncrementalCodegen(string outDir, ArtifactCache *cache)
+    : outDir_(std::move(outDir)), cache_(cache) {}
+
+// 与 llc 默认行为一致：三元组取自模块；TargetMachine 按 generic 创建，代码生成时各函数的
+// 子目标仍取自其 target-cpu/target-features 属性（属性在 IR 中，已计入子模块的键）
+bool IncrementalCodegen::createTargetMachine(Module &M, string &error) {
+    string triple = M.getTargetTriple();
+    if (triple.empty()) triple = sys::getDefaultTargetTriple();
+    const Target *target = TargetRegistry::lookupTarget(triple, error);
+    if (!target) return false;
+
+    TargetOptions options;
+    TM_.reset(target->createTargetMachine(triple, "generic", "", options, Reloc::Static));
+    if (!TM_) {
+        error = "cannot create target machine for " + triple;
+        return false;
+    }
+    if (M.getDataLayoutStr().empty()) M.setDataLayout(TM_->createDataLayout());
+    toolchain_ = string("LLVM ") + LLVM_VERSION_STRING + "\n" + triple + "\nO2";
+    return true;
+}
+
+void IncrementalCodegen::externalizeLocals(Module &M) {
+    for (GlobalValue &GV : M.global_values()) {
+        if (GV.isDeclaration() || !GV.hasLocalLinkage()) continue;
+        if (!GV.hasName()) GV.setName("amp.anon");
+        GV.setLinkage(GlobalValue::ExternalLinkage);
+        GV.setVisibility(GlobalValue::HiddenVisibility);
+    }
+}
+
+bool IncrementalCodegen::emitObject(Module &part, const string &path, string &error) {
+    std::error_code ec;
+    raw_fd_ostream out(path, ec, sys::fs::OF_None);
+    if (ec) {
+        error = path + ": " + ec.message();
+        return false;
+    }
+    legacy::PassManager PM;
+    if (TM_->addPassesToEmitFile(PM, out, nullptr, CGFT_ObjectFile)) {
+        error = "target cannot emit object files";
+        return false;
+    }
+    PM.run(part);
+    return true;
+}
+
+bool IncrementalCodegen::compilePart(Module &part, const string &name, vector<string> &objects, string &error) {
+    // CloneModule 会把其余全部函数与全局变量作为声明带进来。未使用的声明全部删掉，
+    // 否则别处新增一个声明（sqrtf、新的 intrinsic）或改了全局变量的类型，每个子模块的键都会变
+    for (auto it = part.global_begin(); it != part.global_end();) {
+        GlobalVariable &GV = *it++;
+        GV.removeDeadConstantUsers();
+        if (GV.isDeclaration() && GV.use_empty()) GV.eraseFromParent();
+    }
+    for (auto it = part.begin(); it != part.end();) {
+        Function &F = *it++;
+        F.removeDeadConstantUsers();
+        if (F.isDeclaration() && F.use_empty()) F.eraseFromParent();
+    }
+
+    // 模块名不参与哈希，同一函数在不同个体中得到相同的键
+    part.setModuleIdentifier("amp.part");
+    part.setSourceFileName("amp.part");
+    string ir;
+    raw_string_ostream os(ir);
+    part.print(os, nullptr);
+    os.flush();
+
+    string key = ArtifactCache::hashString(toolchain_ + "\n" + ir);
+    string path = outDir_ + "/" + name + ".o";
+    objects.push_back(path);
+    stats_.parts++;
+
+    if (cache_ && cache_->get(key, "obj", path)) {
+        stats_.hits++;
+        return true;
+    }
+    if (!emitObject(part, path, error)) return false;
+    if (cache_) cache_->put(key, "obj", path);
+    return true;
+}
+
+bool IncrementalCodegen::run(Module &M, vector<string> &objects, string &error) {
+    if (!createTargetMachine(M, error)) return false;
+    std::error_code ec = sys::fs::create_directories(outDir_);
+    if (ec) {
+        error = outDir_ + ": " + ec.message();
+        return false;
+    }
+    externalizeLocals(M);
+
+    // 别名跟随其指向的对象放在同一个子模块中
+    auto owner = [](const GlobalValue *GV) -> const GlobalObject * {
+        if (auto *alias = dyn_cast<GlobalAlias>(GV)) return alias->getAliaseeObject();
+        return dyn_cast<GlobalObject>(GV);
+    };
+
+    ValueToValueMapTy globalsMap;
+    auto globals = CloneModule(M, globalsMap, [&](const GlobalValue *GV) {
+        return isa_and_nonnull<GlobalVariable>(owner(GV));
+    });
+    if (!compilePart(*globals, "globals", objects, error)) return false;
+
+    unsigned index = 0;
+    for (Function &F : M) {
+        if (F.isDeclaration() || F.hasAvailableExternallyLinkage()) continue;
+        ValueToValueMapTy VMap;
+        auto part = CloneModule(M, VMap, [&](const GlobalValue *GV) { return owner(GV) == &F; });
+        if (!compilePart(*part, "f" + std::to_string(index++), objects, error)) return false;
+    }
+    return true;
+}
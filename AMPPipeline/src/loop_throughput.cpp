@@ -0,0 +1,212 @@
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/BranchProbabilityInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <set>
+
+#include "loop_throughput.hpp"
+
+using namespace llvm;
+using json = nlohmann::json;
+
+unsigned LoopThroughput::markLoops(Function &F) {
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+    BranchProbabilityInfo BPI(F, LI);
+    BlockFrequencyInfo BFI(F, BPI, LI);
+    double entryFreq = BFI.getEntryFreq() ? (double)BFI.getEntryFreq() : 1.0;
+
+    auto *markerTy = FunctionType::get(Type::getVoidTy(F.getContext()), false);
+    unsigned marked = 0;
+    for (Loop *loop : LI.getLoopsInPreorder()) {
+        if (!loop->getSubLoops().empty()) continue;
+        BasicBlock *latch = loop->getLoopLatch();
+        if (!latch) continue;
+
+        LoopEstimate estimate;
+        estimate.function = F.getName().str();
+        if (DebugLoc loc = loop->getStartLoc()) estimate.line = loc.getLine();
+        estimate.region = "L" + std::to_string(loops_.size());
+        estimate.weight = BFI.getBlockFreq(loop->getHeader()).getFrequency() / entryFreq;
+
+        // 区域覆盖循环头到回边块之间按布局连续的指令，llvm-mca 把它当作一次迭代反复执行
+        IRBuilder<> builder(&*loop->getHeader()->getFirstInsertionPt());
+        builder.CreateCall(InlineAsm::get(markerTy, "# LLVM-MCA-BEGIN " + estimate.region, "", true));
+        builder.SetInsertPoint(latch->getTerminator());
+        builder.CreateCall(InlineAsm::get(markerTy, "# LLVM-MCA-END " + estimate.region, "", true));
+
+        loops_.push_back(estimate);
+        marked++;
+    }
+    return marked;
+}
+
+bool LoopThroughput::emitAssembly(Module &M, const string &path, string &error) {
+    const Target *target = TargetRegistry::lookupTarget(M.getTargetTriple(), error);
+    if (!target) return false;
+    TargetOptions options;
+    unique_ptr<TargetMachine> TM(
+        target->createTargetMachine(M.getTargetTriple(), cpu_, "", options, Reloc::Static));
+    if (!TM) {
+        error = "cannot create target machine for " + M.getTargetTriple();
+        return false;
+    }
+
+    SmallString<0> text;
+    raw_svector_ostream os(text);
+    legacy::PassManager PM;
+    if (TM->addPassesToEmitFile(PM, os, nullptr, CGFT_AssemblyFile)) {
+        error = "target cannot emit assembly";
+        return false;
+    }
+    PM.run(M);
+
+    std::error_code ec;
+    raw_fd_ostream out(path, ec, sys::fs::OF_Text);
+    if (ec) {
+        error = path + ": " + ec.message();
+        return false;
+    }
+    SmallVector<StringRef, 0> lines;
+    StringRef(text).split(lines, '\n');
+    set<string> bad = checkMarkers(lines);
+    // 打印内联汇编时注释会换成目标的注释符（AArch64 为 //），标记行统一改回 #；顺序不对的区域去掉标记
+    for (StringRef line : lines) {
+        size_t marker = line.find("LLVM-MCA-");
+        if (marker == StringRef::npos) {
+            out << line << "\n";
+        } else if (!bad.count(line.substr(marker).split(' ').second.trim().str())) {
+            out << "# " << line.substr(marker) << "\n";
+        }
+    }
+    skipped_ = 0;
+    for (auto it = loops_.begin(); it != loops_.end();) {
+        if (bad.count(it->region)) {
+            it = loops_.erase(it);
+            skipped_++;
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+set<string> LoopThroughput::checkMarkers(ArrayRef<StringRef> lines) {
+    // 块布局可能把回边块排在循环头之前（旋转后的循环、多块循环），或复制出多份标记；
+    // 这样的区域 llvm-mca 会拒绝整个文件，只保留 BEGIN 先于 END、各出现一次且不与其他区域交错的区域
+    set<string> begun, ended, bad;
+    string open;
+    for (StringRef line : lines) {
+        size_t marker = line.find("LLVM-MCA-");
+        if (marker == StringRef::npos) continue;
+        auto [kind, name] = line.substr(marker).split(' ');
+        string region = name.trim().str();
+        if (kind == "LLVM-MCA-BEGIN") {
+            if (!begun.insert(region).second) bad.insert(region);
+            if (!open.empty()) {
+                bad.insert(open);
+                bad.insert(region);
+            }
+            open = region;
+        } else {
+            if (open != region || !ended.insert(region).second) {
+                bad.insert(region);
+                if (!open.empty()) bad.insert(open);
+            }
+            if (open == region) open.clear();
+        }
+    }
+    if (!open.empty()) bad.insert(open);
+    for (auto &region : begun) {
+        if (!ended.count(region)) bad.insert(region);
+    }
+    for (auto &region : ended) {
+        if (!begun.count(region)) bad.insert(region);
+    }
+    return bad;
+}
+
+bool LoopThroughput::runMCA(const string &triple, const string &asmPath, string &error) {
+    auto program = mcaPath_.find('/') == string::npos ? sys::findProgramByName(mcaPath_)
+                                                      : ErrorOr<string>(mcaPath_);
+    if (!program) {
+        error = "cannot find " + mcaPath_;
+        return false;
+    }
+
+    SmallString<128> jsonPath;
+    if (auto ec = sys::fs::createTemporaryFile("amp-mca", "json", jsonPath)) {
+        error = ec.message();
+        return false;
+    }
+    string mtriple = "-mtriple=" + triple, mcpu = "-mcpu=" + cpu_;
+    string output = "-o=" + jsonPath.str().str();
+    StringRef args[] = {*program, mtriple, mcpu, "-json", output, asmPath};
+    string message;
+    int status = sys::ExecuteAndWait(*program, args, {}, {}, 0, 0, &message);
+    auto buffer = MemoryBuffer::getFile(jsonPath);
+    sys::fs::remove(jsonPath);
+    if (status != 0 || !buffer) {
+        error = "llvm-mca failed" + (message.empty() ? "" : ": " + message);
+        return false;
+    }
+
+    // 每个区域的 SummaryView.BlockRThroughput 为稳态下一次迭代的周期数
+    json report = json::parse((*buffer)->getBuffer().str(), nullptr, false);
+    if (!report.is_object() || !report.contains("CodeRegions")) {
+        error = "unexpected llvm-mca output";
+        return false;
+    }
+    map<string, double> throughput;
+    for (const json &region : report["CodeRegions"]) {
+        if (region.contains("Name") && region.contains("SummaryView")) {
+            throughput[region["Name"].get<string>()] = region["SummaryView"].value("BlockRThroughput", 0.0);
+        }
+    }
+    for (auto &loop : loops_) loop.cyclesPerIteration = throughput[loop.region];
+    return true;
+}
+
+bool LoopThroughput::run(Module &M, const set<string> &functions, string &error) {
+    if (M.getTargetTriple().empty()) {
+        error = "module has no target triple";
+        return false;
+    }
+    loops_.clear();
+    skipped_ = 0;
+    for (Function &F : M) {
+        if (F.isDeclaration()) continue;
+        if (!functions.empty() && !functions.count(F.getName().str())) continue;
+        markLoops(F);
+    }
+    if (loops_.empty()) return true;
+
+    SmallString<128> asmPath;
+    if (auto ec = sys::fs::createTemporaryFile("amp-mca", "s", asmPath)) {
+        error = ec.message();
+        return false;
+    }
+    // 全部区域都被跳过时没有可分析的循环，不再运行 llvm-mca
+    bool ok = emitAssembly(M, asmPath.str().str(), error) &&
+              (loops_.empty() || runMCA(M.getTargetTriple(), asmPath.str().str(), error));
+    sys::fs::remove(asmPath);
+    return ok;
+}
+
+double LoopThroughput::weightedTotal() const {
+    double total = 0;
+    for (auto &loop : loops_) total += loop.cyclesPerIteration * loop.weight;
+    return total;
+}
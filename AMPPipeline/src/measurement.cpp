@@ -0,0 +1,146 @@
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/personality.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "measurement.hpp"
+
+bool parseCpuList(const string &text, vector<int> &cpus) {
+    cpus.clear();
+    istringstream in(text);
+    for (string item; std::getline(in, item, ',');) {
+        if (item.empty()) continue;
+        size_t dash = item.find('-');
+        try {
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) return false;
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        } catch (const std::exception &) {
+            return false;
+        }
+    }
+    return !cpus.empty();
+}
+
+vector<int> allowedCpus() {
+    vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+void applyIsolationInChild(const IsolationOptions &isolation) {
+    if (!isolation.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : isolation.cpus) CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    if (isolation.disableASLR) {
+        int current = personality(0xffffffff);
+        if (current != -1) personality(current | ADDR_NO_RANDOMIZE);
+    }
+}
+
+PerfCounters::~PerfCounters() { close(); }
+
+bool PerfCounters::open(pid_t pid, bool enableOnExec) {
+    close();
+    auto cache = [](uint64_t id) {
+        return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    const struct {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+    } events[] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"l1dMisses", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D)},
+        {"llcMisses", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL)},
+        {"taskClockNs", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    };
+    for (auto &event : events) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = enableOnExec;
+        attr.enable_on_exec = enableOnExec;
+        attr.inherit = 1;
+        // 只统计用户态，perf_event_paranoid 为 2 时普通用户也能打开
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = syscall(__NR_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd >= 0) fds_.emplace_back(event.name, fd);
+    }
+    return available();
+}
+
+void PerfCounters::close() {
+    for (auto &entry : fds_) ::close(entry.second);
+    fds_.clear();
+}
+
+map<string, double> PerfCounters::read() const {
+    map<string, double> values;
+    for (auto &[name, fd] : fds_) {
+        uint64_t data[3];  // value, time_enabled, time_running
+        if (::read(fd, data, sizeof(data)) != sizeof(data)) continue;
+        // 从未被调度上 PMU（目标尚未 exec 或事件一直被挤占），没有可用的值
+        if (data[2] == 0) continue;
+        values[name] = data[2] < data[1] ? double(data[0]) * data[1] / data[2] : double(data[0]);
+    }
+    return values;
+}
+
+static bool readLine(const string &path, string &value) {
+    std::ifstream in(path);
+    return bool(std::getline(in, value));
+}
+
+bool CpuFrequencyGuard::set(const string &path, const string &value) {
+    string old;
+    if (!readLine(path, old)) return false;
+    if (old == value) return true;
+    std::ofstream out(path);
+    out << value << "\n";
+    out.close();
+    if (!out) return false;
+    saved_.emplace_back(path, old);
+    return true;
+}
+
+CpuFrequencyGuard::CpuFrequencyGuard(const vector<int> &cpus) {
+    for (int cpu : cpus) {
+        set("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/cpufreq/scaling_governor", "performance");
+    }
+    // 两处只会存在其一：acpi-cpufreq 的 boost 与 intel_pstate 的 no_turbo
+    set("/sys/devices/system/cpu/cpufreq/boost", "0");
+    set("/sys/devices/system/cpu/intel_pstate/no_turbo", "1");
+}
+
+CpuFrequencyGuard::~CpuFrequencyGuard() {
+    for (auto it = saved_.rbegin(); it != saved_.rend(); ++it) {
+        std::ofstream(it->first) << it->second << "\n";
+    }
+}
+
+vector<string> CpuFrequencyGuard::applied() const {
+    vector<string> paths;
+    for (auto &entry : saved_) paths.push_back(entry.first);
+    return paths;
+}
@@ -0,0 +1,97 @@
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+
+#include "process_runner.hpp"
+
+ProcessResult runProcess(const vector<string> &command, const string &cwd, const string &log, bool captureOutput,
+                         const IsolationOptions &isolation) {
+    ProcessResult result;
+    if (command.empty()) return result;
+
+    // fork 之后子进程只做异步信号安全的调用，参数在此之前准备好
+    vector<char *> argv;
+    for (auto &arg : command) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    const char *logPath = log.empty() ? "/dev/null" : log.c_str();
+
+    int outPipe[2] = {-1, -1}, syncPipe[2] = {-1, -1};
+    if (captureOutput && pipe2(outPipe, O_CLOEXEC) != 0) return result;
+    if (isolation.perfCounters && pipe2(syncPipe, O_CLOEXEC) != 0) {
+        if (captureOutput) {
+            close(outPipe[0]);
+            close(outPipe[1]);
+        }
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        for (int fd : {outPipe[0], outPipe[1], syncPipe[0], syncPipe[1]}) {
+            if (fd >= 0) close(fd);
+        }
+        return result;
+    }
+    if (pid == 0) {
+        applyIsolationInChild(isolation);
+        if (isolation.perfCounters) {
+            // 父进程打开计数器后写入一个字节。不能等 EOF：其他线程同时 fork 的子进程在 exec 之前也持有写端
+            char ready;
+            close(syncPipe[1]);
+            while (read(syncPipe[0], &ready, 1) < 0 && errno == EINTR) {
+            }
+        }
+        int fd = open(logPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDERR_FILENO);
+            if (!captureOutput) dup2(fd, STDOUT_FILENO);
+            close(fd);
+        }
+        if (captureOutput) dup2(outPipe[1], STDOUT_FILENO);
+        if (!cwd.empty() && chdir(cwd.c_str()) != 0) _exit(127);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    PerfCounters counters;
+    if (isolation.perfCounters) {
+        counters.open(pid, true);
+        while (write(syncPipe[1], "x", 1) < 0 && errno == EINTR) {
+        }
+        close(syncPipe[0]);
+        close(syncPipe[1]);
+    }
+
+    if (captureOutput) {
+        close(outPipe[1]);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(outPipe[0], buffer, sizeof(buffer))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            result.output.append(buffer, n);
+        }
+        close(outPipe[0]);
+    }
+
+    int status = 0;
+    struct rusage usage {};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    result.peakRSSKiB = usage.ru_maxrss;
+    result.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                        (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    // 子进程已被回收，继承的计数都已并入
+    if (counters.available()) result.counters = counters.read();
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return result;
+}
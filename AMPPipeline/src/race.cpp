@@ -0,0 +1,55 @@
+#include <algorithm>
+
+#include "race.hpp"
+
+// 双侧置信水平对应的正态分位数，对 erf 二分求解
+static double normalQuantile(double confidence) {
+    double lo = 0, hi = 10;
+    for (int i = 0; i < 100; i++) {
+        double mid = (lo + hi) / 2;
+        (std::erf(mid / std::sqrt(2.0)) < confidence ? lo : hi) = mid;
+    }
+    return (lo + hi) / 2;
+}
+
+RaceInterval RepetitionRace::interval() const {
+    RaceInterval result;
+    result.runs = scores_.size();
+    if (scores_.empty()) return result;
+
+    double sum = 0;
+    for (double score : scores_) sum += score;
+    result.mean = sum / scores_.size();
+
+    double variance = 0;
+    for (double score : scores_) variance += (score - result.mean) * (score - result.mean);
+    double stddev = scores_.size() > 1 ? std::sqrt(variance / (scores_.size() - 1)) : 0;
+    stddev = std::max(stddev, options_.noise * std::fabs(result.mean));
+
+    double half = normalQuantile(options_.confidence) * stddev / std::sqrt(double(scores_.size()));
+    result.low = result.mean - half;
+    result.high = result.mean + half;
+    return result;
+}
+
+RepetitionRace::Decision RepetitionRace::decide(const RaceInterval *incumbent) const {
+    unsigned runs = scores_.size();
+    if (runs < std::max(1u, options_.minRuns)) return Decision::Continue;
+    if (!incumbent) return Decision::NoIncumbent;
+
+    RaceInterval current = interval();
+    if (current.high < incumbent->low) return Decision::Worse;
+    if (current.low > incumbent->high) return Decision::Better;
+    return runs >= options_.maxRuns ? Decision::Unresolved : Decision::Continue;
+}
+
+const char *RepetitionRace::name(Decision decision) {
+    switch (decision) {
+        case Decision::Continue: return "continue";
+        case Decision::Worse: return "worse";
+        case Decision::Better: return "better";
+        case Decision::Unresolved: return "unresolved";
+        case Decision::NoIncumbent: return "no-incumbent";
+    }
+    return "";
+}
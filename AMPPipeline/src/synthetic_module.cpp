@@ -0,0 +1,132 @@
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+
+#include <cmath>
+
+#include "synthetic_module.hpp"
+
+using namespace llvm;
+
+string SyntheticSpec::name() const {
+    return "f" + to_string(functions) + "_l" + to_string(locals) + "_d" + to_string(pointerDepth) + "_u" +
+           to_string(uses) + "_n" + to_string(loopDepth);
+}
+
+nlohmann::json SyntheticSpec::toJSON() const {
+    return {{"functions", functions},
+            {"locals", locals},
+            {"pointerDepth", pointerDepth},
+            {"uses", uses},
+            {"loopDepth", loopDepth}};
+}
+
+// 沿 pointerDepth 层指针取到 double 元素的地址，第 d 层用第 d 个循环变量作下标（不够时用 0）
+static Value *elementAddress(IRBuilder<> &B, Value *arrayAddr, const SyntheticSpec &spec,
+                             const vector<Value *> &indices) {
+    Type *ptrTy = PointerType::getUnqual(B.getContext());
+    auto index = [&](unsigned level) -> Value * {
+        return level < indices.size() ? indices[level] : B.getInt64(0);
+    };
+    Value *base = B.CreateLoad(ptrTy, arrayAddr);
+    for (unsigned d = 1; d < spec.pointerDepth; d++) {
+        base = B.CreateLoad(ptrTy, B.CreateInBoundsGEP(ptrTy, base, index(d - 1)));
+    }
+    unsigned last = indices.empty() ? 0 : indices.size() - 1;
+    return B.CreateInBoundsGEP(B.getDoubleTy(), base, index(last));
+}
+
+static void buildFunction(Module &M, const SyntheticSpec &spec, unsigned id) {
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+    Type *doubleTy = Type::getDoubleTy(context);
+    Type *i64Ty = Type::getInt64Ty(context);
+
+    auto *type = FunctionType::get(Type::getVoidTy(context), {ptrTy, i64Ty}, false);
+    Function *F = Function::Create(type, GlobalValue::ExternalLinkage, "f" + to_string(id), M);
+    Argument *array = F->getArg(0), *count = F->getArg(1);
+    array->setName("a");
+    count->setName("n");
+
+    BasicBlock *entry = BasicBlock::Create(context, "entry", F);
+    IRBuilder<> B(entry);
+    Value *arrayAddr = B.CreateAlloca(ptrTy, nullptr, "a.addr");
+    Value *countAddr = B.CreateAlloca(i64Ty, nullptr, "n.addr");
+    vector<Value *> locals;
+    for (unsigned k = 0; k < spec.locals; k++) {
+        locals.push_back(B.CreateAlloca(doubleTy, nullptr, "s" + to_string(k)));
+    }
+    B.CreateStore(array, arrayAddr);
+    B.CreateStore(count, countAddr);
+    for (Value *local : locals) B.CreateStore(ConstantFP::get(doubleTy, 0.0), local);
+    Value *bound = B.CreateLoad(i64Ty, countAddr);
+
+    // 循环头 phi 计数 0..n，先逐层进入，最内层体生成完再逐层补上回边
+    struct Loop {
+        BasicBlock *header, *exit;
+        PHINode *iv;
+    };
+    vector<Loop> loops;
+    vector<Value *> indices;
+    for (unsigned l = 0; l < spec.loopDepth; l++) {
+        BasicBlock *preheader = B.GetInsertBlock();
+        BasicBlock *header = BasicBlock::Create(context, "loop" + to_string(l), F);
+        BasicBlock *body = BasicBlock::Create(context, "body" + to_string(l), F);
+        BasicBlock *exit = BasicBlock::Create(context, "exit" + to_string(l), F);
+        B.CreateBr(header);
+        B.SetInsertPoint(header);
+        PHINode *iv = B.CreatePHI(i64Ty, 2, "i" + to_string(l));
+        iv->addIncoming(B.getInt64(0), preheader);
+        B.CreateCondBr(B.CreateICmpSLT(iv, bound), body, exit);
+        B.SetInsertPoint(body);
+        loops.push_back({header, exit, iv});
+        indices.push_back(iv);
+    }
+
+    Value *element = B.CreateLoad(doubleTy, elementAddress(B, arrayAddr, spec, indices));
+    for (unsigned k = 0; k < spec.locals; k++) {
+        for (unsigned u = 0; u < spec.uses; u++) {
+            Value *current = B.CreateLoad(doubleTy, locals[k]);
+            Value *updated = u % 2 == 0
+                                 ? B.CreateFMul(current, element)
+                                 : B.CreateFAdd(current, B.CreateLoad(doubleTy, locals[(k + 1) % spec.locals]));
+            B.CreateStore(updated, locals[k]);
+        }
+    }
+
+    for (unsigned l = spec.loopDepth; l-- > 0;) {
+        BasicBlock *latch = BasicBlock::Create(context, "latch" + to_string(l), F);
+        B.CreateBr(latch);
+        B.SetInsertPoint(latch);
+        loops[l].iv->addIncoming(B.CreateAdd(loops[l].iv, B.getInt64(1)), latch);
+        B.CreateBr(loops[l].header);
+        B.SetInsertPoint(loops[l].exit);
+    }
+
+    Value *sum = ConstantFP::get(doubleTy, 0.0);
+    for (Value *local : locals) sum = B.CreateFAdd(sum, B.CreateLoad(doubleTy, local));
+    B.CreateStore(sum, elementAddress(B, arrayAddr, spec, {}));
+    B.CreateRetVoid();
+}
+
+unique_ptr<Module> buildSyntheticModule(LLVMContext &context, const SyntheticSpec &spec) {
+    auto M = std::make_unique<Module>("synthetic_" + spec.name(), context);
+    for (unsigned id = 0; id < spec.functions; id++) buildFunction(*M, spec, id);
+    return M;
+}
+
+nlohmann::json buildSyntheticConfig(const SyntheticSpec &spec, double fraction, bool lowerArgs) {
+    nlohmann::json config = {{"localVar", nlohmann::json::array()}};
+    unsigned lowered = (unsigned)std::lround(fraction * spec.locals);
+    for (unsigned id = 0; id < spec.functions; id++) {
+        string function = "f" + to_string(id);
+        for (unsigned k = 0; k < lowered && k < spec.locals; k++) {
+            config["localVar"].push_back({{"function", function}, {"name", "s" + to_string(k)}, {"type", "float"}});
+        }
+        if (lowerArgs) {
+            config["localVar"].push_back(
+                {{"function", function}, {"name", "a"}, {"type", "float" + string(spec.pointerDepth, '*')}});
+        }
+    }
+    return config;
+}
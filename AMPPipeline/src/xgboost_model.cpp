@@ -0,0 +1,127 @@
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "xgboost_model.hpp"
+
+using json = nlohmann::json;
+
+// learner_model_param 中的数值以字符串保存，新版本的 base_score 形如 "[5E-1]"
+static double paramNumber(const json &params, const char *key, double fallback) {
+    if (!params.contains(key)) return fallback;
+    const json &value = params[key];
+    if (value.is_number()) return value.get<double>();
+    string text = value.get<string>();
+    if (!text.empty() && text.front() == '[') text = text.substr(1, text.find(']') - 1);
+    return text.empty() ? fallback : std::stod(text);
+}
+
+bool XGBoostModel::load(const string &path, string &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    try {
+        json root;
+        in >> root;
+        const json &learner = root.at("learner");
+        const json &params = learner.at("learner_model_param");
+        if (paramNumber(params, "num_class", 0) > 1) {
+            error = "multi-class models are not supported";
+            return false;
+        }
+        numFeatures_ = (size_t)paramNumber(params, "num_feature", 0);
+
+        const json &booster = learner.at("gradient_booster");
+        if (booster.value("name", "gbtree") != "gbtree") {
+            error = "only gbtree boosters are supported";
+            return false;
+        }
+
+        // base_score 按目标函数保存在输出空间，推理时换回 margin 空间
+        double baseScore = paramNumber(params, "base_score", 0.5);
+        string objective = learner.at("objective").value("name", "reg:squarederror");
+        if (objective == "reg:logistic" || objective == "binary:logistic") {
+            objective_ = Objective::Logistic;
+            baseMargin_ = -std::log(1.0 / baseScore - 1.0);
+        } else if (objective == "count:poisson" || objective == "reg:gamma" || objective == "reg:tweedie") {
+            objective_ = Objective::Exp;
+            baseMargin_ = std::log(baseScore);
+        } else {
+            objective_ = Objective::Identity;
+            baseMargin_ = baseScore;
+        }
+
+        nodes_.clear();
+        roots_.clear();
+        for (const json &tree : booster.at("model").at("trees")) {
+            const json &left = tree.at("left_children"), &right = tree.at("right_children");
+            const json &indices = tree.at("split_indices"), &conditions = tree.at("split_conditions");
+            const json &defaultLeft = tree.at("default_left");
+
+            uint32_t base = nodes_.size();
+            roots_.push_back(base);
+            for (size_t i = 0; i < left.size(); i++) {
+                Node node;
+                int32_t l = left[i].get<int32_t>(), r = right[i].get<int32_t>();
+                node.left = l < 0 ? -1 : (int32_t)base + l;
+                node.right = r < 0 ? -1 : (int32_t)base + r;
+                node.feature = indices[i].get<uint32_t>();
+                node.value = conditions[i].get<float>();
+                node.defaultLeft = defaultLeft[i].is_boolean() ? defaultLeft[i].get<bool>() : defaultLeft[i].get<int>() != 0;
+                if (node.left >= 0) numFeatures_ = std::max<size_t>(numFeatures_, node.feature + 1);
+                nodes_.push_back(node);
+            }
+        }
+
+        featureNames_.clear();
+        if (learner.contains("feature_names")) {
+            for (const json &name : learner["feature_names"]) featureNames_.push_back(name.get<string>());
+        }
+        numFeatures_ = std::max(numFeatures_, featureNames_.size());
+        for (size_t i = featureNames_.size(); i < numFeatures_; i++) featureNames_.push_back("f" + std::to_string(i));
+        featureIndex_.clear();
+        for (size_t i = 0; i < featureNames_.size(); i++) featureIndex_[featureNames_[i]] = i;
+    } catch (const std::exception &e) {
+        error = "bad model " + path + ": " + e.what();
+        return false;
+    }
+    return true;
+}
+
+int XGBoostModel::featureIndex(const string &name) const {
+    auto it = featureIndex_.find(name);
+    return it == featureIndex_.end() ? -1 : it->second;
+}
+
+double XGBoostModel::transform(double margin) const {
+    switch (objective_) {
+        case Objective::Logistic: return 1.0 / (1.0 + std::exp(-margin));
+        case Objective::Exp: return std::exp(margin);
+        default: return margin;
+    }
+}
+
+// 与 XGBoost 一致：fvalue < 阈值走左子树，缺失值走 default_left 指定的一侧
+double XGBoostModel::predict(const float *features) const {
+    double margin = baseMargin_;
+    for (uint32_t root : roots_) {
+        const Node *node = &nodes_[root];
+        while (node->left >= 0) {
+            float value = features[node->feature];
+            bool goLeft = std::isnan(value) ? node->defaultLeft : value < node->value;
+            node = &nodes_[goLeft ? node->left : node->right];
+        }
+        margin += node->value;
+    }
+    return transform(margin);
+}
+
+void XGBoostModel::predictBatch(const float *rows, size_t n, vector<double> &out) const {
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) out[i] = predict(rows + i * numFeatures_);
+}
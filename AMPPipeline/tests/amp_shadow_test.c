@@ -0,0 +1,26 @@
+/*
+ * 影子内存被未插桩的代码（这里是 memcpy）改写后，读出时应退回程序值而不是旧的影子。
+ */
+#include <stdio.h>
+#include <string.h>
+
+double __amp_shadow_load(const void *addr, double value);
+void __amp_shadow_store(const void *addr, double shadow, double value);
+
+int main(void) {
+    float x = 0.1f;
+    __amp_shadow_store(&x, 0.1, x);
+    if (__amp_shadow_load(&x, x) != 0.1) {
+        printf("shadow lost before the memory was touched\n");
+        return 1;
+    }
+
+    float y = 3.0f;
+    memcpy(&x, &y, sizeof(x));
+    double value = __amp_shadow_load(&x, x);
+    if (value != 3.0) {
+        printf("stale shadow %.17g returned after memcpy\n", value);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * 同一个被看门狗监视的循环在一个进程中执行两次（HPL-AI 依次求解多个规模）。
+ * 每次都在 patience 之内收敛，第二次求解的残差比第一次的最小值大：
+ * 进入循环时不重置状态就会继承停滞计数而以 87 退出。
+ */
+#include <stdio.h>
+
+void __amp_watchdog_begin(int id);
+void __amp_watchdog_step(int id, double residual, const char *name, int patience, double budget);
+
+static void solve(double first, int iterations) {
+    __amp_watchdog_begin(0);
+    double residual = first;
+    for (int i = 0; i < iterations; i++) {
+        // 先下降，最后几次迭代停在最小值上，停滞次数小于 patience
+        if (i < iterations / 2) residual *= 0.5;
+        __amp_watchdog_step(0, residual, "test:1:r", 8, 0);
+    }
+}
+
+int main(void) {
+    solve(1.0, 12);
+    solve(1e3, 12);
+    solve(1e6, 12);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+#!/bin/bash
+# 只改动一个函数（并新增它用到的外部声明）时，amp-codegen 只应重新生成这一个子模块。
+# AMP_CODEGEN 为 amp-codegen 的路径，默认在 PATH 中查找
+set -eu
+codegen=${AMP_CODEGEN:-amp-codegen}
+if ! command -v "$codegen" >/dev/null; then
+    echo "SKIP: $codegen not found, set AMP_CODEGEN"
+    exit 77
+fi
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/base.ll" <<'IR'
+@g = global double 1.0
+
+define double @a(double %x) {
+  %v = load double, ptr @g
+  %r = fadd double %x, %v
+  ret double %r
+}
+
+define double @b(double %x) {
+  %r = fmul double %x, %x
+  ret double %r
+}
+
+define double @c(double %x) {
+  %r = call double @a(double %x)
+  %s = call double @b(double %r)
+  ret double %s
+}
+IR
+
+# b 降为 float 并调用 sqrtf：新的函数声明与外部全局变量只被 b 使用
+cat > "$work/changed.ll" <<'IR'
+@g = global double 1.0
+@scale = external global float
+
+define double @a(double %x) {
+  %v = load double, ptr @g
+  %r = fadd double %x, %v
+  ret double %r
+}
+
+define double @b(double %x) {
+  %t = fptrunc double %x to float
+  %k = load float, ptr @scale
+  %m = fmul float %t, %k
+  %q = call float @sqrtf(float %m)
+  %r = fpext float %q to double
+  ret double %r
+}
+
+define double @c(double %x) {
+  %r = call double @a(double %x)
+  %s = call double @b(double %r)
+  ret double %s
+}
+
+declare float @sqrtf(float)
+IR
+
+run() {
+    "$codegen" "$work/$1.ll" -o "$work/obj_$1" -cache-dir "$work/cache" -list "$work/$1.txt" 2>&1 |
+        sed -n 's/.*\] \([0-9]*\) part(s), \([0-9]*\) reused.*/\1 \2/p'
+}
+
+read -r parts hits < <(run base)
+[ "$parts" = 4 ] && [ "$hits" = 0 ] || { echo "base: $parts part(s), $hits reused, expected 4, 0"; exit 1; }
+read -r parts hits < <(run changed)
+[ "$parts" = 4 ] && [ "$hits" = 3 ] || { echo "changed: $parts part(s), $hits reused, expected 4, 3"; exit 1; }
@@ -0,0 +1,43 @@
+#!/bin/bash
+# 运行时与工具的测试：
+#   <name>_test.c  与 runtime/<name>.c 一起编译运行，退出码 0 为通过
+#   *_test.sh      直接运行，所需工具的路径由环境变量给出（见各脚本开头），退出码 77 为跳过
+# 用法：tests/run_tests.sh [测试名...]
+set -u
+cd "$(dirname "$0")"
+CC=${CC:-cc}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+tests=("$@")
+if [ ${#tests[@]} -eq 0 ]; then
+    for f in *_test.c *_test.sh; do [ -e "$f" ] && tests+=("$f"); done
+fi
+
+failed=0
+for t in "${tests[@]}"; do
+    case "$t" in
+        *.c)
+            name=${t%_test.c}
+            if ! $CC -O1 -o "$work/$name" "$t" "../runtime/$name.c" -lm || ! (cd "$work" && "./$name"); then
+                failed=$((failed + 1))
+                echo -e "\033[31mFAIL $t\033[0m"
+                continue
+            fi
+            ;;
+        *.sh)
+            bash "$t"
+            status=$?
+            if [ $status -eq 77 ]; then
+                echo -e "\033[33mSKIP $t\033[0m"
+                continue
+            elif [ $status -ne 0 ]; then
+                failed=$((failed + 1))
+                echo -e "\033[31mFAIL $t\033[0m"
+                continue
+            fi
+            ;;
+    esac
+    echo -e "\033[32mPASS $t\033[0m"
+done
+exit $((failed > 0))
@@ -0,0 +1,63 @@
+#!/bin/bash
+# 同一个模块的 IR 特征经两条路径打分应得到相同结果：
+#   训练侧（GeneticOptimizer._train_native_surrogate）把稀疏的 ir_features 补 0 成稠密向量，用 xgboost 预测；
+#   推理侧 amp-surrogate 直接读稀疏的 ir_features。
+# 训练样本里部分特征只在一部分模块中出现，被打分的模块缺少它们，缺失值若按 NaN 处理两边结果会不同。
+# AMP_SURROGATE 为 amp-surrogate 的路径，默认在 PATH 中查找；PYTHON 默认为 python3，需要 xgboost 与 numpy
+set -eu
+surrogate=${AMP_SURROGATE:-amp-surrogate}
+python=${PYTHON:-python3}
+if ! command -v "$surrogate" >/dev/null || ! "$python" -c "import numpy, xgboost" 2>/dev/null; then
+    echo "SKIP: $surrogate or xgboost not found, set AMP_SURROGATE and PYTHON"
+    exit 77
+fi
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# 被打分的模块：没有 half 运算，也没有循环内的转换
+echo '{"id": 0, "features": {"fp.float.fmul": 12, "fp.double.fadd": 3, "mem.load.float.bytes": 64, "vector.fraction": 0.5}}' \
+    > "$work/candidate.jsonl"
+
+"$python" - "$work" <<'PY'
+import json, random, sys
+import numpy as np
+import xgboost as xgb
+
+work = sys.argv[1]
+random.seed(0)
+optional = ["fp.half.fmul", "cvt.fptrunc.loop", "lowered.vars"]
+base = ["fp.float.fmul", "fp.double.fadd", "mem.load.float.bytes", "vector.fraction"]
+samples = []
+for _ in range(64):
+    features = {name: random.uniform(0, 100) for name in base}
+    for name in optional:
+        if random.random() < 0.5:
+            features[name] = random.uniform(0, 100)
+    fitness = -features["fp.float.fmul"] + features.get("fp.half.fmul", 0.0) - features.get("cvt.fptrunc.loop", 0.0)
+    samples.append({"features": features, "fitness": fitness})
+
+# 与 _train_native_surrogate 相同：特征名取并集排序，缺少的补 0
+names = sorted({name for sample in samples for name in sample["features"]})
+X = np.array([[sample["features"].get(name, 0.0) for name in names] for sample in samples])
+y = np.array([sample["fitness"] for sample in samples])
+model = xgb.XGBRegressor(n_estimators=20, max_depth=4)
+model.fit(X, y)
+model.get_booster().feature_names = names
+model.save_model(f"{work}/model.json")
+
+with open(f"{work}/candidate.jsonl") as f:
+    candidate = json.loads(f.readline())["features"]
+row = np.array([[candidate.get(name, 0.0) for name in names]])
+with open(f"{work}/expected.txt", "w") as f:
+    f.write(f"{float(model.predict(row)[0])}\n")
+PY
+
+"$surrogate" -model "$work/model.json" "$work/candidate.jsonl" 2>/dev/null |
+    "$python" -c 'import json, sys; print(json.loads(sys.stdin.readline())["score"])' > "$work/score.txt"
+
+expected=$(cat "$work/expected.txt")
+score=$(cat "$work/score.txt")
+if ! "$python" -c "import sys; sys.exit(abs($expected - $score) > 1e-4 * max(1.0, abs($expected)))"; then
+    echo "amp-surrogate scored $score, xgboost on the zero-filled vector predicted $expected"
+    exit 1
+fi
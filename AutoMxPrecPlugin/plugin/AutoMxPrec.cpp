@@ -2,13 +2,39 @@
 
 使用命令，自己改路径 -Xclang output.json指定输出
 clang --target=aarch64-linux-gnu -march=armv8.2-a+fp16 -static \
-    -Xclang -load -Xclang ~/opt/AMP/AutoMxPrecPlugin/build/plugin/AutoMxPrec.so \
-    -Xclang -plugin -Xclang auto-mxprec-plugin -Xclang -plugin-arg-auto-mxprec-plugin -Xclang output.json /mnt/e/code/hpl-ai-finalist/hpl-ai.c -c -o hpl-ai.o
+    -fplugin=~/opt/AMP/AutoMxPrecPlugin/build/plugin/AutoMxPrec.so \
+    -Xclang -plugin-arg-auto-mxprec-plugin -Xclang output.json /mnt/e/code/hpl-ai-finalist/hpl-ai.c -g -emit-llvm -S -o hpl-ai.ll
 
-json格式：
+插件在代码生成之前运行，带子句的 pragma 会以 annotate 属性写入 IR，
+再由 MixPrecision 的 pragma-metadata pass 转成指令上的元数据（需要 -g）：
+#pragma AutoMxPrec precision(float)          区域内变量与运算降为 float
+#pragma AutoMxPrec precision(half, storage)  区域内变量只降存储精度
+#pragma AutoMxPrec keep(x, y)                区域内引用的 x、y 固定为原精度
+
+-plugin-arg 为目录时，每个翻译单元输出 <目录>/<源文件名>.mxprec.json。
+再加 -plugin-arg-auto-mxprec-plugin facts=<文件或目录> 输出变量事实（<源文件名>.facts.json），
+由 create-config 的 -facts 选项合并进配置：
+{"file": "gmres.c", "functions": {"gmres": {"x": {"type": "double *", "param": true,
+  "elementType": "double", "loopDepth": 0, "maxUseLoopDepth": 2, "escapes": false,
+  "begin": {"line": 10, "col": 12}, "end": {"line": 10, "col": 20}}}}}
+
+json格式（region 按进入顺序输出，嵌套区域带 parent 与 depth）：
 [
+  {
+    "type": "region",
+    "id": "hpl-ai.c:120",
+    "func": "MxHPLTest",
+    "file": "hpl-ai.c",
+    "begin": {"line": 121, "col": 5},
+    "end": {"line": 140, "col": 5},
+    "depth": 0,
+    "parent": null,
+    "precision": "float",
+    "mode": "full"
+  },
   {
     "name": "fclose",
+    "region": "hpl-ai.c:120",
     "type": "call"
   },
   {
@@ -23,12 +49,17 @@ json格式：
 ]
 */
 #include "clang/AST/ASTConsumer.h"
+#include "clang/AST/Attr.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
 #include "clang/Lex/Preprocessor.h"
-#include "clang/Lex/Lexer.h"
 #include "nlohmann/json.hpp"
+#include "clang/AST/ParentMapContext.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
+#include <map>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -38,13 +69,101 @@ using json = nlohmann::json;
 
 namespace {
 
-static std::vector<SourceLocation> GlobalPragmaLocs;
+// 与 MixPrecision/include/pragma_metadata.hpp 中的解析保持一致
+static const char *RegionAnnotation = "automxprec.region";
+static const char *KeepAnnotation = "automxprec.keep";
+
+struct PragmaInfo {
+    SourceLocation Loc;          // AutoMxPrec 标识符的位置
+    unsigned EndOffset = 0;      // pragma 行尾在文件中的偏移，用于判断与 '{' 是否相邻
+    std::string Precision;       // 空串表示未指定 precision 子句
+    bool StorageOnly = false;
+    std::vector<std::string> Keep;
+};
+
+// 按 FileID 分组、组内按偏移升序的 pragma 索引
+static std::map<FileID, std::vector<PragmaInfo>> PragmaIndex;
 
 class AutoMxPrecPragmaHandler : public PragmaHandler {
 public:
     AutoMxPrecPragmaHandler() : PragmaHandler("AutoMxPrec") {}
     void HandlePragma(Preprocessor &PP, PragmaIntroducer, Token &Tok) override {
-        GlobalPragmaLocs.push_back(Tok.getLocation());
+        PragmaInfo Info;
+        Info.Loc = Tok.getLocation();
+
+        PP.Lex(Tok);
+        while (Tok.isNot(tok::eod)) {
+            IdentifierInfo *Clause = Tok.getIdentifierInfo();
+            if (!Clause || (!Clause->isStr("precision") && !Clause->isStr("keep"))) {
+                warn(PP, Tok.getLocation(), "unknown clause, expected 'precision' or 'keep'");
+                break;
+            }
+            SourceLocation ClauseLoc = Tok.getLocation();
+
+            std::vector<std::string> Args;
+            if (!lexArgs(PP, Tok, Args)) {
+                warn(PP, ClauseLoc, "malformed clause argument list");
+                break;
+            }
+
+            if (Clause->isStr("keep")) {
+                Info.Keep.insert(Info.Keep.end(), Args.begin(), Args.end());
+                continue;
+            }
+
+            Info.Precision = Args.empty() ? "" : normalizePrecision(Args[0]);
+            if (Info.Precision.empty()) {
+                warn(PP, ClauseLoc, "precision expects double, float or half");
+            }
+            if (Args.size() > 1) {
+                if (Args[1] == "storage") {
+                    Info.StorageOnly = true;
+                } else {
+                    warn(PP, ClauseLoc, "unknown precision mode, expected 'storage'");
+                }
+            }
+        }
+
+        // 出错时丢弃本行剩余部分，保证 EndOffset 指向行尾
+        while (Tok.isNot(tok::eod)) PP.Lex(Tok);
+        auto [FID, Offset] = PP.getSourceManager().getDecomposedExpansionLoc(Tok.getLocation());
+        Info.EndOffset = Offset;
+
+        // 同一文件内按词法顺序到达，通常直接追加在末尾
+        auto &Pragmas = PragmaIndex[FID];
+        auto Pos = std::upper_bound(Pragmas.begin(), Pragmas.end(), Offset,
+            [](unsigned Off, const PragmaInfo &P) { return Off < P.EndOffset; });
+        Pragmas.insert(Pos, Info);
+    }
+
+private:
+    // 读取 '(' a, b, ... ')'，double/float 等关键字同样有 IdentifierInfo
+    static bool lexArgs(Preprocessor &PP, Token &Tok, std::vector<std::string> &Args) {
+        PP.Lex(Tok);
+        if (Tok.isNot(tok::l_paren)) return false;
+        PP.Lex(Tok);
+        while (Tok.isNot(tok::r_paren)) {
+            if (IdentifierInfo *Arg = Tok.getIdentifierInfo()) {
+                Args.push_back(Arg->getName().str());
+            } else if (Tok.isNot(tok::comma)) {
+                return false;
+            }
+            PP.Lex(Tok);
+        }
+        PP.Lex(Tok);
+        return true;
+    }
+
+    static std::string normalizePrecision(const std::string &Name) {
+        if (Name == "double" || Name == "float") return Name;
+        if (Name == "half" || Name == "_Float16" || Name == "__fp16") return "half";
+        return "";
+    }
+
+    static void warn(Preprocessor &PP, SourceLocation Loc, StringRef Msg) {
+        DiagnosticsEngine &Diags = PP.getDiagnostics();
+        unsigned ID = Diags.getCustomDiagID(DiagnosticsEngine::Warning, "#pragma AutoMxPrec: %0");
+        Diags.Report(Loc, ID) << Msg;
     }
 };
 
@@ -53,51 +172,47 @@ public:
     AutoMxPrecVisitor(ASTContext &Ctx)
         : Context(Ctx), SM(Ctx.getSourceManager()), LangOpts(Ctx.getLangOpts()) {}
 
-    bool VisitFunctionDecl(FunctionDecl *FD) {
-        if (FD->hasBody()) {
-            CurrentFuncName = FD->getNameAsString();
-        }
-        return true;
-    }
-
-    bool VisitCompoundStmt(CompoundStmt *CS) {
-        SourceLocation StartLoc = CS->getBeginLoc();
-        if (InsideTargetBlock) return true;
+    // 命中 pragma 的复合语句在遍历子节点前入栈、遍历后出栈，嵌套区域因此都能被记录
+    bool TraverseCompoundStmt(CompoundStmt *CS) {
+        const PragmaInfo *Pragma = findPragma(CS);
+        if (!Pragma) return RecursiveASTVisitor::TraverseCompoundStmt(CS);
 
-        for (auto PragmaLoc : GlobalPragmaLocs) {
-            if (!SM.isWrittenInSameFile(PragmaLoc, StartLoc)) continue;
-            if (SM.isBeforeInTranslationUnit(PragmaLoc, StartLoc) &&
-                areLocationsAdjacent(PragmaLoc, StartLoc)) {
+        pushRegion(*Pragma, CS);
+        bool Result = RecursiveASTVisitor::TraverseCompoundStmt(CS);
+        Regions.pop_back();
+        return Result;
+    }
 
-                InsideTargetBlock = true;
-                TraverseStmt(CS);
-                InsideTargetBlock = false;
-                break;
-            }
+    bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+        if (Regions.empty()) return true;
+        if (auto *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+            annotateKeep(VD);
         }
         return true;
     }
 
     bool VisitCallExpr(CallExpr *CE) {
-        if (!InsideTargetBlock) return true;
+        if (Regions.empty()) return true;
         if (auto *FD = CE->getDirectCallee()) {
             json callObj;
             callObj["type"] = "call";
             callObj["name"] = FD->getNameAsString();
+            callObj["region"] = Regions.back().Id;
             Data.push_back(callObj);
         }
         return true;
     }
 
     bool VisitDeclStmt(DeclStmt *DS) {
-        if (!InsideTargetBlock) return true;
+        if (Regions.empty()) return true;
         for (auto *D : DS->decls()) {
             if (auto *VD = dyn_cast<VarDecl>(D)) {
                 if (VD->isLocalVarDecl() && !VD->isImplicit()) {
+                    annotateKeep(VD);
                     json varObj;
                     varObj["type"] = "var";
                     varObj["name"] = VD->getNameAsString();
-                    varObj["func"] = CurrentFuncName;
+                    varObj["func"] = Regions.back().Func ? Regions.back().Func->getNameAsString() : "";
                     //只有automix中的tol变量，这个变量需要过滤掉
                     // Data.push_back(varObj);
                 }
@@ -109,56 +224,330 @@ public:
     const json &getData() const { return Data; }
 
 private:
+    struct ActiveRegion {
+        std::string Id;
+        const PragmaInfo *Pragma;
+        FunctionDecl *Func;
+    };
+
     ASTContext &Context;
     SourceManager &SM;
     const LangOptions &LangOpts;
-    bool InsideTargetBlock = false;
-    std::string CurrentFuncName;
+    std::vector<ActiveRegion> Regions;
     json Data = json::array();
 
-    bool areLocationsAdjacent(SourceLocation PragmaLoc, SourceLocation BraceLoc) {
-        SourceLocation PragmaEnd = Lexer::getLocForEndOfToken(PragmaLoc, 0, SM, LangOpts);
+    // 在 '{' 所在文件的 pragma 索引中二分查找它之前最近的一个 pragma，
+    // 两者之间只有空白时才算命中，不需要重新词法分析
+    const PragmaInfo *findPragma(CompoundStmt *CS) {
+        auto [FID, Offset] = SM.getDecomposedExpansionLoc(CS->getBeginLoc());
+        auto It = PragmaIndex.find(FID);
+        if (It == PragmaIndex.end()) return nullptr;
+
+        const auto &Pragmas = It->second;
+        auto Next = std::upper_bound(Pragmas.begin(), Pragmas.end(), Offset,
+            [](unsigned Off, const PragmaInfo &P) { return Off < P.EndOffset; });
+        if (Next == Pragmas.begin()) return nullptr;
+        const PragmaInfo &Pragma = *std::prev(Next);
+
         bool Invalid = false;
-        CharSourceRange Range = CharSourceRange::getCharRange(PragmaEnd, BraceLoc);
-        StringRef Text = Lexer::getSourceText(Range, SM, LangOpts, &Invalid);
-        if (Invalid) return false;
-        return Text.trim().empty();
+        StringRef Buffer = SM.getBufferData(FID, &Invalid);
+        if (Invalid || Offset > Buffer.size()) return nullptr;
+        StringRef Between = Buffer.slice(Pragma.EndOffset, Offset);
+        return Between.find_first_not_of(" \t\r\n\f\v") == StringRef::npos ? &Pragma : nullptr;
+    }
+
+    // 沿 AST 父节点向上找到真正包含该语句的函数
+    FunctionDecl *enclosingFunction(const Stmt *S) {
+        DynTypedNodeList Parents = Context.getParents(*S);
+        while (!Parents.empty()) {
+            if (const auto *FD = Parents[0].get<FunctionDecl>()) {
+                return const_cast<FunctionDecl *>(FD);
+            }
+            Parents = Context.getParents(Parents[0]);
+        }
+        return nullptr;
+    }
+
+    void pushRegion(const PragmaInfo &Pragma, CompoundStmt *CS) {
+        FunctionDecl *Func = enclosingFunction(CS);
+        PresumedLoc PragmaPos = SM.getPresumedLoc(SM.getExpansionLoc(Pragma.Loc));
+        PresumedLoc Begin = SM.getPresumedLoc(SM.getExpansionLoc(CS->getBeginLoc()));
+        PresumedLoc End = SM.getPresumedLoc(SM.getExpansionLoc(CS->getEndLoc()));
+
+        std::string Id;
+        if (PragmaPos.isValid()) {
+            Id = llvm::sys::path::filename(PragmaPos.getFilename()).str() + ":" +
+                 std::to_string(PragmaPos.getLine());
+        }
+
+        json regionObj;
+        regionObj["type"] = "region";
+        regionObj["id"] = Id;
+        regionObj["func"] = Func ? Func->getNameAsString() : "";
+        regionObj["depth"] = Regions.size();
+        regionObj["parent"] = Regions.empty() ? json(nullptr) : json(Regions.back().Id);
+        if (Begin.isValid() && End.isValid()) {
+            regionObj["file"] = Begin.getFilename();
+            regionObj["begin"] = {{"line", Begin.getLine()}, {"col", Begin.getColumn()}};
+            regionObj["end"] = {{"line", End.getLine()}, {"col", End.getColumn()}};
+        }
+        if (!Pragma.Precision.empty()) {
+            regionObj["precision"] = Pragma.Precision;
+            regionObj["mode"] = Pragma.StorageOnly ? "storage" : "full";
+        }
+        if (!Pragma.Keep.empty()) {
+            regionObj["keep"] = Pragma.Keep;
+        }
+        Data.push_back(regionObj);
+
+        if (Func && Begin.isValid() && End.isValid()) {
+            annotateRegion(Pragma, Id, Func, Begin, End);
+        }
+        Regions.push_back({Id, &Pragma, Func});
+    }
+
+    // 每个区域编码为函数上的 annotate 属性，CodeGen 会把它放进 llvm.global.annotations：
+    // automxprec.region;id=<file>:<line>;begin=<line>:<col>;end=<line>:<col>[;precision=<ty>;mode=<full|storage>]
+    // 没有 precision 子句的区域（HPL-AI 中的裸 #pragma AutoMxPrec）只用于计时等，不降精
+    void annotateRegion(const PragmaInfo &Pragma, const std::string &Id, FunctionDecl *Func,
+                        const PresumedLoc &Begin, const PresumedLoc &End) {
+        std::string Annotation = std::string(RegionAnnotation) +
+            ";id=" + Id +
+            ";begin=" + std::to_string(Begin.getLine()) + ":" + std::to_string(Begin.getColumn()) +
+            ";end=" + std::to_string(End.getLine()) + ":" + std::to_string(End.getColumn());
+        if (!Pragma.Precision.empty()) {
+            Annotation += ";precision=" + Pragma.Precision + ";mode=" + (Pragma.StorageOnly ? "storage" : "full");
+        }
+        Func->addAttr(AnnotateAttr::CreateImplicit(Context, Annotation, nullptr, 0));
+    }
+
+    // keep 子句中的变量打上 annotate，CodeGen 会在其 alloca 上生成 llvm.var.annotation；
+    // 外层区域的 keep 对嵌套区域同样有效。
+    // 文件作用域的全局变量在遇到 pragma 之前就已交给 CodeGen，加在它上面的属性进不了 IR，
+    // 改为在当前函数（函数体尚未生成）上加 automxprec.keep;global=<名字>，由 pragma-metadata 按名字找回
+    void annotateKeep(VarDecl *VD) {
+        QualType Ty = VD->getType();
+        if (!Ty->isRealFloatingType() && !Ty->isPointerType() && !Ty->isArrayType()) return;
+
+        bool Kept = std::any_of(Regions.begin(), Regions.end(), [&](const ActiveRegion &R) {
+            const auto &Keep = R.Pragma->Keep;
+            return std::find(Keep.begin(), Keep.end(), VD->getName()) != Keep.end();
+        });
+        if (!Kept) return;
+        if (VD->isFileVarDecl()) {
+            FunctionDecl *Func = Regions.back().Func;
+            if (!Func) return;
+            std::string Annotation = std::string(KeepAnnotation) + ";global=" + VD->getName().str();
+            for (const auto *Attr : Func->specific_attrs<AnnotateAttr>()) {
+                if (Attr->getAnnotation() == Annotation) return;
+            }
+            Func->addAttr(AnnotateAttr::CreateImplicit(Context, Annotation, nullptr, 0));
+            return;
+        }
+        for (const auto *Attr : VD->specific_attrs<AnnotateAttr>()) {
+            if (Attr->getAnnotation() == KeepAnnotation) return;
+        }
+        VD->addAttr(AnnotateAttr::CreateImplicit(Context, KeepAnnotation, nullptr, 0));
+    }
+};
+
+// 前端变量事实，弥补 IR 符号表里参数变成 x.addr、数组维度藏在指针后面等信息缺失：
+// {"file": ..., "functions": {"<函数名，全局变量为空串>": {"<变量名>": {...}}}}
+class VarFactsVisitor : public RecursiveASTVisitor<VarFactsVisitor> {
+public:
+    VarFactsVisitor(ASTContext &Ctx) : Context(Ctx), SM(Ctx.getSourceManager()) {}
+
+    bool TraverseFunctionDecl(FunctionDecl *FD) {
+        if (!FD->doesThisDeclarationHaveABody() || !SM.isInMainFile(FD->getLocation())) return true;
+        CurrentFunc = FD->getNameAsString();
+        bool Result = RecursiveASTVisitor::TraverseFunctionDecl(FD);
+        CurrentFunc.clear();
+        return Result;
+    }
+
+    bool TraverseForStmt(ForStmt *S) { return traverseLoop([&] { return RecursiveASTVisitor::TraverseForStmt(S); }); }
+    bool TraverseWhileStmt(WhileStmt *S) { return traverseLoop([&] { return RecursiveASTVisitor::TraverseWhileStmt(S); }); }
+    bool TraverseDoStmt(DoStmt *S) { return traverseLoop([&] { return RecursiveASTVisitor::TraverseDoStmt(S); }); }
+
+    bool VisitVarDecl(VarDecl *VD) {
+        if (VD->isImplicit() || !SM.isInMainFile(VD->getLocation())) return true;
+        std::string Func = VD->isFileVarDecl() ? "" : CurrentFunc;
+        if (!VD->isFileVarDecl() && Func.empty()) return true;
+
+        // IR 中同名变量第二次出现时会被重命名，只记录第一次声明
+        json &Vars = Facts[Func];
+        std::string Name = VD->getNameAsString();
+        if (Vars.contains(Name)) return true;
+
+        json Entry;
+        Entry["type"] = VD->getType().getAsString();
+        Entry["param"] = isa<ParmVarDecl>(VD);
+
+        std::vector<uint64_t> Extent;
+        QualType Element = VD->getType();
+        while (const ConstantArrayType *CAT = Context.getAsConstantArrayType(Element)) {
+            Extent.push_back(CAT->getSize().getZExtValue());
+            Element = CAT->getElementType();
+        }
+        if (!Extent.empty()) Entry["extent"] = Extent;
+        if (Element->isPointerType()) Element = Element->getPointeeType();
+        Entry["elementType"] = Element.getUnqualifiedType().getAsString();
+
+        Entry["loopDepth"] = LoopDepth;
+        Entry["maxUseLoopDepth"] = LoopDepth;
+        Entry["escapes"] = false;
+
+        PresumedLoc Begin = SM.getPresumedLoc(SM.getExpansionLoc(VD->getBeginLoc()));
+        PresumedLoc End = SM.getPresumedLoc(SM.getExpansionLoc(VD->getEndLoc()));
+        if (Begin.isValid() && End.isValid()) {
+            Entry["begin"] = {{"line", Begin.getLine()}, {"col", Begin.getColumn()}};
+            Entry["end"] = {{"line", End.getLine()}, {"col", End.getColumn()}};
+        }
+
+        Vars[Name] = Entry;
+        Keys[VD] = {Func, Name};
+        return true;
+    }
+
+    bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+        if (json *Entry = lookup(DRE->getDecl())) {
+            unsigned Depth = (*Entry)["maxUseLoopDepth"];
+            (*Entry)["maxUseLoopDepth"] = std::max(Depth, LoopDepth);
+        }
+        return true;
+    }
+
+    // &x、&a[i] 都会把变量地址传出去
+    bool VisitUnaryOperator(UnaryOperator *UO) {
+        if (UO->getOpcode() != UO_AddrOf) return true;
+        Expr *E = UO->getSubExpr()->IgnoreParenImpCasts();
+        while (auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) E = ASE->getBase()->IgnoreParenImpCasts();
+        if (auto *DRE = dyn_cast<DeclRefExpr>(E)) {
+            if (json *Entry = lookup(DRE->getDecl())) (*Entry)["escapes"] = true;
+        }
+        return true;
+    }
+
+    bool VisitArraySubscriptExpr(ArraySubscriptExpr *ASE) {
+        if (auto *DRE = dyn_cast<DeclRefExpr>(ASE->getBase()->IgnoreParenImpCasts())) ++Subscripts[DRE->getDecl()];
+        return true;
+    }
+
+    bool VisitImplicitCastExpr(ImplicitCastExpr *ICE) {
+        if (ICE->getCastKind() != CK_ArrayToPointerDecay) return true;
+        if (auto *DRE = dyn_cast<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens())) ++Decays[DRE->getDecl()];
+        return true;
+    }
+
+    json getFacts() {
+        // 数组除了下标访问以外还退化成了指针，说明数组地址被传出
+        for (const auto &[D, Count] : Decays) {
+            if (Count > Subscripts[D]) {
+                if (json *Entry = lookup(D)) (*Entry)["escapes"] = true;
+            }
+        }
+        json Result;
+        const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID());
+        Result["file"] = Main ? Main->getName().str() : "";
+        Result["functions"] = Facts;
+        return Result;
+    }
+
+private:
+    ASTContext &Context;
+    SourceManager &SM;
+    std::string CurrentFunc;
+    unsigned LoopDepth = 0;
+    json Facts = json::object();
+    std::map<const Decl *, std::pair<std::string, std::string>> Keys;
+    std::map<const Decl *, unsigned> Subscripts;
+    std::map<const Decl *, unsigned> Decays;
+
+    template <typename Fn> bool traverseLoop(Fn Traverse) {
+        ++LoopDepth;
+        bool Result = Traverse();
+        --LoopDepth;
+        return Result;
+    }
+
+    json *lookup(const Decl *D) {
+        auto It = Keys.find(D);
+        return It == Keys.end() ? nullptr : &Facts[It->second.first][It->second.second];
     }
 };
 
+// 输出路径是目录时每个翻译单元写一个 <源文件名><后缀> 文件，便于在整个工程的构建中启用
+static std::string outputFileFor(const std::string &OutputPath, SourceManager &SM, StringRef Suffix) {
+    if (!llvm::sys::fs::is_directory(OutputPath)) return OutputPath;
+    const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID());
+    llvm::SmallString<256> File(OutputPath);
+    llvm::sys::path::append(File, llvm::sys::path::filename(Main ? Main->getName() : "stdin") + Suffix);
+    return File.str().str();
+}
+
 class AutoMxPrecASTConsumer : public ASTConsumer {
 public:
-    AutoMxPrecASTConsumer(ASTContext &Context, const std::string &outputPath)
-        : Visitor(Context), OutputPath(outputPath) {}
+    AutoMxPrecASTConsumer(ASTContext &Context, const std::string &outputPath, const std::string &factsPath)
+        : Context(Context), Visitor(Context), OutputPath(outputPath), FactsPath(factsPath) {}
 
-    void HandleTranslationUnit(ASTContext &Context) override {
-        Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+    // 注解必须在 CodeGen 处理同一个顶层声明之前加上，所以逐个顶层声明遍历；
+    // 父节点表只针对当前声明建立，避免每次都重建整个翻译单元的表
+    bool HandleTopLevelDecl(DeclGroupRef DG) override {
+        if (PragmaIndex.empty()) return true;
+        for (Decl *D : DG) {
+            Context.setTraversalScope({D});
+            Visitor.TraverseDecl(D);
+        }
+        return true;
+    }
+
+    void HandleTranslationUnit(ASTContext &Ctx) override {
+        Ctx.setTraversalScope({Ctx.getTranslationUnitDecl()});
+        SourceManager &SM = Ctx.getSourceManager();
         if (!OutputPath.empty()) {
-            std::ofstream outFile(OutputPath);
+            std::ofstream outFile(outputFileFor(OutputPath, SM, ".mxprec.json"));
             outFile << Visitor.getData().dump(2) << "\n";
         } else {
             llvm::outs() << Visitor.getData().dump(2) << "\n";
         }
+
+        if (!FactsPath.empty()) {
+            VarFactsVisitor Facts(Ctx);
+            Facts.TraverseDecl(Ctx.getTranslationUnitDecl());
+            std::ofstream factsFile(outputFileFor(FactsPath, SM, ".facts.json"));
+            factsFile << Facts.getFacts().dump(2) << "\n";
+        }
     }
 
 private:
+    ASTContext &Context;
     AutoMxPrecVisitor Visitor;
     std::string OutputPath;
+    std::string FactsPath;
 };
 
 class AutoMxPrecPluginAction : public PluginASTAction {
 public:
     std::string OutputPath;
+    std::string FactsPath;
+
+    // 与主编译动作一起运行，pragma 注解才能进入生成的 IR
+    ActionType getActionType() override { return AddBeforeMainAction; }
 
 protected:
     std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef) override {
         CI.getPreprocessor().AddPragmaHandler(new AutoMxPrecPragmaHandler());
-        return std::make_unique<AutoMxPrecASTConsumer>(CI.getASTContext(), OutputPath);
+        return std::make_unique<AutoMxPrecASTConsumer>(CI.getASTContext(), OutputPath, FactsPath);
     }
 
     bool ParseArgs(const CompilerInstance &, const std::vector<std::string> &args) override {
-        if (!args.empty()) {
-            OutputPath = args[0]; // 第一个参数作为输出路径
+        for (const auto &arg : args) {
+            StringRef Arg(arg);
+            if (Arg.consume_front("facts=")) {
+                FactsPath = Arg.str(); // 变量事实文件（或目录）
+            } else if (OutputPath.empty()) {
+                OutputPath = arg; // 第一个普通参数作为输出路径
+            }
         }
         return true;
     }
@@ -167,4 +556,4 @@ protected:
 }
 
 static FrontendPluginRegistry::Add<AutoMxPrecPluginAction>
-X("auto-mxprec-plugin", "Extract calls and variables from #pragma AutoMxPrec blocks");
+X("auto-mxprec-plugin", "Extract calls and variables from #pragma AutoMxPrec blocks and annotate their precision clauses");
@@ -0,0 +1,482 @@
+/*
+
+源码到源码的降精改写，与 MixPrecision 使用同一份配置 json，输出可直接用 -O2/-O3 编译的 C 源码：
+clang --target=aarch64-linux-gnu -march=armv8.2-a+fp16 \
+    -Xclang -load -Xclang ~/opt/AMP/AutoMxPrecPlugin/build/plugin/AutoMxPrec.so \
+    -Xclang -plugin -Xclang auto-mxprec-rewrite \
+    -Xclang -plugin-arg-auto-mxprec-rewrite -Xclang config.json \
+    -Xclang -plugin-arg-auto-mxprec-rewrite -Xclang gmres.mxprec.c \
+    -fsyntax-only /mnt/e/code/hpl-ai-finalist/gmres.c
+
+支持的配置项：
+  localVar  {"name", "function", "type"}  局部变量 / 标量参数（仅 static 函数）/ 局部数组
+  globalVar {"name", "type"}              全局标量 / 数组
+  call      {"name", "function", "switch"} 把 function 中对 name 的调用换成 switch
+只改写地址不逃逸的变量：指针变量、数组退化为指针后传出的变量、被取地址（&x、&a[i]）或绑定到引用的变量
+需要同时改指向它们的指针，仍交给 IR 流程处理，这里给出警告后跳过。
+*/
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Rewrite/Core/Rewriter.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using json = nlohmann::json;
+
+namespace {
+
+struct RewriteConfig {
+    // name@function -> 目标类型，全局变量的 function 为空
+    std::map<std::string, std::string> Vars;
+    // function -> (原函数名 -> 替换函数名)
+    std::map<std::string, std::map<std::string, std::string>> Calls;
+};
+
+// 配置里的类型串形如 "float"、"half"、"[100 x float]"，只关心其中的浮点基本类型
+static std::string toSourceType(const std::string &Type) {
+    if (Type.find("half") != std::string::npos) return "_Float16";
+    if (Type.find("float") != std::string::npos) return "float";
+    return "";
+}
+
+static bool loadConfig(const std::string &Path, RewriteConfig &Config) {
+    std::ifstream File(Path);
+    if (!File.is_open()) return false;
+
+    json Root;
+    try {
+        File >> Root;
+    } catch (const std::exception &) {
+        return false;
+    }
+    if (Root.contains("config")) Root = Root["config"];
+
+    auto typeOf = [](const json &Entry) {
+        const json &Type = Entry.value("type", json(""));
+        return toSourceType(Type.is_array() && !Type.empty() ? Type[0].dump() : Type.dump());
+    };
+
+    for (const char *Section : {"localVar", "globalVar"}) {
+        if (!Root.contains(Section)) continue;
+        for (const auto &Entry : Root[Section]) {
+            std::string Type = typeOf(Entry);
+            if (Type.empty()) continue;
+            Config.Vars[Entry.value("name", "") + "@" + Entry.value("function", "")] = Type;
+        }
+    }
+
+    if (Root.contains("call")) {
+        for (const auto &Entry : Root["call"]) {
+            std::string Name = Entry.value("name", "");
+            std::string Switch = Entry.value("switch", Name);
+            if (!Name.empty() && Switch != Name) {
+                Config.Calls[Entry.value("function", "")][Name] = Switch;
+            }
+        }
+    }
+    return true;
+}
+
+// 有单精度版本的 libm 函数，参数都已降精时换成 f 版本
+static const std::set<std::string> LibmFunctions = {
+    "sqrt", "fabs", "exp", "exp2", "expm1", "log", "log2", "log10", "log1p", "pow",
+    "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sinh", "cosh", "tanh",
+    "floor", "ceil", "trunc", "round", "fmod", "fma", "fmin", "fmax", "copysign",
+    "hypot", "cbrt",
+};
+
+// 第一遍：收集配置命中的声明、共享类型说明符的声明组以及地址逃逸的变量
+class DeclCollector : public RecursiveASTVisitor<DeclCollector> {
+public:
+    DeclCollector(SourceManager &SM) : SM(SM) {}
+
+    bool VisitVarDecl(VarDecl *VD) {
+        if (!SM.isInMainFile(VD->getLocation()) || VD->isImplicit()) return true;
+
+        std::string Func;
+        if (auto *FD = dyn_cast_or_null<FunctionDecl>(VD->getParentFunctionOrMethod())) {
+            Func = FD->getNameAsString();
+        }
+        // IR 中同名变量第二次出现时会被重命名，配置里的名字对应第一次声明
+        First.emplace(VD->getNameAsString() + "@" + Func, VD);
+
+        if (VD->getTypeSourceInfo()) {
+            Specifiers[VD->getTypeSpecStartLoc().getRawEncoding()].push_back(VD);
+        }
+        if (VD->getType()->isReferenceType() && VD->hasInit()) {
+            if (auto *Target = getAddressedVar(VD->getInit())) AddressTaken.insert(Target);
+        }
+        return true;
+    }
+
+    bool VisitUnaryOperator(UnaryOperator *UO) {
+        if (UO->getOpcode() == UO_AddrOf) {
+            if (auto *VD = getAddressedVar(UO->getSubExpr())) AddressTaken.insert(VD);
+        }
+        return true;
+    }
+
+    // 实参绑定到引用形参同样把地址传了出去
+    bool VisitCallExpr(CallExpr *CE) {
+        auto *FD = CE->getDirectCallee();
+        if (!FD) return true;
+        for (unsigned I = 0, N = std::min(CE->getNumArgs(), FD->getNumParams()); I < N; ++I) {
+            if (!FD->getParamDecl(I)->getType()->isReferenceType()) continue;
+            if (auto *VD = getAddressedVar(CE->getArg(I))) AddressTaken.insert(VD);
+        }
+        return true;
+    }
+
+    bool VisitArraySubscriptExpr(ArraySubscriptExpr *ASE) {
+        if (auto *VD = getArrayVar(ASE->getBase())) ++Subscripts[VD];
+        return true;
+    }
+
+    bool VisitImplicitCastExpr(ImplicitCastExpr *ICE) {
+        if (ICE->getCastKind() == CK_ArrayToPointerDecay) {
+            if (auto *VD = getArrayVar(ICE)) ++Decays[VD];
+        }
+        return true;
+    }
+
+    VarDecl *find(const std::string &Id) const {
+        auto It = First.find(Id);
+        return It == First.end() ? nullptr : It->second;
+    }
+
+    const std::vector<VarDecl *> &sharing(VarDecl *VD) {
+        return Specifiers[VD->getTypeSpecStartLoc().getRawEncoding()];
+    }
+
+    // 被取地址或绑定到引用，或者除下标访问以外还有退化为指针的使用，说明地址被传出
+    bool escapes(VarDecl *VD) const {
+        if (AddressTaken.count(VD)) return true;
+        auto D = Decays.find(VD);
+        if (D == Decays.end()) return false;
+        auto S = Subscripts.find(VD);
+        return D->second > (S == Subscripts.end() ? 0 : S->second);
+    }
+
+private:
+    SourceManager &SM;
+    std::map<std::string, VarDecl *> First;
+    std::map<SourceLocation::UIntTy, std::vector<VarDecl *>> Specifiers;
+    std::map<VarDecl *, unsigned> Subscripts;
+    std::map<VarDecl *, unsigned> Decays;
+    std::set<VarDecl *> AddressTaken;
+
+    static VarDecl *getArrayVar(Expr *E) {
+        E = E->IgnoreParenImpCasts();
+        auto *DRE = dyn_cast<DeclRefExpr>(E);
+        auto *VD = DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+        return VD && VD->getType()->isArrayType() ? VD : nullptr;
+    }
+
+    // &x、&a[i][j] 取到的变量
+    static VarDecl *getAddressedVar(Expr *E) {
+        E = E->IgnoreParenImpCasts();
+        while (auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) E = ASE->getBase()->IgnoreParenImpCasts();
+        auto *DRE = dyn_cast<DeclRefExpr>(E);
+        return DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+    }
+};
+
+// 第二遍：在声明改写完成后补齐边界上的显式转换、浮点字面量后缀和 libm 调用
+class BoundaryRewriter : public RecursiveASTVisitor<BoundaryRewriter> {
+public:
+    BoundaryRewriter(Rewriter &R, const std::map<const VarDecl *, std::string> &Lowered,
+                     const RewriteConfig &Config)
+        : R(R), SM(R.getSourceMgr()), Lowered(Lowered), Config(Config) {}
+
+    bool TraverseFunctionDecl(FunctionDecl *FD) {
+        CurrentFunc = FD->getNameAsString();
+        return RecursiveASTVisitor::TraverseFunctionDecl(FD);
+    }
+
+    // 向降精变量赋值时显式截断
+    bool VisitBinaryOperator(BinaryOperator *BO) {
+        if (!isRewritable(BO->getBeginLoc())) return true;
+
+        if (BO->getOpcode() == BO_Assign) {
+            if (const std::string *Type = loweredType(BO->getLHS())) {
+                castTo(BO->getRHS(), *Type);
+            }
+            return true;
+        }
+
+        // 降精操作数与 double 字面量运算时加后缀，避免整条表达式被提升回 double
+        if (BO->isAdditiveOp() || BO->isMultiplicativeOp() || BO->isComparisonOp() ||
+            BO->isCompoundAssignmentOp()) {
+            const std::string *Type = loweredType(BO->getLHS());
+            if (!Type) Type = loweredType(BO->getRHS());
+            if (Type) {
+                suffixLiteral(BO->getLHS(), *Type);
+                suffixLiteral(BO->getRHS(), *Type);
+            }
+        }
+        return true;
+    }
+
+    bool VisitVarDecl(VarDecl *VD) {
+        auto It = Lowered.find(VD);
+        if (It != Lowered.end() && VD->hasInit() && !VD->getType()->isArrayType() &&
+            isRewritable(VD->getInit()->getBeginLoc())) {
+            castTo(VD->getInit(), It->second);
+        }
+        return true;
+    }
+
+    bool VisitCallExpr(CallExpr *CE) {
+        if (!isRewritable(CE->getBeginLoc())) return true;
+        FunctionDecl *Callee = CE->getDirectCallee();
+        if (!Callee) return true;
+
+        // 实参传给降精的形参
+        for (unsigned I = 0; I < CE->getNumArgs() && I < Callee->getNumParams(); ++I) {
+            auto It = Lowered.find(Callee->getParamDecl(I));
+            if (It != Lowered.end()) castTo(CE->getArg(I), It->second);
+        }
+
+        std::string Name = Callee->getNameAsString();
+        SourceLocation CalleeLoc = CE->getCallee()->IgnoreParenImpCasts()->getBeginLoc();
+        if (!isRewritable(CalleeLoc)) return true;
+
+        auto FuncCalls = Config.Calls.find(CurrentFunc);
+        if (FuncCalls != Config.Calls.end()) {
+            auto It = FuncCalls->second.find(Name);
+            if (It != FuncCalls->second.end()) {
+                R.ReplaceText(CalleeLoc, Name.size(), It->second);
+                return true;
+            }
+        }
+
+        // 只有实参读到降精变量时才换成 float 版本，sqrt(2.0) 这类纯字面量调用保持原精度
+        if (LibmFunctions.count(Name) && CE->getNumArgs() > 0 &&
+            std::all_of(CE->arg_begin(), CE->arg_end(), [&](Expr *Arg) { return isLoweredExpr(Arg); }) &&
+            std::any_of(CE->arg_begin(), CE->arg_end(), [&](Expr *Arg) { return readsLoweredVar(Arg); })) {
+            R.ReplaceText(CalleeLoc, Name.size(), Name + "f");
+            for (Expr *Arg : CE->arguments()) {
+                const std::string *Type = loweredType(Arg);
+                suffixLiteral(Arg, Type ? *Type : "float");
+            }
+        }
+        return true;
+    }
+
+private:
+    Rewriter &R;
+    SourceManager &SM;
+    const std::map<const VarDecl *, std::string> &Lowered;
+    const RewriteConfig &Config;
+    std::string CurrentFunc;
+    std::set<const Expr *> Suffixed;
+
+    bool isRewritable(SourceLocation Loc) const {
+        return Loc.isValid() && !Loc.isMacroID() && SM.isInMainFile(Loc);
+    }
+
+    const VarDecl *referencedVar(const Expr *E) const {
+        E = E->IgnoreParenImpCasts();
+        if (auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) E = ASE->getBase()->IgnoreParenImpCasts();
+        auto *DRE = dyn_cast<DeclRefExpr>(E);
+        return DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+    }
+
+    const std::string *loweredType(const Expr *E) const {
+        const VarDecl *VD = referencedVar(E);
+        auto It = VD ? Lowered.find(VD) : Lowered.end();
+        return It == Lowered.end() ? nullptr : &It->second;
+    }
+
+    // 表达式只由降精变量和字面量组成
+    bool isLoweredExpr(const Expr *E) const {
+        E = E->IgnoreParenImpCasts();
+        if (isa<FloatingLiteral>(E) || isa<IntegerLiteral>(E)) return true;
+        if (loweredType(E)) return true;
+        if (auto *BO = dyn_cast<BinaryOperator>(E)) {
+            return isLoweredExpr(BO->getLHS()) && isLoweredExpr(BO->getRHS());
+        }
+        if (auto *UO = dyn_cast<UnaryOperator>(E)) return isLoweredExpr(UO->getSubExpr());
+        return false;
+    }
+
+    bool readsLoweredVar(const Expr *E) const {
+        E = E->IgnoreParenImpCasts();
+        if (loweredType(E)) return true;
+        if (auto *BO = dyn_cast<BinaryOperator>(E)) {
+            return readsLoweredVar(BO->getLHS()) || readsLoweredVar(BO->getRHS());
+        }
+        if (auto *UO = dyn_cast<UnaryOperator>(E)) return readsLoweredVar(UO->getSubExpr());
+        return false;
+    }
+
+    void castTo(const Expr *E, const std::string &Type) {
+        const Expr *Inner = E->IgnoreParenImpCasts();
+        if (loweredType(Inner) || !isRewritable(E->getBeginLoc()) || !isRewritable(E->getEndLoc())) return;
+        if (suffixLiteral(E, Type)) return;
+        if (auto *CE = dyn_cast<CStyleCastExpr>(Inner)) {
+            if (CE->getTypeAsWritten().getAsString() == Type) return;
+        }
+        R.InsertTextBefore(E->getBeginLoc(), "(" + Type + ")(");
+        R.InsertTextAfterToken(E->getEndLoc(), ")");
+    }
+
+    bool suffixLiteral(const Expr *E, const std::string &Type) {
+        auto *Lit = dyn_cast<FloatingLiteral>(E->IgnoreParenImpCasts());
+        if (!Lit || !Lit->getType()->isSpecificBuiltinType(BuiltinType::Double)) return false;
+        if (!isRewritable(Lit->getLocation())) return false;
+        if (Suffixed.insert(Lit).second) {
+            R.InsertTextAfterToken(Lit->getLocation(), Type == "_Float16" ? "f16" : "f");
+        }
+        return true;
+    }
+};
+
+class AutoMxPrecRewriteConsumer : public ASTConsumer {
+public:
+    AutoMxPrecRewriteConsumer(CompilerInstance &CI, RewriteConfig Config, std::string OutputPath)
+        : CI(CI), Config(std::move(Config)), OutputPath(std::move(OutputPath)) {}
+
+    void HandleTranslationUnit(ASTContext &Context) override {
+        SourceManager &SM = Context.getSourceManager();
+        Rewriter R(SM, Context.getLangOpts());
+
+        DeclCollector Collector(SM);
+        Collector.TraverseDecl(Context.getTranslationUnitDecl());
+
+        std::map<const VarDecl *, std::string> Lowered;
+        for (const auto &[Id, Type] : Config.Vars) {
+            VarDecl *VD = Collector.find(Id);
+            if (!VD) continue;
+            if (retype(VD, Type, Collector, Config, R)) Lowered[VD] = Type;
+        }
+
+        BoundaryRewriter Boundary(R, Lowered, Config);
+        Boundary.TraverseDecl(Context.getTranslationUnitDecl());
+
+        const RewriteBuffer *Buffer = R.getRewriteBufferFor(SM.getMainFileID());
+        std::string Output = Buffer ? std::string(Buffer->begin(), Buffer->end())
+                                    : SM.getBufferData(SM.getMainFileID()).str();
+        if (OutputPath.empty()) {
+            llvm::outs() << Output;
+        } else {
+            std::ofstream(OutputPath) << Output;
+        }
+        llvm::errs() << "[AutoMxPrecRewrite] " << Lowered.size() << " declaration(s) lowered\n";
+    }
+
+private:
+    CompilerInstance &CI;
+    RewriteConfig Config;
+    std::string OutputPath;
+
+    void warn(SourceLocation Loc, StringRef Msg) {
+        DiagnosticsEngine &Diags = CI.getDiagnostics();
+        unsigned ID = Diags.getCustomDiagID(DiagnosticsEngine::Warning, "AutoMxPrec rewrite: %0");
+        Diags.Report(Loc, ID) << Msg;
+    }
+
+    // 把声明中的 double 说明符改成目标类型
+    bool retype(VarDecl *VD, const std::string &Type, DeclCollector &Collector,
+                const RewriteConfig &Config, Rewriter &R) {
+        TypeSourceInfo *TSI = VD->getTypeSourceInfo();
+        if (!TSI) return false;
+
+        QualType Ty = VD->getType();
+        if (Ty->isPointerType() || (Ty->isArrayType() && isa<ParmVarDecl>(VD)) || Collector.escapes(VD)) {
+            warn(VD->getLocation(), "pointer or escaping address needs the IR pipeline, '" +
+                                    VD->getName().str() + "' skipped");
+            return false;
+        }
+
+        // 形参所在函数另有原型声明时，改定义会与原型冲突；
+        // 外部可见的函数还会被其他翻译单元按 double 传参调用，改了形参就破坏了调用约定，只改 static 函数
+        if (auto *PVD = dyn_cast<ParmVarDecl>(VD)) {
+            auto *FD = dyn_cast_or_null<FunctionDecl>(PVD->getDeclContext());
+            if (!FD || FD->getPreviousDecl()) {
+                warn(VD->getLocation(), "function has a separate prototype, parameter '" +
+                                        VD->getName().str() + "' skipped");
+                return false;
+            }
+            if (FD->isExternallyVisible()) {
+                warn(VD->getLocation(), "function has external linkage, parameter '" +
+                                        VD->getName().str() + "' skipped (make it static to rewrite)");
+                return false;
+            }
+        }
+
+        TypeLoc TL = TSI->getTypeLoc();
+        while (true) {
+            if (auto QTL = TL.getAs<QualifiedTypeLoc>()) {
+                TL = QTL.getUnqualifiedLoc();
+            } else if (auto ATL = TL.getAs<ArrayTypeLoc>()) {
+                TL = ATL.getElementLoc();
+            } else {
+                break;
+            }
+        }
+        auto BTL = TL.getAs<BuiltinTypeLoc>();
+        if (!BTL || BTL.getTypePtr()->getKind() != BuiltinType::Double || BTL.getBeginLoc().isMacroID()) {
+            warn(VD->getLocation(), "only plain 'double' declarations can be rewritten, '" +
+                                    VD->getName().str() + "' skipped");
+            return false;
+        }
+
+        // "double a, b;" 共用一个说明符，只有整组目标类型一致时才能改
+        for (VarDecl *Other : Collector.sharing(VD)) {
+            std::string Func;
+            if (auto *FD = dyn_cast_or_null<FunctionDecl>(Other->getParentFunctionOrMethod())) {
+                Func = FD->getNameAsString();
+            }
+            auto It = Config.Vars.find(Other->getNameAsString() + "@" + Func);
+            if (Other != VD && (It == Config.Vars.end() || It->second != Type ||
+                                Collector.find(It->first) != Other)) {
+                warn(VD->getLocation(), "declaration group shares its type with '" +
+                                        Other->getName().str() + "', '" + VD->getName().str() + "' skipped");
+                return false;
+            }
+        }
+
+        if (!Rewritten.insert(BTL.getBeginLoc().getRawEncoding()).second) return true;
+        R.ReplaceText(BTL.getSourceRange(), Type);
+        return true;
+    }
+
+    std::set<SourceLocation::UIntTy> Rewritten;
+};
+
+class AutoMxPrecRewriteAction : public PluginASTAction {
+protected:
+    std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef) override {
+        return std::make_unique<AutoMxPrecRewriteConsumer>(CI, Config, OutputPath);
+    }
+
+    // 第一个参数为配置 json，第二个参数为输出文件（缺省输出到 stdout）
+    bool ParseArgs(const CompilerInstance &CI, const std::vector<std::string> &args) override {
+        if (args.empty() || !loadConfig(args[0], Config)) {
+            DiagnosticsEngine &Diags = CI.getDiagnostics();
+            Diags.Report(Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                                               "auto-mxprec-rewrite: cannot load config json"));
+            return false;
+        }
+        if (args.size() > 1) OutputPath = args[1];
+        return true;
+    }
+
+private:
+    RewriteConfig Config;
+    std::string OutputPath;
+};
+
+}
+
+static FrontendPluginRegistry::Add<AutoMxPrecRewriteAction>
+Y("auto-mxprec-rewrite", "Rewrite selected declarations and libm calls to lower precision at source level");
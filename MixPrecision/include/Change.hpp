@@ -14,6 +14,8 @@ class Change {
 public:
   Change(Types, Value*);
   Change(Types, Value*, int);
+  // name 为配置中的变量名；参数对应的 value 是 X.addr，名字与配置不同
+  Change(Types, Value*, int, string);
   
   Value* const getValue()const;
   
@@ -21,10 +23,14 @@ public:
   
   int getField()const;
 
+  // 配置中的变量名，未给出时取 value 的名字
+  string getName()const;
+
 protected:
   Value* const value;
   const Types type;
   const int field;
+  const string name;
 };
 
 
@@ -28,11 +28,14 @@ public:
 
 private:
   void initLoadFilters();
+  void loadFacts();
+  void mergeFacts(const std::string &function, const std::string &name, nlohmann::json &entry);
   bool runOnFunction(Function &function, raw_fd_ostream &outfile, bool &first) ;
 
   void collectGlobals(llvm::Module &M, nlohmann::json &arr);
   void collectLocals(llvm::Function &F, nlohmann::json &arr);
   void collectCalls(llvm::Function &F, nlohmann::json &arr);
+  void collectRegions(llvm::Function &F, nlohmann::json &arr);
   void findOperators(Function &function, raw_fd_ostream &outfile, bool &first);
 
   static char ID; // Pass identification, replacement for typeid
@@ -47,6 +50,9 @@ private:
   set<string> excludedLocalVars;
 
   set<string> functionCalls;
+
+  // 前端导出的变量事实：函数名（全局变量为空串）-> 变量名 -> 事实
+  nlohmann::json facts = nlohmann::json::object();
 };
 
 #endif // CREATE_CONFIG_FILE_GUARD
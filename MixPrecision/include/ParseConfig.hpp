@@ -6,8 +6,10 @@
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <map>
 #include <memory>
+#include <set>
 
-enum ChangeType { GLOBALVAR, LOCALVAR, OP, CALL };
+// REGION 的 Change 中 value 为循环头 BasicBlock
+enum ChangeType { GLOBALVAR, LOCALVAR, OP, CALL, REGION };
 string dump(ChangeType ty);
 
 using Changes = std::vector<std::unique_ptr<Change>>;
@@ -31,12 +33,19 @@ public:
     static AnalysisKey Key; // 必须有这个静态 key
 
     ParseConfigPass();
+    // 不经 -json-config，直接指定配置文件（fat-config 等一次处理多份配置时使用）
+    explicit ParseConfigPass(std::string configPath);
     std::map<ChangeType, Changes> &getChanges(){return changes_;}
 private:
     const std::string configPath;
 
     std::map<std::string, std::unique_ptr<StrChange>> types_;
     std::map<ChangeType, Changes> changes_;
+    std::set<std::string> regionFunctions_;
+    // 被源码 pragma 固定的值，JSON 配置中对应的条目不再生效
+    std::set<llvm::Value *> pinned_;
+    // 在模块中找到了对应值的配置条目，其余条目以 NotFound 备注报告
+    std::set<std::string> matched_;
 
     bool doInitialization(llvm::Module &M);
     void updateChanges(const std::string &id, llvm::Value *value, llvm::LLVMContext &context);
@@ -44,6 +53,9 @@ private:
     static llvm::Value* findAlloca(llvm::Value *value, llvm::Function *function);
 
     void runOnFunction(llvm::Function &F);
+    void collectRegions(llvm::Function &F);
+    void collectPragmas(llvm::Function &F);
+    void remarkUnmatched(llvm::Module &M);
 };
 
 #endif
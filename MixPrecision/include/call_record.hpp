@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef CALL_RECORD
+#define CALL_RECORD
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace llvm;
+
+// 录制运行时，实现在 AMPPipeline/runtime/amp_replay.c
+constexpr const char *RecordEnter = "__amp_record_enter";
+constexpr const char *RecordScalar = "__amp_record_scalar";
+constexpr const char *RecordBuffer = "__amp_record_buffer";
+constexpr const char *RecordOutput = "__amp_record_output";
+constexpr const char *RecordFinish = "__amp_record_finish";
+
+// 录制/回放共用的缓冲区元素类型编号，与 amp_replay.c 一致
+enum RecordElement { RecordI8 = 0, RecordI32, RecordI64, RecordF16, RecordF32, RecordF64, RecordBF16 };
+
+// 在完整程序中录下 -record-function 第 -record-call 次被调用时的参数：标量直接保存，
+// 指针参数按 -record-extent 给出的元素个数与类型保存所指缓冲区，返回时再保存一次缓冲区作为参考输出。
+// -record-extent=<参数下标>:<元素个数>:<i8|i32|i64|f16|bf16|f32|f64>，元素个数为常数与 %<参数下标> 的乘积，
+// 如 sgemm 的 A 为 6:%7*%4:f32。没有给出范围的指针参数回放时传空指针。
+// 录制文件由 amp-extract -harness 生成的回放程序读取，见 AMPPipeline/src/amp_extract.cpp。
+class CallRecordPass : public PassInfoMixin<CallRecordPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+    private:
+        struct Extent {
+            SmallVector<unsigned, 2> args;  // 相乘的参数下标
+            uint64_t factor = 1;            // 相乘的常数
+            RecordElement element = RecordI8;
+        };
+
+        static bool parseExtent(StringRef text, unsigned &arg, Extent &extent);
+        static Value *extentCount(IRBuilder<> &builder, Function &F, const Extent &extent);
+};
+
+#endif
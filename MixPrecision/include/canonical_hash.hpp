@@ -0,0 +1,25 @@
+#pragma once
+
+#ifndef CANONICAL_HASH
+#define CANONICAL_HASH
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <string>
+
+using namespace std;
+using namespace llvm;
+
+// 计算降精、-O2 之后模块的规范化哈希：在副本上去掉调试信息、局部值与基本块的名字
+// 以及本项目自己加的元数据，再打印成文本求 SHA-256。元数据编号按首次出现的顺序重排，
+// 不同配置生成结构相同的代码时得到相同的哈希，评估脚本据此跳过后续编译与运行。
+// 模块本身不被修改；-canonical-hash-out 指定写出哈希的文件
+class CanonicalHashPass : public PassInfoMixin<CanonicalHashPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+        static string computeHash(const Module &M);
+};
+
+#endif
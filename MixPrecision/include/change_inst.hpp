@@ -8,6 +8,8 @@
 #include <llvm/IR/Instructions.h>
 // #include "Debug.h"
 
+#include "change_remarks.hpp"
+
 namespace llvm {
 class Value;
 class ConstantInt;
@@ -39,6 +41,7 @@ class ChangeInst : public InstVisitor<ChangeInst, bool> {
         bool visitFPExtInst(FPExtInst &inst);
         bool visitFCmpInst(FCmpInst &inst);
         bool visitInstruction(Instruction &I) {
+    recordChangeFailure(&I, "unhandled user");
     return false;  // 所有没特殊处理的指令，默认返回 false
 }
 
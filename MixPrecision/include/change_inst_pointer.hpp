@@ -8,6 +8,8 @@
 #include <llvm/IR/Instructions.h>
 // #include "Debug.h"
 
+#include "change_remarks.hpp"
+
 #include "utils.hpp"
 
 namespace llvm {
@@ -41,6 +43,7 @@ class ChangeInstPointer : public InstVisitor<ChangeInstPointer, bool> {
         bool visitFPExtInst(FPExtInst &inst);
         bool visitFCmpInst(FCmpInst &inst);
         bool visitInstruction(Instruction &I) {
+    recordChangeFailure(&I, "unhandled user");
     return false;  // 所有没特殊处理的指令，默认返回 false
 }
 
@@ -17,9 +17,16 @@
 using namespace std;
 using namespace llvm;
 
+// 降精后新建的 alloca 上的元数据：!automxprec.lowered !{!"<变量名>@<函数名>"}
+constexpr const char *LoweredVarMD = "automxprec.lowered";
+// pl 新插入的 fptrunc 上的元数据：!automxprec.lowered.trunc !{}，与源码中原有的 fptrunc 区分
+constexpr const char *LoweredTruncMD = "automxprec.lowered.trunc";
+
 class ChangePrecisionPass: public PassInfoMixin<ChangePrecisionPass>{
     public:
         ChangePrecisionPass():changes(nullptr) {}
+        // 使用调用者给出的变更，不再从 ParseConfigPass 分析结果中获取
+        explicit ChangePrecisionPass(const map<ChangeType, Changes> *changes):changes(changes) {}
         PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
 
     private:
@@ -31,6 +38,8 @@ class ChangePrecisionPass: public PassInfoMixin<ChangePrecisionPass>{
         static ConstantInt* getInt64(LLVMContext& context, int n){return llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), n);}
 
         void safeDeleteInstruction(Instruction* inst);
+        static void tagLowered(AllocaInst *alloca);
+        void changeRegion(Module& module, const Change& change);
         static MDNode* getTypeMetadata(Module& module, DIVariable &oldDIVar, Type* newType);
         static void updateMetadata(Module& module, Value* oldTarget, Value* newTarget, Type* newType);
     
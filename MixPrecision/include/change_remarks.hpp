@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef CHANGE_REMARKS
+#define CHANGE_REMARKS
+
+#include <llvm/Analysis/OptimizationRemarkEmitter.h>
+#include <llvm/IR/DebugLoc.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+// 变更结果以优化备注（-pass-remarks-output=<file>，-pass-remarks-format=yaml|bitstream）输出，
+// 备注名：Applied / PartiallyApplied / Blocked / Rejected / Unchanged / UnknownType / NotFound。
+// 每条都带 Function、Variable 与 Type（与 JSON 配置中的写法一致），搜索端据此把做不到的基因列入黑名单
+constexpr const char *ChangeRemarkPass = "change-precision";
+
+// 访问者处理不了某个使用者时记下原因。使用者随后会被删除，这里当场保存其文本与位置，
+// ChangePrecisionPass 据此发出 Blocked 备注
+struct ChangeFailure {
+    string opcode;
+    string user;
+    DebugLoc loc;
+    const char *reason;
+};
+
+inline vector<ChangeFailure> &changeFailures() {
+    static vector<ChangeFailure> failures;
+    return failures;
+}
+
+inline void recordChangeFailure(Value *user, const char *reason) {
+    ChangeFailure failure{"", "", DebugLoc(), reason};
+    raw_string_ostream os(failure.user);
+    user->print(os);
+    os.flush();
+    if (auto *inst = dyn_cast<Instruction>(user)) {
+        failure.opcode = inst->getOpcodeName();
+        failure.loc = inst->getDebugLoc();
+    } else {
+        failure.opcode = "<non-instruction>";
+    }
+    changeFailures().push_back(std::move(failure));
+}
+
+// 模块 pass 中按函数惰性创建 OptimizationRemarkEmitter
+class ChangeRemarks {
+    public:
+        OptimizationRemarkEmitter &get(Function &F) {
+            auto &ORE = emitters[&F];
+            if (!ORE) ORE = std::make_unique<OptimizationRemarkEmitter>(&F);
+            return *ORE;
+        }
+
+    private:
+        map<Function *, unique_ptr<OptimizationRemarkEmitter>> emitters;
+};
+
+#endif
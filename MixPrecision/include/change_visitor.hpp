@@ -7,6 +7,7 @@
 
 #include "change_inst.hpp"
 #include "change_inst_pointer.hpp"
+#include "pass_stats.hpp"
 
 namespace llvm {
 class Value;
@@ -31,8 +32,11 @@ struct TransformerImpl<Type*> {
             errs().changeColor(raw_ostream::RED, /*bold=*/true);
             errs()<<"NO INST!!!\n";
             errs().resetColor();
+            recordChangeFailure(it->getUser(), "non-instruction user");
             return false;
         }
+        // 按指令种类计时，访问者之间的递归调用各自计入
+        PhaseTimer timer("visit", inst->getOpcodeName());
         ChangeInst changer(context, it, newTarget, oldTarget, newType, oldType, alignment);
         return changer.change(*inst);
     }
@@ -49,8 +53,10 @@ struct TransformerImpl<PtrDep> {
             errs().changeColor(raw_ostream::RED, /*bold=*/true);
             errs()<<"NO INST!!!\n";
             errs().resetColor();
+            recordChangeFailure(it->getUser(), "non-instruction user");
             return false;
         }
+        PhaseTimer timer("visit-pointer", inst->getOpcodeName());
         ChangeInstPointer changer(context, it, newTarget, oldTarget, newType, oldType, alignment);
         return changer.change(*inst);
     }
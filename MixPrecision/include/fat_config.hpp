@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef FAT_CONFIG
+#define FAT_CONFIG
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+// 运行时选择入口，实现在 AMPPipeline/runtime/amp_fatconfig.c
+constexpr const char *FatConfigSelect = "__amp_select_config";
+constexpr const char *FatConfigIndex = "__amp_config_index";
+constexpr const char *FatConfigOrigMain = "__amp_fat_main";
+
+// 一次编译 K 份配置：受配置影响的函数按每份配置克隆出变体（配置一致时共用同一个），
+// 原函数改为按 __amp_config_index 分派的桩，下标在 main 入口由环境变量 AMP_CONFIG
+// 或首个参数 --amp-config=N 决定。之后的变更与降精与 pl 相同。
+// 与 fork server 同用时须写成 fat-config,fork-server，每次 fork 出的运行才各自选择配置；
+// main 已被 fork-server 包装时报错返回。
+class FatConfigPass : public PassInfoMixin<FatConfigPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+
+    private:
+        // 函数名 -> 该函数在某份配置下的 localVar / region 条目
+        using FunctionEntries = map<string, nlohmann::json>;
+
+        bool loadConfig(const string &path, FunctionEntries &entries);
+        Function *cloneVariant(Function &F, const string &suffix);
+        void buildDispatcher(Function &F, Function *base, const vector<Function *> &perConfig,
+                             GlobalVariable *index);
+        bool insertSelector(Module &M, GlobalVariable *index, unsigned numConfigs);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef FINITE_CHECK
+#define FINITE_CHECK
+
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Support/CommandLine.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+// PrecisionLoweringPass 是否在降精后插入检查，-check-finite
+extern cl::opt<bool> CheckFinite;
+
+// 报错入口，实现在 AMPPipeline/runtime/amp_nonfinite.c，以退出码 86 结束程序
+constexpr const char *NonFiniteReport = "__amp_report_nonfinite";
+
+// 在降精产生的 fptrunc（带 LoweredTruncMD）之后、对降精变量的 store 之后检查值是否为 Inf/NaN。
+// 检查本身不分支（x - x 是否为 NaN），结果按位或进所在最内层循环的掩码，
+// 最内层循环在出口统一判断，循环仍可向量化；含子循环的循环另在每个 latch 上判断，
+// 不在循环中的按基本块末尾判断。
+// 报告的 ID 为降精变量的 <变量名>@<函数名>，找不到对应变量时为 <函数名>:<行>:<列>。
+class FiniteCheckPass : public PassInfoMixin<FiniteCheckPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+    private:
+        // 一个掩码对应一个最内层循环（或函数中不在循环里的部分），每个 ID 占一位
+        struct Mask {
+            AllocaInst *slot = nullptr;
+            vector<string> ids;
+            map<string, unsigned> index;
+            GlobalVariable *table = nullptr;
+        };
+
+        bool runOnFunction(Function &F);
+        void accumulate(Instruction *after, Value *value, Mask &mask, const string &id);
+        void insertCheck(Instruction *before, Mask &mask);
+        GlobalVariable *getTable(Module &M, Mask &mask);
+};
+
+#endif
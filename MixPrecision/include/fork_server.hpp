@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef FORK_SERVER
+#define FORK_SERVER
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+using namespace llvm;
+
+// fork server 桩代码入口，实现在 AMPPipeline/runtime/amp_forkserver.c
+constexpr const char *ForkServerEntry = "__amp_forkserver";
+constexpr const char *ForkServerOrigMain = "__amp_main_orig";
+
+// 把 main 改名为 origName 并生成新的 main：先执行 hook(builder, &argc, &argv)，
+// 再以（可能被 hook 替换的）参数调用原 main。没有 main 或形式不支持时返回 nullptr
+Function *wrapMain(Module &M, StringRef origName,
+                   function_ref<void(IRBuilder<> &, Value *argcSlot, Value *argvSlot)> hook);
+
+// 把 main 改名为 __amp_main_orig，新的 main 先调用 __amp_forkserver(&argc, &argv)。
+// 程序初始化只做一次，之后每次运行都由 runner 通知桩代码 fork 出子进程。
+// 须在流水线中最后包装 main（如 fat-config,fork-server），其他 pass 插入的 main 入口逻辑才会在每次 fork 后执行。
+class ForkServerPass : public PassInfoMixin<ForkServerPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef IR_FEATURES
+#define IR_FEATURES
+
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Support/CommandLine.h>
+
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace llvm;
+
+// 非空时 PrecisionLoweringPass 在降精之后把特征写到该文件，-ir-features-out
+extern cl::opt<string> IRFeaturesOut;
+
+// 提取降精后模块的静态特征，写成一行扁平的 JSON（特征名 -> 数值），可直接作为 amp-surrogate 的输入：
+//   fp.<精度>.<操作>[.freq|.depth]      浮点运算条数，按块频率（相对入口）或 10^循环深度加权
+//   cvt.<操作>.<源>.<目标>、cvt.<操作>.loop|outside[.freq]   类型转换的种类与位置
+//   mem.load|store.<精度>.bytes[.freq]  各精度读写的字节数
+//   vector.fraction                     按块频率加权的浮点运算中可向量化的比例估计
+//   lowered.vars / reach_cmp / reach_branch   降精变量数，以及其值流到比较、分支的变量数
+class IRFeaturesPass : public PassInfoMixin<IRFeaturesPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+        static map<string, double> extract(Module &M);
+
+    private:
+        using Features = map<string, double>;
+
+        static void visitFunction(Function &F, Features &features);
+        static bool isSimpleInnermost(Loop *loop);
+        static void traceLowered(AllocaInst *alloca, Features &features);
+};
+
+#endif
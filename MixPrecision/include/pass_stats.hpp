@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef PASS_STATS
+#define PASS_STATS
+
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#include <chrono>
+#include <string>
+
+using namespace std;
+using namespace llvm;
+
+// 发行版 LLVM 中 STATISTIC 是不计数的 NoopStatistic，这里直接用 TrackingStatistic，
+// 打开 opt 的 -stats / -stats-json 或 -amp-stats-out 时都会计数
+#define AMP_STATISTIC(VARNAME, DESC) static llvm::TrackingStatistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC}
+
+// -amp-quiet：不再逐个变量、逐个函数输出日志，批量评估时省去大量 errs() 输出
+extern cl::opt<bool> AmpQuiet;
+// -amp-stats-out=<file>：PrecisionLoweringPass 结束时把计数器与各阶段耗时写成 JSON
+extern cl::opt<string> AmpStatsOut;
+
+// 阶段计时：进入 time-trace（TimeTraceScope，由 opt 自带的 --time-trace / --time-trace-file 打开），
+// 并在 -amp-stats-out 打开时按 group.name 累计耗时与次数。
+// name 须为静态字符串（如 getOpcodeName() 的返回值）；嵌套的阶段各自计入，耗时为包含子阶段的时间
+class PhaseTimer {
+    public:
+        PhaseTimer(const char *group, const char *name = nullptr);
+        ~PhaseTimer();
+
+    private:
+        TimeTraceScope trace;
+        const char *group;
+        const char *name;
+        std::chrono::steady_clock::time_point start;
+};
+
+// 一次统计会话，对应一次 PrecisionLoweringPass::run
+void beginPassStats();
+void endPassStats();
+
+#endif
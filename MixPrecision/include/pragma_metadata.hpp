@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef PRAGMA_METADATA
+#define PRAGMA_METADATA
+
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+// AutoMxPrec 插件写入 annotate 属性的前缀，与 AutoMxPrecPlugin/plugin/AutoMxPrec.cpp 保持一致
+constexpr const char *PragmaRegionAnnotation = "automxprec.region";
+constexpr const char *PragmaKeepAnnotation = "automxprec.keep";
+
+// 指令元数据：!automxprec.precision !{!"<region id>", !"<type>", !"<full|storage>"}
+constexpr const char *PragmaPrecisionMD = "automxprec.precision";
+// alloca / 全局变量元数据：!automxprec.keep !{}
+constexpr const char *PragmaKeepMD = "automxprec.keep";
+
+struct PragmaRegion {
+    string id;
+    unsigned beginLine = 0, beginCol = 0;
+    unsigned endLine = 0, endCol = 0;
+    string precision;  // 裸 pragma 区域为空，只计时不降精
+    bool storageOnly = false;
+
+    bool contains(unsigned line, unsigned col) const;
+    static bool parse(StringRef annotation, PragmaRegion &region);
+};
+
+struct PragmaPrecision {
+    string id;
+    string type;
+    bool storageOnly;
+};
+
+// 读取指令上的 pragma 精度元数据，没有则返回 false
+bool getPragmaPrecision(const Instruction &inst, PragmaPrecision &result);
+
+// 把 llvm.global.annotations / llvm.var.annotation 中的 pragma 注解
+// 转成区域内 load、store、alloca、call 上的元数据
+class PragmaMetadataPass : public PassInfoMixin<PragmaMetadataPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+        // 解析 llvm.global.annotations 中各函数的 pragma 区域，不修改模块
+        static map<Function *, vector<PragmaRegion>> collectRegions(Module &M);
+
+    private:
+        bool annotateFunction(Function &F, const vector<PragmaRegion> &regions);
+        // keep 注解转成全局变量与 alloca 上的元数据
+        bool annotateKeeps(Module &M);
+};
+
+#endif
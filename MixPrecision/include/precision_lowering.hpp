@@ -5,6 +5,7 @@
 
 #include <llvm/IR/DebugInfo.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/Pass.h>
 #include <llvm//IR/Module.h>
 #include <llvm/Support/CommandLine.h>
@@ -12,6 +13,8 @@
 #include <vector>
 #include <set>
 
+#include "ParseConfig.hpp"
+
 namespace llvm {
     class Value;
     class BinaryOperator;
@@ -25,13 +28,19 @@ using namespace llvm;
 
 class PrecisionLoweringPass :  public llvm::PassInfoMixin<PrecisionLoweringPass>{
     public:
+        PrecisionLoweringPass() = default;
+        // changes 非空时 pragma 元数据与配置解析由调用者完成，这里只做变更与降精
+        explicit PrecisionLoweringPass(const map<ChangeType, Changes> *changes) : changes(changes) {}
+
         llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
         
     private:
         bool runOnFunction(Function &function);
         bool hasSIToFPInst(BinaryOperator *binOp);
+        static void tagLoweredTruncs(Module &module, const vector<WeakVH> &originalTruncs);
 
     private:
+        const map<ChangeType, Changes> *changes = nullptr;
         DebugInfoFinder debugInfo;
         vector<Instruction*> eraseInsts;
 
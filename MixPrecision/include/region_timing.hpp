@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef REGION_TIMING
+#define REGION_TIMING
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <string>
+#include <vector>
+
+#include "pragma_metadata.hpp"
+
+using namespace std;
+using namespace llvm;
+
+// 计时运行时，实现在 AMPPipeline/runtime/amp_timing.c
+constexpr const char *TimingRegister = "__amp_timing_register";
+constexpr const char *TimingNow = "__amp_timing_now";
+
+// 在每个 #pragma AutoMxPrec 区域和 -time-functions 指定的函数前后读取周期计数器
+// （aarch64 为 cntvct_el0，x86 为 rdtsc），累加到静态表中，程序退出时由运行时写成 JSON。
+// 区域按插件写入的源码范围划分基本块：跨越边界的块先拆开，再在进出区域的边上插桩。
+class RegionTimingPass : public PassInfoMixin<RegionTimingPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+    private:
+        struct Timer {
+            string id;
+            string kind;   // "region" / "function"
+        };
+
+        Value *readCounter(IRBuilder<> &builder, Module &M);
+        void emitStart(IRBuilder<> &builder, Module &M, AllocaInst *slot);
+        void emitStop(IRBuilder<> &builder, Module &M, AllocaInst *slot, unsigned index);
+
+        bool instrumentRegion(Function &F, const PragmaRegion &region, unsigned index);
+        void instrumentFunction(Function &F, unsigned index);
+        void registerTable(Module &M);
+
+        vector<Timer> timers;
+        GlobalVariable *table = nullptr;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef SHADOW_VALUE
+#define SHADOW_VALUE
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+// 影子值运行时，实现在 AMPPipeline/runtime/amp_shadow.c
+constexpr const char *ShadowLoad = "__amp_shadow_load";
+constexpr const char *ShadowStore = "__amp_shadow_store";
+constexpr const char *ShadowCheck = "__amp_shadow_check";
+constexpr const char *ShadowRegister = "__amp_shadow_register";
+
+// 影子值插桩：每个标量浮点值带一个 double 影子，降精后的运算同时按 double 再算一遍，
+// fptrunc 的影子取截断前的值。浮点 load/store 经运行时的直接映射表读写影子内存，
+// 表中没有、被冲突挤掉或内存已被未插桩的代码改写时退回程序值本身。
+// 写入降精变量（ChangePrecisionPass 打的标记）时比较程序值与影子，运行时按变量统计最大/平均相对误差与以降精类型计的 ULP 偏差，
+// 退出时写成 JSON。用激进配置跑一次即可按误差贡献给全部降精变量排序。
+class ShadowValuePass : public PassInfoMixin<ShadowValuePass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+    private:
+        using ShadowMap = DenseMap<Value *, Value *>;
+
+        static bool isShadowed(Type *type);
+        static Value *toDouble(IRBuilder<> &builder, Value *value);
+        Value *getShadow(Value *value, Instruction *before, ShadowMap &shadows);
+        Value *shadowIntrinsic(CallInst *call, Instruction *after, ShadowMap &shadows);
+        int findVariable(Value *pointer);
+        void instrumentStore(StoreInst *store, ShadowMap &shadows);
+        bool instrumentFunction(Function &F);
+        void registerVariables(Module &M);
+
+        map<string, unsigned> variableIndex;
+        vector<string> variables;
+        GlobalVariable *base = nullptr;
+        FunctionCallee loadFn, storeFn, checkFn;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef CONVERGENCE_WATCHDOG
+#define CONVERGENCE_WATCHDOG
+
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+
+#include <string>
+
+using namespace std;
+using namespace llvm;
+
+// 看门狗运行时，实现在 AMPPipeline/runtime/amp_watchdog.c，触发时以退出码 87 结束程序
+constexpr const char *WatchdogStep = "__amp_watchdog_step";
+constexpr const char *WatchdogBegin = "__amp_watchdog_begin";
+// 运行时状态表的大小，与 amp_watchdog.c 中的 AMP_WATCHDOG_MAX 一致，超出的编号会被运行时忽略
+constexpr unsigned WatchdogMax = 16;
+
+// 在指定循环（函数 + 循环头调试位置，与 region 配置相同）进入前重置状态，每次迭代末尾读取残差变量，
+// 交给运行时判断：连续 -watchdog-patience 次迭代没有下降、残差为 Inf/NaN，
+// 或超过 -watchdog-budget 秒时写出状态并退出。
+// -watchdog=<function>:<line>[:<col>]:<residual>，可重复，最多 WatchdogMax 个
+class ConvergenceWatchdogPass : public PassInfoMixin<ConvergenceWatchdogPass> {
+    public:
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+    private:
+        struct Spec {
+            string function;
+            unsigned line = 0, col = 0;
+            string residual;
+            string text;
+        };
+
+        static bool parseSpec(StringRef text, Spec &spec);
+        static Loop *findLoop(LoopInfo &LI, const Spec &spec);
+        static Value *findResidual(Function &F, const string &name);
+        bool instrument(Function &F, const Spec &spec, unsigned id);
+};
+
+#endif
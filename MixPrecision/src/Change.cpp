@@ -11,6 +11,9 @@ Change::Change(Types aType, Value* aValue) :type(aType),value(aValue),field(-1){
 Change::Change(Types aType, Value* aValue, int aField) :type(aType),value(aValue),field(aField){
 }
 
+Change::Change(Types aType, Value* aValue, int aField, string aName) :type(aType),value(aValue),field(aField),name(aName){
+}
+
 Value * const  Change::getValue()const {
   return value;
 }
@@ -23,6 +26,10 @@ int Change::getField()const {
   return field;
 }
 
+string Change::getName()const {
+  return name.empty() && value ? value->getName().str() : name;
+}
+
 
 StrChange::StrChange(string aClassification, string aTypes, int aField):classification(aClassification),types(aTypes),field(aField) {
 }
@@ -12,6 +12,9 @@
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/IR/ValueSymbolTable.h>
 #include <llvm/Passes/PassPlugin.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/IntrinsicInst.h>
 
 #include <nlohmann/json.hpp>
 #include <llvm/IR/Module.h>
@@ -34,6 +37,8 @@ cl::opt<bool> ListOperators("ops", cl::value_desc("flag"), cl::desc("Print opera
 cl::opt<bool> ListFunctions("funs", cl::value_desc("flag"), cl::desc("Print functions"), cl::init(false));
 cl::opt<bool> OnlyScalars("only-scalars", cl::value_desc("flag"), cl::desc("Print only scalars"), cl::init(false));
 cl::opt<bool> OnlyArrays("only-arrays", cl::value_desc("flag"), cl::desc("Print only arrays"), cl::init(false));
+cl::opt<bool> ListRegions("list-regions", cl::value_desc("flag"), cl::desc("Print loop-nest regions"), cl::init(false));
+cl::list<string> FactsFiles("facts", cl::value_desc("filename"), cl::desc("Variable facts files (or directories) exported by the AutoMxPrec plugin"), cl::CommaSeparated);
 
 static void printDimensions(vector<unsigned> &dimensions, raw_fd_ostream &outfile) {
   for(unsigned i = 0; i < dimensions.size(); i++) {
@@ -138,6 +143,7 @@ void CreateConfigFilePass::collectGlobals(Module &M, nlohmann::json &outJson) {
         nlohmann::json entry;
         entry["name"] = name;
         entry["type"] = type2Str(type, &GV);
+        mergeFacts("", name, entry);
         outJson["globalVar"].push_back(entry);  
     }
 }
@@ -167,8 +173,59 @@ void CreateConfigFilePass::collectCalls(Function &F, nlohmann::json &outJson) {
     }
 }
 
+// 每个带调试位置的循环都是一个候选 region，默认保持 double
+void CreateConfigFilePass::collectRegions(Function &F, nlohmann::json &outJson) {
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+
+    for (Loop *loop : LI.getLoopsInPreorder()) {
+        DebugLoc loc = loop->getStartLoc();
+        if (!loc) continue;
+
+        nlohmann::json entry;
+        entry["function"] = F.getName().str();
+        entry["line"] = loc.getLine();
+        entry["col"] = loc.getCol();
+        entry["depth"] = loop->getLoopDepth();
+        entry["type"] = "double";
+
+        outJson["region"].push_back(entry);
+    }
+}
+
+// 通过 dbg.declare 把 IR 中的 alloca 对应回源码变量名，按指令顺序排列，生成的配置每次相同
+static std::vector<std::pair<Value *, std::string>> collectSourceNames(Function &F) {
+    std::vector<std::pair<Value *, std::string>> names;
+    std::map<Value *, size_t> index;
+    for (auto &BB : F) {
+        for (auto &I : BB) {
+            if (auto *declare = dyn_cast<DbgDeclareInst>(&I)) {
+                if (declare->getAddress() && declare->getVariable()) {
+                    std::string name = declare->getVariable()->getName().str();
+                    auto [it, inserted] = index.insert({declare->getAddress(), names.size()});
+                    if (inserted) {
+                        names.push_back({declare->getAddress(), name});
+                    } else {
+                        names[it->second].second = name;
+                    }
+                }
+            }
+        }
+    }
+    return names;
+}
+
+void CreateConfigFilePass::mergeFacts(const std::string &function, const std::string &name, nlohmann::json &entry) {
+    if (!facts.contains(function) || !facts[function].contains(name)) return;
+    entry["facts"] = facts[function][name];
+}
+
 void CreateConfigFilePass::collectLocals(Function &F, nlohmann::json &outJson) {
     auto *symbolTable = F.getValueSymbolTable();
+    std::string function = F.getName().str();
+    auto sourceNames = collectSourceNames(F);
+    std::map<Value *, std::string> sourceNameOf(sourceNames.begin(), sourceNames.end());
+    set<string> emitted;
 
     for (auto iter = symbolTable->begin(); iter != symbolTable->end(); ++iter) {
         Value *val = iter->second;
@@ -199,6 +256,10 @@ void CreateConfigFilePass::collectLocals(Function &F, nlohmann::json &outJson) {
         entry["function"] = F.getName().str();
         entry["type"] = dep.to_string();
         // entry["type"] = type2Str(type, val);
+        auto source = sourceNameOf.find(val);
+        std::string sourceName = source != sourceNameOf.end() ? source->second : name;
+        mergeFacts(function, sourceName, entry);
+        emitted.insert(sourceName);
 
         // 可选：添加调试信息（如文件名）
         if (auto *term = F.getEntryBlock().getTerminator()) {
@@ -209,6 +270,56 @@ void CreateConfigFilePass::collectLocals(Function &F, nlohmann::json &outJson) {
 
         outJson["localVar"].push_back(entry);  // 👈 添加至 "localVar" 数组
     }
+
+    // 名字带 '.' 而被上面过滤掉的 alloca（x.addr 以外的重命名、内联产生的副本），
+    // 若前端事实里有对应的源码变量，则按 IR 名字补回配置
+    if (!facts.contains(function)) return;
+    for (auto &[val, sourceName] : sourceNames) {
+        auto *alloca = dyn_cast<AllocaInst>(val);
+        if (!alloca || emitted.count(sourceName) || excludedLocalVars.count(sourceName)) continue;
+        if (!facts[function].contains(sourceName)) continue;
+
+        nlohmann::json entry;
+        entry["name"] = alloca->getName().str();
+        entry["function"] = function;
+        entry["type"] = resolvePointerElementType(alloca).to_string();
+        entry["source"] = sourceName;
+        mergeFacts(function, sourceName, entry);
+        emitted.insert(sourceName);
+        outJson["localVar"].push_back(entry);
+    }
+}
+
+// 读取插件导出的 *.facts.json，按 函数 -> 变量 合并
+void CreateConfigFilePass::loadFacts() {
+    vector<string> files;
+    for (const auto &path : FactsFiles) {
+        if (!sys::fs::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+        std::error_code ec;
+        for (sys::fs::directory_iterator it(path, ec), end; it != end && !ec; it.increment(ec)) {
+            if (StringRef(it->path()).endswith(".facts.json")) files.push_back(it->path());
+        }
+    }
+
+    for (const auto &file : files) {
+        ifstream in(file);
+        nlohmann::json tu;
+        try {
+            in >> tu;
+        } catch (const std::exception &e) {
+            errs() << "Unable to parse facts file " << file << ": " << e.what() << "\n";
+            continue;
+        }
+        if (!tu.contains("functions")) continue;
+        for (auto &[function, vars] : tu["functions"].items()) {
+            for (auto &[name, fact] : vars.items()) {
+                facts[function][name] = fact;
+            }
+        }
+    }
 }
 void CreateConfigFilePass::initLoadFilters() {
   ifstream inFile(ExcludedFunctionsFileName.c_str());
@@ -279,6 +390,7 @@ void CreateConfigFilePass::initLoadFilters() {
 
 PreservedAnalyses CreateConfigFilePass::run(Module &M, ModuleAnalysisManager &) {
     initLoadFilters();
+    loadFacts();
 
     nlohmann::json output = nlohmann::json::object();  
 
@@ -288,6 +400,7 @@ PreservedAnalyses CreateConfigFilePass::run(Module &M, ModuleAnalysisManager &)
             !excludedFunctions.count(F.getName().str())) {
             collectLocals(F, output);
             if (ListFunctions) collectCalls(F, output);
+            if (ListRegions) collectRegions(F, output);
         }
     }
 
@@ -1,10 +1,15 @@
 #include "../include/ParseConfig.hpp"
 #include "../include/utils.hpp"
+#include "../include/pragma_metadata.hpp"
+#include "../include/pass_stats.hpp"
+#include "../include/change_remarks.hpp"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/Analysis/LoopInfo.h>
 #include <memory>
 #include <nlohmann/json.hpp>
 
@@ -19,6 +24,7 @@ llvm::cl::opt<std::string> ConfigFilePath(
     llvm::cl::init("config.json"));
 
 ParseConfigPass::ParseConfigPass() : configPath(ConfigFilePath) {}
+ParseConfigPass::ParseConfigPass(std::string configPath) : configPath(std::move(configPath)) {}
 
 
 
@@ -36,6 +42,8 @@ string dump(ChangeType ty){
       return "ChangeType::OP";
     case ChangeType::CALL:
       return "ChangeType::CALL";
+    case ChangeType::REGION:
+      return "ChangeType::REGION";
     default:
       return"ERROR::ERROR";
       }
@@ -215,6 +223,8 @@ void ParseConfigPass::updateChanges(
     llvm::LLVMContext &context) {
     auto it = types_.find(id);
     if (it == types_.end()) return;
+    matched_.insert(id);
+    if (pinned_.count(value)) return;
 
     const StrChange *meta = it->second.get();
     std::istringstream ss(meta->getTypes());
@@ -225,7 +235,18 @@ void ParseConfigPass::updateChanges(
             parsedTypes.push_back(pd);
     }
 
-    if (parsedTypes.empty()) return;
+    if (parsedTypes.empty()) {
+        Function *F = isa<Instruction>(value) ? cast<Instruction>(value)->getFunction()
+                    : isa<Argument>(value)   ? cast<Argument>(value)->getParent() : nullptr;
+        if (F) {
+            OptimizationRemarkEmitter(F).emit([&]() {
+                return OptimizationRemarkMissed(ChangeRemarkPass, "UnknownType", &F->getEntryBlock().front())
+                       << ore::NV("Function", F->getName()) << ore::NV("Variable", id.substr(0, id.rfind('@')))
+                       << ore::NV("Type", meta->getTypes()) << ": type not recognised";
+            });
+        }
+        return;
+    }
 
     int field = meta->getField();
     std::string kind = meta->getClassification();
@@ -235,10 +256,12 @@ void ParseConfigPass::updateChanges(
         parsedTypes[0].ty = constructStruct(value, field, parsedTypes[0].ty);
     }
 
+    // 变量名取自配置 id，参数落栈后的 alloca 叫 X.addr，报告里仍应是 X
+    std::string name = id.substr(0, id.rfind('@'));
     if (kind == "globalVar") {
-        changes_[GLOBALVAR].emplace_back(std::make_unique<Change>(parsedTypes, value, field));
+        changes_[GLOBALVAR].emplace_back(std::make_unique<Change>(parsedTypes, value, field, name));
     } else if (kind == "localVar") {
-        changes_[LOCALVAR].emplace_back(std::make_unique<Change>(parsedTypes, value, field));
+        changes_[LOCALVAR].emplace_back(std::make_unique<Change>(parsedTypes, value, field, name));
     } else if (kind == "op") {
         changes_[OP].emplace_back(std::make_unique<Change>(parsedTypes, value));
     } else if (kind == "call") {
@@ -247,6 +270,8 @@ void ParseConfigPass::updateChanges(
         // auto *funcMeta = dynamic_cast<const FuncStrChange*>(meta);
         std::string swit = funcMeta ? funcMeta->getSwitch() : "";
         changes_[CALL].emplace_back(std::make_unique<FunctionChange>(parsedTypes, value, swit));
+    } else if (kind == "region") {
+        changes_[REGION].emplace_back(std::make_unique<Change>(parsedTypes, value));
     }
 }
 
@@ -261,11 +286,23 @@ bool ParseConfigPass::doInitialization(Module &M) {
     changes_[LOCALVAR] = std::move(std::vector<std::unique_ptr<Change>>{});
     changes_[OP]       = std::move(std::vector<std::unique_ptr<Change>>{});
     changes_[CALL]     = std::move(std::vector<std::unique_ptr<Change>>{});
+    changes_[REGION]   = std::move(std::vector<std::unique_ptr<Change>>{});
+
+    // 只有出现在 region 配置中的函数才需要计算 LoopInfo
+    regionFunctions_.clear();
+    pinned_.clear();
+    matched_.clear();
+    for (const auto &[id, meta] : types_) {
+        if (meta->getClassification() == "region") {
+            regionFunctions_.insert(id.substr(id.rfind('@') + 1));
+        }
+    }
 
     return true;
 }
 
 ParseConfigResult ParseConfigPass::run(Module &M, ModuleAnalysisManager &) {
+    PhaseTimer timer("ParseConfig");
     if (!doInitialization(M)) {
         return ParseConfigResult{nullptr};  // 配置加载失败也不破坏分析结果
     }
@@ -274,6 +311,10 @@ ParseConfigResult ParseConfigPass::run(Module &M, ModuleAnalysisManager &) {
 
     // 遍历全局变量
     for (auto &global : M.globals()) {
+        if (global.getMetadata(PragmaKeepMD)) {
+            pinned_.insert(&global);
+            continue;
+        }
         std::string varId = global.getName().str();
         updateChanges(varId, &global, context);
     }
@@ -285,8 +326,11 @@ ParseConfigResult ParseConfigPass::run(Module &M, ModuleAnalysisManager &) {
         }
     }
 
+    remarkUnmatched(M);
+
     // 调试输出收集到的 Change 信息
     for (const auto &[change_type, change_vec] : changes_) {
+        if (AmpQuiet) break;
         errs() << "[ParseConfigPass] " << dump(change_type) << ":\n";
         for (const auto &change_ptr : change_vec) {
             Value *value = change_ptr->getValue();
@@ -311,6 +355,21 @@ ParseConfigResult ParseConfigPass::run(Module &M, ModuleAnalysisManager &) {
     return ParseConfigResult{&this->changes_};
 }
 
+// 配置里有、模块中找不到的变量（改名、被优化掉等），挂在 <名字>@<函数> 的函数上报告；全局变量没有函数，不报告
+void ParseConfigPass::remarkUnmatched(Module &M) {
+    for (const auto &[id, meta] : types_) {
+        size_t at = id.rfind('@');
+        if (matched_.count(id) || at == string::npos) continue;
+        Function *F = M.getFunction(id.substr(at + 1));
+        if (!F || F->isDeclaration()) continue;
+        OptimizationRemarkEmitter(F).emit([&]() {
+            return OptimizationRemarkMissed(ChangeRemarkPass, "NotFound", &F->getEntryBlock().front())
+                   << ore::NV("Function", F->getName()) << ore::NV("Variable", id.substr(0, at))
+                   << ore::NV("Type", meta->getTypes()) << ": no such variable";
+        });
+    }
+}
+
 Value* ParseConfigPass::findAlloca(Value *value, Function *function) {
 
   for(Function::iterator b = function->begin(), be = function->end(); b != be; b++) {
@@ -352,6 +411,8 @@ void ParseConfigPass::runOnFunction(Function &f) {
   // local variables
   string functionName = f.getName().str();
   LLVMContext& context = f.getContext();
+  collectPragmas(f);
+
   const ValueSymbolTable *  symbol_table = f.getValueSymbolTable();
   auto iter=symbol_table->begin();
 
@@ -378,6 +439,105 @@ void ParseConfigPass::runOnFunction(Function &f) {
     }
   }
 
+  if (regionFunctions_.count(functionName)) {
+    collectRegions(f);
+  }
+}
+
+// 按循环头调试位置匹配 region 配置，先匹配 line:col，再匹配 line
+void ParseConfigPass::collectRegions(Function &f) {
+  string functionName = f.getName().str();
+  LLVMContext &context = f.getContext();
+  DominatorTree DT(f);
+  LoopInfo LI(DT);
+
+  // 同一行上可能有多层循环：line:col 精确匹配优先，该行有精确匹配时不再按行号匹配
+  std::map<Loop *, string> chosen;
+  std::set<unsigned> exactLines;
+  SmallVector<Loop *, 4> loops = LI.getLoopsInPreorder();
+  for (Loop *loop : loops) {
+    DebugLoc loc = loop->getStartLoc();
+    if (!loc) continue;
+    string id = "loop:" + std::to_string(loc.getLine()) + ":" + std::to_string(loc.getCol()) + "@" + functionName;
+    if (!types_.count(id)) continue;
+    chosen[loop] = id;
+    exactLines.insert(loc.getLine());
+  }
+  for (Loop *loop : loops) {
+    DebugLoc loc = loop->getStartLoc();
+    if (!loc || chosen.count(loop) || exactLines.count(loc.getLine())) continue;
+    string id = "loop:" + std::to_string(loc.getLine()) + "@" + functionName;
+    if (types_.count(id)) chosen[loop] = id;
+  }
+
+  // 每个循环至多一个 REGION；按行号匹配的同一 id 只取最外层，内层已经包含在其中
+  std::set<string> matched;
+  for (Loop *loop : loops) {
+    auto it = chosen.find(loop);
+    if (it == chosen.end() || !matched.insert(it->second).second) continue;
+    updateChanges(it->second, loop->getHeader(), context);
+  }
+}
+
+// 把数组最内层的浮点元素换成 newType，非浮点返回 nullptr
+static Type *replaceFPElement(Type *type, Type *newType) {
+  if (auto *array = dyn_cast<ArrayType>(type)) {
+    Type *element = replaceFPElement(array->getElementType(), newType);
+    return element ? ArrayType::get(element, array->getNumElements()) : nullptr;
+  }
+  return type->isFloatingPointTy() ? newType : nullptr;
+}
+
+// 源码 pragma 经 PragmaMetadataPass 留下的元数据也是一种配置来源，且优先于 JSON：
+// keep 的变量保持原精度；区域内声明的标量 / 数组按 precision 降精；
+// full 模式下区域内最外层循环再作为 REGION 降低运算精度
+void ParseConfigPass::collectPragmas(Function &f) {
+  LLVMContext &context = f.getContext();
+  std::map<BasicBlock *, PragmaPrecision> headers;
+
+  for (auto &BB : f) {
+    for (auto &inst : BB) {
+      PragmaPrecision pragma;
+      if (auto *alloca = dyn_cast<AllocaInst>(&inst)) {
+        if (alloca->getMetadata(PragmaKeepMD)) {
+          pinned_.insert(alloca);
+          continue;
+        }
+        if (!getPragmaPrecision(*alloca, pragma)) continue;
+
+        // 指针变量指向的缓冲区不一定在区域内，只处理本地标量和数组
+        PtrDep oldType = resolvePointerElementType(alloca);
+        Type *newFP = parsePtrDep(pragma.type, context).ty;
+        Type *newType = oldType.dep == 0 && newFP ? replaceFPElement(oldType.ty, newFP) : nullptr;
+        pinned_.insert(alloca);
+        if (newType && newType != oldType.ty) {
+          changes_[LOCALVAR].emplace_back(std::make_unique<Change>(Types{PtrDep(newType, 0)}, alloca, -1));
+        }
+      } else if (!headers.count(&BB) && getPragmaPrecision(inst, pragma) && !pragma.storageOnly) {
+        headers[&BB] = pragma;
+      }
+    }
+  }
+
+  if (headers.empty()) return;
+
+  DominatorTree DT(f);
+  LoopInfo LI(DT);
+  std::set<Loop *> lowered;
+  for (Loop *loop : LI.getLoopsInPreorder()) {
+    auto it = headers.find(loop->getHeader());
+    if (it == headers.end()) continue;
+    if (loop->getParentLoop() && lowered.count(loop->getParentLoop())) {
+      lowered.insert(loop);
+      continue;
+    }
+    Type *newFP = parsePtrDep(it->second.type, context).ty;
+    if (!newFP || !newFP->isFloatingPointTy()) continue;
+
+    lowered.insert(loop);
+    pinned_.insert(loop->getHeader());
+    changes_[REGION].emplace_back(std::make_unique<Change>(Types{PtrDep(newFP, 0)}, loop->getHeader()));
+  }
 }
 
 // static Type* constructStruct(Value *value, unsigned int fieldToChange, Type *fieldType) {
@@ -0,0 +1,138 @@
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "call_record.hpp"
+
+static cl::opt<string> RecordFunction("record-function", cl::desc("Function whose arguments are recorded"));
+static cl::opt<uint64_t> RecordCall("record-call", cl::init(1), cl::desc("1-based index of the call to record"));
+static cl::list<string> RecordExtents(
+    "record-extent", cl::desc("<arg>:<count>:<type>, elements behind a pointer argument, e.g. 6:%7*%4:f32"));
+
+bool CallRecordPass::parseExtent(StringRef text, unsigned &arg, Extent &extent) {
+    SmallVector<StringRef, 3> fields;
+    text.split(fields, ':');
+    if (fields.size() != 3 || fields[0].getAsInteger(10, arg)) return false;
+
+    SmallVector<StringRef, 4> factors;
+    fields[1].split(factors, '*');
+    for (StringRef factor : factors) {
+        factor = factor.trim();
+        uint64_t number;
+        if (factor.consume_front("%")) {
+            if (factor.getAsInteger(10, number)) return false;
+            extent.args.push_back(number);
+        } else {
+            if (factor.getAsInteger(10, number)) return false;
+            extent.factor *= number;
+        }
+    }
+
+    static const map<string, RecordElement> elements = {
+        {"i8", RecordI8},   {"i32", RecordI32}, {"i64", RecordI64},   {"f16", RecordF16},
+        {"f32", RecordF32}, {"f64", RecordF64}, {"bf16", RecordBF16},
+    };
+    auto it = elements.find(fields[2].str());
+    if (it == elements.end()) return false;
+    extent.element = it->second;
+    return true;
+}
+
+// 标量按 64 位记录，x86_fp80/fp128/ppc_fp128 放不下
+static bool isRecordableFloat(Type *type) {
+    return type->isFloatingPointTy() && !type->isX86_FP80Ty() && !type->isFP128Ty() && !type->isPPC_FP128Ty();
+}
+
+// 在函数入口按参数值算出元素个数，参数不变，返回处沿用同一个值
+Value *CallRecordPass::extentCount(IRBuilder<> &builder, Function &F, const Extent &extent) {
+    Value *count = builder.getInt64(extent.factor);
+    for (unsigned arg : extent.args) {
+        count = builder.CreateMul(count, builder.CreateSExtOrTrunc(F.getArg(arg), builder.getInt64Ty()));
+    }
+    return count;
+}
+
+PreservedAnalyses CallRecordPass::run(Module &M, ModuleAnalysisManager &) {
+    if (RecordFunction.empty()) return PreservedAnalyses::all();
+    Function *F = M.getFunction(RecordFunction);
+    if (!F || F->isDeclaration()) {
+        errs() << "\033[31m[CallRecord] function " << RecordFunction << " not found\033[0m\n";
+        return PreservedAnalyses::all();
+    }
+
+    map<unsigned, Extent> extents;
+    for (const string &text : RecordExtents) {
+        unsigned arg;
+        Extent extent;
+        if (!parseExtent(text, arg, extent) || arg >= F->arg_size() || !F->getArg(arg)->getType()->isPointerTy()) {
+            errs() << "\033[31m[CallRecord] invalid extent " << text << "\033[0m\n";
+            return PreservedAnalyses::all();
+        }
+        for (unsigned dim : extent.args) {
+            if (dim >= F->arg_size() || !F->getArg(dim)->getType()->isIntegerTy()) {
+                errs() << "\033[31m[CallRecord] extent " << text << " refers to a non-integer argument\033[0m\n";
+                return PreservedAnalyses::all();
+            }
+        }
+        extents[arg] = extent;
+    }
+
+    // 先检查全部参数类型再插桩，不支持时模块保持原样
+    for (Argument &arg : F->args()) {
+        Type *type = arg.getType();
+        if (!type->isIntegerTy() && !type->isPointerTy() && !isRecordableFloat(type)) {
+            errs() << "\033[31m[CallRecord] argument " << arg.getArgNo() << " of " << RecordFunction
+                   << " has an unsupported type\033[0m\n";
+            return PreservedAnalyses::all();
+        }
+    }
+
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+    Type *int32Ty = Type::getInt32Ty(context);
+    Type *int64Ty = Type::getInt64Ty(context);
+    Type *voidTy = Type::getVoidTy(context);
+    FunctionCallee enterFn = M.getOrInsertFunction(RecordEnter, FunctionType::get(int32Ty, {int64Ty}, false));
+    FunctionCallee scalarFn = M.getOrInsertFunction(
+        RecordScalar, FunctionType::get(voidTy, {int32Ty, int32Ty, int32Ty, int64Ty}, false));
+    auto *bufferTy = FunctionType::get(voidTy, {int32Ty, int32Ty, ptrTy, int64Ty, int32Ty}, false);
+    FunctionCallee bufferFn = M.getOrInsertFunction(RecordBuffer, bufferTy);
+    FunctionCallee outputFn = M.getOrInsertFunction(RecordOutput, bufferTy);
+    FunctionCallee finishFn = M.getOrInsertFunction(RecordFinish, FunctionType::get(voidTy, {int32Ty}, false));
+
+    // 运行时只在命中的那次调用里记录，其余调用中这些调用立即返回
+    IRBuilder<> builder(&*F->getEntryBlock().getFirstInsertionPt());
+    Value *active = builder.CreateCall(enterFn, {builder.getInt64(RecordCall)}, "amp.record.active");
+    map<unsigned, Value *> counts;
+    for (Argument &arg : F->args()) {
+        Type *type = arg.getType();
+        Value *index = builder.getInt32(arg.getArgNo());
+        if (type->isIntegerTy()) {
+            builder.CreateCall(scalarFn, {active, index, builder.getInt32(0), builder.CreateSExtOrTrunc(&arg, int64Ty)});
+        } else if (isRecordableFloat(type)) {
+            Value *wide = type->isDoubleTy() ? &arg : builder.CreateFPExt(&arg, builder.getDoubleTy());
+            builder.CreateCall(scalarFn, {active, index, builder.getInt32(1), builder.CreateBitCast(wide, int64Ty)});
+        } else {
+            auto it = extents.find(arg.getArgNo());
+            Value *count = it == extents.end() ? builder.getInt64(0) : extentCount(builder, *F, it->second);
+            int element = it == extents.end() ? RecordI8 : it->second.element;
+            builder.CreateCall(bufferFn, {active, index, &arg, count, builder.getInt32(element)});
+            if (it != extents.end()) counts[arg.getArgNo()] = count;
+        }
+    }
+
+    // 每个返回点保存指针参数所指缓冲区的最终内容，作为回放时比较的参考结果
+    for (auto &BB : *F) {
+        auto *ret = dyn_cast<ReturnInst>(BB.getTerminator());
+        if (!ret) continue;
+        builder.SetInsertPoint(ret);
+        for (auto &[arg, count] : counts) {
+            builder.CreateCall(outputFn, {active, builder.getInt32(arg), F->getArg(arg), count,
+                                          builder.getInt32(extents[arg].element)});
+        }
+        builder.CreateCall(finishFn, {active});
+    }
+
+    errs() << "\033[32m[CallRecord] recording call " << RecordCall << " of " << RecordFunction << ", "
+           << counts.size() << " buffer(s)\033[0m\n";
+    return PreservedAnalyses::none();
+}
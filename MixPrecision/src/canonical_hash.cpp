@@ -0,0 +1,63 @@
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/IR/DebugInfo.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <fstream>
+
+#include "canonical_hash.hpp"
+
+static cl::opt<string> CanonicalHashOut(
+    "canonical-hash-out", cl::init(""), cl::desc("File to write the canonical module hash to"));
+
+// 循环元数据里带有源码位置，本项目的元数据（automxprec.*）只在降精过程中使用，都不影响代码生成
+static bool isIgnoredMetadata(LLVMContext &context, unsigned kind) {
+    if (kind == LLVMContext::MD_dbg || kind == LLVMContext::MD_loop) return true;
+    SmallVector<StringRef, 32> names;
+    context.getMDKindNames(names);
+    return kind < names.size() && names[kind].startswith("automxprec.");
+}
+
+string CanonicalHashPass::computeHash(const Module &M) {
+    ValueToValueMapTy VMap;
+    unique_ptr<Module> clone = CloneModule(M, VMap);
+    StripDebugInfo(*clone);
+    clone->setModuleIdentifier("");
+    clone->setSourceFileName("");
+    if (NamedMDNode *ident = clone->getNamedMetadata("llvm.ident")) clone->eraseNamedMetadata(ident);
+
+    LLVMContext &context = clone->getContext();
+    for (Function &F : *clone) {
+        for (Argument &arg : F.args()) arg.setName("");
+        for (BasicBlock &BB : F) {
+            BB.setName("");
+            for (Instruction &inst : BB) {
+                if (!inst.getType()->isVoidTy()) inst.setName("");
+                SmallVector<pair<unsigned, MDNode *>, 4> metadata;
+                inst.getAllMetadata(metadata);
+                for (auto &[kind, node] : metadata) {
+                    if (isIgnoredMetadata(context, kind)) inst.setMetadata(kind, nullptr);
+                }
+            }
+        }
+    }
+
+    // 打印时局部值按出现顺序编号，元数据按首次引用的顺序编号
+    string text;
+    raw_string_ostream os(text);
+    clone->print(os, nullptr);
+    os.flush();
+    return toHex(SHA256::hash(arrayRefFromStringRef(text)), /*LowerCase=*/true);
+}
+
+PreservedAnalyses CanonicalHashPass::run(Module &M, ModuleAnalysisManager &) {
+    string hash = computeHash(M);
+    errs() << "\033[32m[CanonicalHash] " << hash << "\033[0m\n";
+    if (!CanonicalHashOut.empty()) {
+        std::ofstream out(CanonicalHashOut);
+        out << hash << "\n";
+    }
+    return PreservedAnalyses::all();
+}
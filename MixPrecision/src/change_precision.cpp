@@ -19,6 +19,111 @@
 #include "ParseConfig.hpp"
 
 #include "utils.hpp"
+#include "change_remarks.hpp"
+#include "pass_stats.hpp"
+
+#define DEBUG_TYPE "change-precision"
+
+AMP_STATISTIC(NumVariablesChanged, "Variables whose precision was changed");
+AMP_STATISTIC(NumVariablesSkipped, "Variables already of the requested type");
+AMP_STATISTIC(NumPointersChanged, "Pointer variables whose pointee precision was changed");
+AMP_STATISTIC(NumPointersSkipped, "Pointer variables already of the requested type");
+AMP_STATISTIC(NumInstsCreated, "Instructions created");
+AMP_STATISTIC(NumInstsErased, "Instructions erased");
+AMP_STATISTIC(NumFPExtInserted, "fpext casts inserted");
+AMP_STATISTIC(NumFPTruncInserted, "fptrunc casts inserted");
+AMP_STATISTIC(NumIntToFPInserted, "sitofp/uitofp casts inserted");
+AMP_STATISTIC(NumFPToIntInserted, "fptosi/fptoui casts inserted");
+AMP_STATISTIC(NumBitCastInserted, "bitcasts inserted");
+
+namespace {
+// 变更分散在各个访问者里，新建与删除的指令在 pass 前后清点：删除数由 WeakVH 失效得到，
+// 新建数 = 之后数量 - 之前数量 + 删除数，按操作码分别计，得到各类转换指令的插入数。
+// 只在统计打开时做，WeakVH 会让每次删除多一次查表
+class InstCensus {
+    public:
+        explicit InstCensus(Module &M) : enabled(AreStatisticsEnabled()) {
+            if (!enabled) return;
+            for (auto &F : M) {
+                for (auto &BB : F) {
+                    for (auto &inst : BB) {
+                        before.push_back({WeakVH(&inst), inst.getOpcode()});
+                        countBefore[inst.getOpcode()]++;
+                    }
+                }
+            }
+        }
+
+        void finish(Module &M) {
+            if (!enabled) return;
+            map<unsigned, int64_t> created = countBefore;
+            for (auto &[opcode, count] : created) count = -count;
+            for (auto &F : M) {
+                for (auto &BB : F) {
+                    for (auto &inst : BB) created[inst.getOpcode()]++;
+                }
+            }
+            for (auto &[handle, opcode] : before) {
+                if (handle) continue;
+                created[opcode]++;
+                NumInstsErased++;
+            }
+            for (auto &[opcode, count] : created) {
+                if (count <= 0) continue;
+                NumInstsCreated += count;
+                switch (opcode) {
+                    case Instruction::FPExt: NumFPExtInserted += count; break;
+                    case Instruction::FPTrunc: NumFPTruncInserted += count; break;
+                    case Instruction::SIToFP: case Instruction::UIToFP: NumIntToFPInserted += count; break;
+                    case Instruction::FPToSI: case Instruction::FPToUI: NumFPToIntInserted += count; break;
+                    case Instruction::BitCast: NumBitCastInserted += count; break;
+                    default: break;
+                }
+            }
+        }
+
+    private:
+        bool enabled;
+        vector<pair<WeakVH, unsigned>> before;
+        map<unsigned, int64_t> countBefore;
+};
+
+// 备注的公共参数，与 JSON 配置中的 function / name / type 对应
+template <typename RemarkT>
+RemarkT describe(RemarkT remark, Function &F, StringRef variable, StringRef type) {
+    remark << ore::NV("Function", F.getName()) << ore::NV("Variable", variable) << ore::NV("Type", type);
+    return remark;
+}
+
+// 一个变量的所有使用者处理完、尚未删除旧指令时发出结果：访问者全部处理了为 Applied，
+// 否则每个处理不了的使用者一条 Blocked，再加一条 PartiallyApplied
+void remarkOutcome(ChangeRemarks &remarks, AllocaInst *newTarget, StringRef variable, StringRef type) {
+    Function &F = *newTarget->getFunction();
+    OptimizationRemarkEmitter &ORE = remarks.get(F);
+    vector<ChangeFailure> &failures = changeFailures();
+    for (auto &failure : failures) {
+        ORE.emit([&]() {
+            return describe(OptimizationRemarkMissed(ChangeRemarkPass, "Blocked", DiagnosticLocation(failure.loc),
+                                                     newTarget->getParent()),
+                            F, variable, type)
+                   << ": " << ore::NV("Opcode", failure.opcode) << " user " << ore::NV("Blocker", failure.user)
+                   << " was removed, " << ore::NV("Reason", failure.reason);
+        });
+    }
+    if (failures.empty()) {
+        ORE.emit([&]() {
+            return describe(OptimizationRemark(ChangeRemarkPass, "Applied", newTarget), F, variable, type)
+                   << ": lowered";
+        });
+    } else {
+        ORE.emit([&]() {
+            return describe(OptimizationRemarkMissed(ChangeRemarkPass, "PartiallyApplied", newTarget), F, variable, type)
+                   << ": " << ore::NV("BlockedUses", (unsigned)failures.size()) << " use(s) could not be converted";
+        });
+    }
+    failures.clear();
+}
+}  // namespace
 
 
 void ChangePrecisionPass::safeDeleteInstruction(Instruction* inst) {
@@ -38,10 +143,21 @@ void ChangePrecisionPass::safeDeleteInstruction(Instruction* inst) {
 }
 
 
+void ChangePrecisionPass::tagLowered(AllocaInst *alloca) {
+    LLVMContext &context = alloca->getContext();
+    string id = (alloca->getName() + "@" + alloca->getFunction()->getName()).str();
+    alloca->setMetadata(LoweredVarMD, MDNode::get(context, MDString::get(context, id)));
+}
+
+
 PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM){
-    errs() << "Change precision: \n";
+    if (!AmpQuiet) errs() << "Change precision: \n";
 
-    auto changes = AM.getResult<ParseConfigPass>(M).changes;
+    auto changes = this->changes ? this->changes : AM.getResult<ParseConfigPass>(M).changes;
+    PhaseTimer timer("ChangePrecision");
+    InstCensus census(M);
+    ChangeRemarks remarks;
+    changeFailures().clear();
 
     for(auto &change:changes->at(LOCALVAR)) {
         AllocaInst* newTarget = nullptr;
@@ -50,15 +166,33 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
         //AllocaInst* newTarget = changeLocal(M,v.get());
         auto value = change.get()->getValue();
         auto newTypePD = change.get()->getType()[0];
+        string variable = change->getName();
+        string typeName = newTypePD.to_string();
+        if (!isa<AllocaInst>(value)) {
+            // 配置中的局部变量没有对应的 alloca（参数未落栈等），无法改变精度
+            Function *F = isa<Instruction>(value) ? cast<Instruction>(value)->getFunction()
+                        : isa<Argument>(value)   ? cast<Argument>(value)->getParent() : nullptr;
+            if (F) {
+                remarks.get(*F).emit([&]() {
+                    return describe(OptimizationRemarkMissed(ChangeRemarkPass, "Rejected", &F->getEntryBlock().front()),
+                                    *F, variable, typeName)
+                           << ": " << ore::NV("Reason", "not a local variable");
+                });
+            }
+            continue;
+        }
         if(newTypePD.dep==0){
             auto newType = newTypePD.ty;
             if(AllocaInst *oldTarget = dyn_cast<AllocaInst>(value)){
                 Type* oldType = oldTarget->getAllocatedType();
-                errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
-                errs()<< "\tVariable\t\"" << oldTarget->getName() << "\"\t" << *oldType<< "\t-->\t" << *newType << "\n";
-                errs().resetColor();
+                if (!AmpQuiet) {
+                    errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
+                    errs()<< "\tVariable\t\"" << oldTarget->getName() << "\"\t" << *oldType<< "\t-->\t" << *newType << "\n";
+                    errs().resetColor();
+                }
 
                 if(oldType->getTypeID()!=newType->getTypeID()){
+                    NumVariablesChanged++;
                     unsigned alignment = getAlignment(newType);
                     Align Alignment(alignment);
                     auto &DL=M.getDataLayout();    
@@ -76,6 +210,7 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
                             eraseInsts.push_back(dyn_cast<Instruction>(use.getUser()));
                         }
                     }
+                    remarkOutcome(remarks, newTarget, variable, typeName);
 
                     if (newType->isHalfTy()) {
                         for (auto &use : oldTarget->uses()) {
@@ -120,9 +255,17 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
 
                 }
                 else{
-                    errs().changeColor(raw_ostream::RED, /*bold=*/true);
-                    errs()<< "\tNo precision conversion is needed for the variable\t"<< oldTarget->getName() <<"\n";
-                    errs().resetColor();
+                    NumVariablesSkipped++;
+                    remarks.get(*oldTarget->getFunction()).emit([&]() {
+                        return describe(OptimizationRemarkAnalysis(ChangeRemarkPass, "Unchanged", oldTarget),
+                                        *oldTarget->getFunction(), variable, typeName)
+                               << ": already of the requested type";
+                    });
+                    if (!AmpQuiet) {
+                        errs().changeColor(raw_ostream::RED, /*bold=*/true);
+                        errs()<< "\tNo precision conversion is needed for the variable\t"<< oldTarget->getName() <<"\n";
+                        errs().resetColor();
+                    }
                 }
 
             }
@@ -132,11 +275,14 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
             AllocaInst *oldTarget = dyn_cast<AllocaInst>(value);
             PointerType* oldPointerType = dyn_cast<PointerType>(oldTarget->getType());
             auto oldpd=resolvePointerElementType(oldTarget);
-            errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
-            errs() << "\tPointer\t\"" << oldTarget->getName() << "\"\t" <<oldpd<< "\t-->\t" << newType << "\n";
-            errs().resetColor();
+            if (!AmpQuiet) {
+                errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
+                errs() << "\tPointer\t\"" << oldTarget->getName() << "\"\t" <<oldpd<< "\t-->\t" << newType << "\n";
+                errs().resetColor();
+            }
             auto &DL = M.getDataLayout();
             if(oldpd!=newType){
+                NumPointersChanged++;
                 newTarget = new AllocaInst(newType.getPoint(), DL.getAllocaAddrSpace(), getInt32(context, 1), "", oldTarget);
                 unsigned alignment = getAlignment(newType.ty);
                 Align Alignment(alignment);
@@ -154,6 +300,7 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
                         }
                     }
                 }
+                remarkOutcome(remarks, newTarget, variable, typeName);
 
                 for (Instruction *inst : eraseInsts) {
                     inst->eraseFromParent();
@@ -162,19 +309,34 @@ PreservedAnalyses ChangePrecisionPass::run(Module &M, ModuleAnalysisManager &AM)
                 oldTarget->eraseFromParent();
             }
             else{
-                errs().changeColor(raw_ostream::RED, /*bold=*/true);
-                errs()<< "\tNo precision conversion is needed for the variable\t"<< oldTarget->getName() <<"\n";
-                errs().resetColor();
+                NumPointersSkipped++;
+                remarks.get(*oldTarget->getFunction()).emit([&]() {
+                    return describe(OptimizationRemarkAnalysis(ChangeRemarkPass, "Unchanged", oldTarget),
+                                    *oldTarget->getFunction(), variable, typeName)
+                           << ": already of the requested type";
+                });
+                if (!AmpQuiet) {
+                    errs().changeColor(raw_ostream::RED, /*bold=*/true);
+                    errs()<< "\tNo precision conversion is needed for the variable\t"<< oldTarget->getName() <<"\n";
+                    errs().resetColor();
+                }
             }
         }
         
         if(newTarget){
+            tagLowered(newTarget);
+            PhaseTimer metadataTimer("updateMetadata");
             updateMetadata(M, value, newTarget, newTypePD.ty);
         }
     }
-    
 
-    errs() << "Change precision completed!!! \n";
+    for(auto &change:changes->at(REGION)) {
+        PhaseTimer regionTimer("changeRegion");
+        changeRegion(M, *change);
+    }
+    census.finish(M);
+
+    if (!AmpQuiet) errs() << "Change precision completed!!! \n";
     return PreservedAnalyses::none();
 }
 
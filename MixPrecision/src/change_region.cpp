@@ -0,0 +1,282 @@
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/LoopIterator.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "change_precision.hpp"
+#include "change_remarks.hpp"
+#include "pass_stats.hpp"
+#include "pragma_metadata.hpp"
+
+#define DEBUG_TYPE "change-precision"
+
+AMP_STATISTIC(NumRegionsChanged, "Loop regions lowered");
+
+// 循环嵌套区域降精：区域内的浮点运算、只在区域内使用的局部变量全部降到目标精度，
+// 类型转换只出现在进入区域（预头部 / load 之后）和离开区域（store / 区域外使用）的位置。
+
+static bool isWiderFP(Type *type, Type *newType) {
+    return type->isFloatingPointTy() && type->getTypeID() <= Type::DoubleTyID &&
+           type->getTypeID() > newType->getTypeID();
+}
+
+// libm 函数到同名 intrinsic 的映射，f16/f32 版本由后端负责展开
+static Intrinsic::ID getLibmIntrinsic(StringRef name) {
+    static const std::map<std::string, Intrinsic::ID> libm = {
+        {"sqrt", Intrinsic::sqrt},   {"fabs", Intrinsic::fabs},
+        {"sin", Intrinsic::sin},     {"cos", Intrinsic::cos},
+        {"exp", Intrinsic::exp},     {"exp2", Intrinsic::exp2},
+        {"log", Intrinsic::log},     {"log2", Intrinsic::log2},
+        {"log10", Intrinsic::log10}, {"pow", Intrinsic::pow},
+        {"floor", Intrinsic::floor}, {"ceil", Intrinsic::ceil},
+        {"trunc", Intrinsic::trunc}, {"round", Intrinsic::round},
+        {"fma", Intrinsic::fma},     {"fmin", Intrinsic::minnum},
+        {"fmax", Intrinsic::maxnum}, {"copysign", Intrinsic::copysign},
+    };
+    auto it = libm.find(name.str());
+    return it == libm.end() ? Intrinsic::not_intrinsic : it->second;
+}
+
+// 只被区域内 load/store 访问的标量浮点局部变量，可以直接换成低精度 alloca
+static bool isConfinedAlloca(AllocaInst *alloca, Loop &loop, Type *newType) {
+    if (!isWiderFP(alloca->getAllocatedType(), newType) || alloca->isArrayAllocation() ||
+        alloca->getMetadata(PragmaKeepMD))
+        return false;
+    for (User *user : alloca->users()) {
+        auto *inst = dyn_cast<Instruction>(user);
+        if (!inst || !loop.contains(inst))
+            return false;
+        if (auto *store = dyn_cast<StoreInst>(inst)) {
+            if (store->getValueOperand() == alloca)
+                return false;
+        } else if (!isa<LoadInst>(inst)) {
+            return false;
+        }
+    }
+    return !alloca->use_empty();
+}
+
+void ChangePrecisionPass::changeRegion(Module &module, const Change &change) {
+    auto *header = dyn_cast<BasicBlock>(change.getValue());
+    Type *newType = change.getType()[0].ty;
+    if (!header || !newType || !newType->isFloatingPointTy())
+        return;
+
+    Function &func = *header->getParent();
+    LLVMContext &context = module.getContext();
+    DominatorTree DT(func);
+    LoopInfo LI(DT);
+    Loop *loop = LI.getLoopFor(header);
+    OptimizationRemarkEmitter ORE(&func);
+    if (!loop || loop->getHeader() != header) {
+        ORE.emit([&]() {
+            return OptimizationRemarkMissed(ChangeRemarkPass, "Rejected", &header->front())
+                   << ore::NV("Function", func.getName()) << ore::NV("Variable", header->getName())
+                   << ": " << ore::NV("Reason", "not a loop header");
+        });
+        return;
+    }
+
+    NumRegionsChanged++;
+    ORE.emit([&]() {
+        DebugLoc loc = loop->getStartLoc();
+        return OptimizationRemark(ChangeRemarkPass, "Applied", loc, header)
+               << ore::NV("Function", func.getName())
+               << ore::NV("Variable", loc ? "loop:" + std::to_string(loc.getLine()) : header->getName().str())
+               << ore::NV("Type", newType) << ": region lowered";
+    });
+    if (!AmpQuiet) {
+        errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
+        errs() << "\tRegion\t\"" << func.getName() << ":" << header->getName() << "\"\t"
+               << "depth " << loop->getLoopDepth() << "\t-->\t" << *newType << "\n";
+        errs().resetColor();
+    }
+
+    BasicBlock *preheader = loop->getLoopPreheader();
+    std::map<Value *, Value *> lowered;
+    std::vector<Instruction *> deadInsts;
+
+    // 把一个高精度值转成区域内使用的低精度值，每个值只转换一次、所有使用者共用：
+    // 区域外定义的值在预头部转换，区域内的值紧跟在定义之后转换
+    auto lower = [&](Value *value, Instruction *insertBefore) -> Value * {
+        auto it = lowered.find(value);
+        if (it != lowered.end())
+            return it->second;
+        if (auto *ext = dyn_cast<FPExtInst>(value)) {
+            if (ext->getSrcTy() == newType)
+                return ext->getOperand(0);
+        }
+        if (!isWiderFP(value->getType(), newType))
+            return value;
+        if (auto *constant = dyn_cast<ConstantFP>(value)) {
+            APFloat f = constant->getValueAPF();
+            bool losesInfo = false;
+            f.convert(newType->getFltSemantics(), APFloat::rmNearestTiesToEven, &losesInfo);
+            return lowered[value] = ConstantFP::get(context, f);
+        }
+
+        auto *inst = dyn_cast<Instruction>(value);
+        if ((!inst || !loop->contains(inst)) && preheader) {
+            return lowered[value] = new FPTruncInst(value, newType, "", preheader->getTerminator());
+        }
+        if (!inst) {
+            return lowered[value] = new FPTruncInst(value, newType, "", &*func.getEntryBlock().getFirstInsertionPt());
+        }
+        if (inst->isTerminator()) {
+            // invoke 的结果没有紧随其后的插入点，只能逐个使用者转换
+            return new FPTruncInst(value, newType, "", insertBefore);
+        }
+        Instruction *after = isa<PHINode>(inst) ? &*inst->getParent()->getFirstInsertionPt() : inst->getNextNode();
+        return lowered[value] = new FPTruncInst(value, newType, "", after);
+    };
+
+    // 用低精度结果替换原指令，原指令的其他使用者拿到扩展回原精度的值
+    auto replace = [&](Instruction &inst, Instruction *newInst) {
+        auto *ext = new FPExtInst(newInst, inst.getType(), "", &inst);
+        inst.replaceAllUsesWith(ext);
+        lowered[ext] = newInst;
+        deadInsts.push_back(&inst);
+    };
+
+    // 1. 区域内独占的局部变量换成低精度 alloca
+    std::vector<std::pair<AllocaInst *, AllocaInst *>> allocas;
+    for (auto &inst : func.getEntryBlock()) {
+        if (auto *alloca = dyn_cast<AllocaInst>(&inst)) {
+            if (isConfinedAlloca(alloca, *loop, newType)) {
+                unsigned alignment = getAlignment(newType);
+                auto *newAlloca = new AllocaInst(newType, alloca->getType()->getAddressSpace(),
+                                                 nullptr, Align(alignment), "", alloca);
+                newAlloca->takeName(alloca);
+                tagLowered(newAlloca);
+                allocas.emplace_back(alloca, newAlloca);
+            }
+        }
+    }
+    std::map<Value *, AllocaInst *> retyped;
+    for (auto &[oldAlloca, newAlloca] : allocas) {
+        retyped[oldAlloca] = newAlloca;
+    }
+
+    // 2. 按区域内逆后序遍历，保证操作数先于使用者被降精
+    LoopBlocksRPO RPOT(loop);
+    RPOT.perform(&LI);
+    std::vector<StoreInst *> stores;
+    std::vector<std::pair<PHINode *, PHINode *>> phis;
+    for (BasicBlock *block : RPOT) {
+        for (Instruction &inst : make_early_inc_range(*block)) {
+            if (auto *load = dyn_cast<LoadInst>(&inst)) {
+                auto it = retyped.find(load->getPointerOperand());
+                if (it != retyped.end()) {
+                    auto *newLoad = new LoadInst(newType, it->second, "", false,
+                                                 it->second->getAlign(), load);
+                    replace(*load, newLoad);
+                } else if (isWiderFP(load->getType(), newType)) {
+                    auto *trunc = new FPTruncInst(load, newType, "");
+                    trunc->insertAfter(load);
+                    lowered[load] = trunc;
+                }
+            } else if (auto *store = dyn_cast<StoreInst>(&inst)) {
+                if (retyped.count(store->getPointerOperand()))
+                    stores.push_back(store);
+            } else if (auto *phi = dyn_cast<PHINode>(&inst)) {
+                // 循环携带的值（归约、迭代变量）整体留在低精度，入边值在第 3 步填入
+                if (!isWiderFP(phi->getType(), newType))
+                    continue;
+                auto *newPhi = PHINode::Create(newType, phi->getNumIncomingValues(), "", phi);
+                auto *ext = new FPExtInst(newPhi, phi->getType(), "", block->getFirstNonPHI());
+                phi->replaceAllUsesWith(ext);
+                lowered[ext] = newPhi;
+                phis.emplace_back(phi, newPhi);
+                deadInsts.push_back(phi);
+            } else if (auto *binop = dyn_cast<BinaryOperator>(&inst)) {
+                if (!isWiderFP(binop->getType(), newType))
+                    continue;
+                auto *newOp = BinaryOperator::Create(binop->getOpcode(),
+                                                     lower(binop->getOperand(0), binop),
+                                                     lower(binop->getOperand(1), binop), "", binop);
+                newOp->copyIRFlags(binop);
+                replace(*binop, newOp);
+            } else if (auto *unop = dyn_cast<UnaryOperator>(&inst)) {
+                if (unop->getOpcode() != Instruction::FNeg || !isWiderFP(unop->getType(), newType))
+                    continue;
+                auto *newOp = UnaryOperator::Create(Instruction::FNeg,
+                                                    lower(unop->getOperand(0), unop), "", unop);
+                newOp->copyIRFlags(unop);
+                replace(*unop, newOp);
+            } else if (auto *fcmp = dyn_cast<FCmpInst>(&inst)) {
+                if (!isWiderFP(fcmp->getOperand(0)->getType(), newType))
+                    continue;
+                auto *newCmp = new FCmpInst(fcmp, fcmp->getPredicate(),
+                                            lower(fcmp->getOperand(0), fcmp),
+                                            lower(fcmp->getOperand(1), fcmp), "");
+                fcmp->replaceAllUsesWith(newCmp);
+                deadInsts.push_back(fcmp);
+            } else if (auto *sitofp = dyn_cast<SIToFPInst>(&inst)) {
+                if (!isWiderFP(sitofp->getType(), newType))
+                    continue;
+                replace(*sitofp, new SIToFPInst(sitofp->getOperand(0), newType, "", sitofp));
+            } else if (auto *uitofp = dyn_cast<UIToFPInst>(&inst)) {
+                if (!isWiderFP(uitofp->getType(), newType))
+                    continue;
+                replace(*uitofp, new UIToFPInst(uitofp->getOperand(0), newType, "", uitofp));
+            } else if (auto *call = dyn_cast<CallInst>(&inst)) {
+                Function *callee = call->getCalledFunction();
+                if (!callee || !isWiderFP(call->getType(), newType))
+                    continue;
+                Intrinsic::ID id = callee->isIntrinsic() ? callee->getIntrinsicID()
+                                                         : getLibmIntrinsic(callee->getName());
+                if (id == Intrinsic::not_intrinsic || !Intrinsic::isOverloaded(id))
+                    continue;
+                bool allFP = std::all_of(call->arg_begin(), call->arg_end(), [&](Use &arg) {
+                    return arg->getType() == call->getType();
+                });
+                if (!allFP)
+                    continue;
+
+                std::vector<Value *> args;
+                for (Use &arg : call->args())
+                    args.push_back(lower(arg.get(), call));
+                Function *decl = Intrinsic::getDeclaration(&module, id, {newType});
+                replace(*call, CallInst::Create(decl, args, "", call));
+            }
+        }
+    }
+
+    // 3. 区域内的 PHI：回边上的值此时已在循环体中降精，预头部进来的值在预头部转换
+    for (auto &[phi, newPhi] : phis) {
+        for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+            BasicBlock *incoming = phi->getIncomingBlock(i);
+            newPhi->addIncoming(lower(phi->getIncomingValue(i), incoming->getTerminator()), incoming);
+        }
+    }
+
+    // 4. 低精度变量的 store 最后处理，此时被存储的值已经有低精度版本
+    for (StoreInst *store : stores) {
+        AllocaInst *newAlloca = retyped[store->getPointerOperand()];
+        new StoreInst(lower(store->getValueOperand(), store), newAlloca, false,
+                      newAlloca->getAlign(), store);
+        deadInsts.push_back(store);
+    }
+
+    for (auto it = deadInsts.rbegin(); it != deadInsts.rend(); ++it) {
+        (*it)->eraseFromParent();
+    }
+
+    for (auto &[oldAlloca, newAlloca] : allocas) {
+        if (!AmpQuiet) {
+            errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
+            errs() << "\t\tVariable\t\"" << newAlloca->getName() << "\"\t"
+                   << *oldAlloca->getAllocatedType() << "\t-->\t" << *newType << "\n";
+            errs().resetColor();
+        }
+        updateMetadata(module, oldAlloca, newAlloca, newType);
+        oldAlloca->eraseFromParent();
+    }
+}
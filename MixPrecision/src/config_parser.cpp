@@ -63,6 +63,15 @@ std::map<std::string, std::unique_ptr<StrChange>> parse_config(const std::string
                 std::string function = entry.value("function", "");
                 id = name + "@" + function;
                 field = entry.value("field", -1);
+            } else if (classification == "region") {
+                // 循环嵌套区域：以 函数 + 循环头调试位置 标识，col 可省略
+                std::string function = entry.value("function", "");
+                int line = entry.value("line", 0);
+                int col = entry.value("col", 0);
+                if (function.empty() || line <= 0) continue;
+                id = "loop:" + std::to_string(line);
+                if (col > 0) id += ":" + std::to_string(col);
+                id += "@" + function;
             } else {
                 id = entry.value("id", entry.value("name", ""));
                 field = entry.value("field", -1);  // some may have field (structs)
@@ -82,6 +91,7 @@ std::map<std::string, std::unique_ptr<StrChange>> parse_config(const std::string
     handle_section("localVar", "localVar");
     handle_section("op",       "op");
     handle_section("call",     "call", true);
+    handle_section("region",   "region");
 
     return changes;
 }
@@ -0,0 +1,229 @@
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+#include "fat_config.hpp"
+#include "fork_server.hpp"
+#include "pragma_metadata.hpp"
+#include "precision_lowering.hpp"
+
+using Json = nlohmann::json;
+
+static cl::list<string> FatConfigs(
+    "fat-configs", cl::CommaSeparated,
+    cl::desc("Config files compiled into one binary, the i-th is selected by AMP_CONFIG=i"));
+static cl::opt<string> FatConfigMerged(
+    "fat-config-merged", cl::init("fat_config.merged.json"),
+    cl::desc("Where fat-config writes the merged config of all variants"));
+
+// 只有 localVar / region 条目按函数生效，可以落到函数克隆上
+static const char *FunctionSections[] = {"localVar", "region"};
+
+bool FatConfigPass::loadConfig(const string &path, FunctionEntries &entries) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        errs() << "\033[31m[FatConfig] Failed to open file: " << path << "\033[0m\n";
+        return false;
+    }
+
+    Json root;
+    try {
+        file >> root;
+    } catch (const std::exception &e) {
+        errs() << "\033[31m[FatConfig] JSON parse error in " << path << ": " << e.what() << "\033[0m\n";
+        return false;
+    }
+
+    for (const char *section : FunctionSections) {
+        if (!root.contains(section) || !root[section].is_array()) continue;
+        for (const auto &entry : root[section]) {
+            string function = entry.value("function", "");
+            if (function.empty()) continue;
+            Json &sectionEntries = entries[function][section];
+            if (sectionEntries.is_null()) sectionEntries = Json::array();
+            sectionEntries.push_back(entry);
+        }
+    }
+
+    for (const char *section : {"globalVar", "op", "call"}) {
+        if (root.contains(section) && !root[section].empty()) {
+            errs() << "[FatConfig] " << path << ": \"" << section << "\" entries are not per-function, ignored\n";
+        }
+    }
+
+    // 条目顺序不影响结果，排序后才能按内容判断两份配置是否一致
+    for (auto &[function, sections] : entries) {
+        for (auto &[section, list] : sections.items()) {
+            std::sort(list.begin(), list.end(),
+                      [](const Json &a, const Json &b) { return a.dump() < b.dump(); });
+        }
+    }
+    return true;
+}
+
+Function *FatConfigPass::cloneVariant(Function &F, const string &suffix) {
+    ValueToValueMapTy VMap;
+    Function *clone = CloneFunction(&F, VMap);
+    clone->setName(F.getName() + suffix);
+    clone->setLinkage(GlobalValue::InternalLinkage);
+    clone->setVisibility(GlobalValue::DefaultVisibility);
+    return clone;
+}
+
+// F 原有的函数体换成：按下标调用对应变体并返回其结果
+void FatConfigPass::buildDispatcher(Function &F, Function *base, const vector<Function *> &perConfig,
+                                    GlobalVariable *index) {
+    LLVMContext &context = F.getContext();
+    GlobalValue::LinkageTypes linkage = F.getLinkage();
+    F.deleteBody();
+    F.setLinkage(linkage);
+    F.removeFnAttr(Attribute::OptimizeNone);
+    F.removeFnAttr(Attribute::NoInline);
+
+    BasicBlock *entry = BasicBlock::Create(context, "entry", &F);
+    IRBuilder<> builder(entry);
+    Value *selected = builder.CreateLoad(index->getValueType(), index, "config");
+
+    vector<Value *> args;
+    for (auto &arg : F.args()) args.push_back(&arg);
+
+    map<Function *, BasicBlock *> targets;
+    auto getTarget = [&](Function *callee) {
+        BasicBlock *&block = targets[callee];
+        if (block) return block;
+        block = BasicBlock::Create(context, callee->getName(), &F);
+        IRBuilder<> callBuilder(block);
+        CallInst *call = callBuilder.CreateCall(callee, args);
+        call->setTailCall();
+        if (F.getReturnType()->isVoidTy()) {
+            callBuilder.CreateRetVoid();
+        } else {
+            callBuilder.CreateRet(call);
+        }
+        return block;
+    };
+
+    // 没有 base（每个配置都有自己的变体）时以配置 0 的变体作为默认分支
+    Function *fallback = base ? base : perConfig.front();
+    SwitchInst *dispatch = builder.CreateSwitch(selected, getTarget(fallback), perConfig.size());
+    for (unsigned i = 0; i < perConfig.size(); i++) {
+        if (perConfig[i] != fallback) {
+            dispatch->addCase(ConstantInt::get(cast<IntegerType>(selected->getType()), i), getTarget(perConfig[i]));
+        }
+    }
+}
+
+bool FatConfigPass::insertSelector(Module &M, GlobalVariable *index, unsigned numConfigs) {
+    Function *newMain = wrapMain(M, FatConfigOrigMain, [&](IRBuilder<> &builder, Value *argcSlot, Value *argvSlot) {
+        Type *ptrTy = PointerType::getUnqual(M.getContext());
+        Type *intTy = builder.getInt32Ty();
+        FunctionCallee select = M.getOrInsertFunction(
+            FatConfigSelect, FunctionType::get(intTy, {ptrTy, ptrTy, intTy}, false));
+        Value *selected = builder.CreateCall(select, {argcSlot, argvSlot, builder.getInt32(numConfigs)});
+        builder.CreateStore(selected, index);
+    });
+    return newMain != nullptr;
+}
+
+PreservedAnalyses FatConfigPass::run(Module &M, ModuleAnalysisManager &AM) {
+    if (FatConfigs.empty()) {
+        errs() << "\033[31m[FatConfig] no -fat-configs given\033[0m\n";
+        return PreservedAnalyses::all();
+    }
+    // 选择器若包在 fork server 之外，只会在 fork 之前选一次，之后每次运行都用同一个配置
+    if (M.getFunction(ForkServerOrigMain)) {
+        errs() << "\033[31m[FatConfig] main already wrapped by fork-server, run fat-config before it\033[0m\n";
+        return PreservedAnalyses::all();
+    }
+
+    vector<FunctionEntries> configs(FatConfigs.size());
+    for (unsigned i = 0; i < FatConfigs.size(); i++) {
+        if (!loadConfig(FatConfigs[i], configs[i])) return PreservedAnalyses::all();
+    }
+
+    // 克隆前先把 pragma 注解落到指令上，变体与原函数共享源码中的 pragma
+    PragmaMetadataPass().run(M, AM);
+
+    LLVMContext &context = M.getContext();
+    auto *index = new GlobalVariable(M, Type::getInt32Ty(context), false, GlobalValue::InternalLinkage,
+                                     ConstantInt::get(Type::getInt32Ty(context), 0), FatConfigIndex);
+
+    set<string> functions;
+    for (auto &config : configs) {
+        for (auto &[function, sections] : config) functions.insert(function);
+    }
+
+    Json merged = {{"localVar", Json::array()}, {"region", Json::array()}};
+    unsigned numVariants = 0;
+
+    for (const string &name : functions) {
+        Function *F = M.getFunction(name);
+        if (!F || F->isDeclaration() || F->isVarArg()) {
+            errs() << "\033[31m[FatConfig] cannot clone function " << name << ", its entries are ignored\033[0m\n";
+            continue;
+        }
+
+        // 内容相同的条目集合共用一个变体，没有条目的配置使用原函数体
+        Function *base = nullptr;
+        map<string, Function *> variants;
+        vector<Function *> perConfig(configs.size(), nullptr);
+        vector<Function *> created;
+
+        for (unsigned i = 0; i < configs.size(); i++) {
+            auto it = configs[i].find(name);
+            if (it == configs[i].end()) continue;
+
+            Function *&variant = variants[it->second.dump()];
+            if (!variant) {
+                variant = cloneVariant(*F, ".amp.v" + std::to_string(variants.size() - 1));
+                created.push_back(variant);
+                for (auto &[section, list] : it->second.items()) {
+                    for (Json entry : list) {
+                        entry["function"] = variant->getName().str();
+                        merged[section].push_back(entry);
+                    }
+                }
+            }
+            perConfig[i] = variant;
+        }
+
+        // 每个配置都有条目时原函数体不会被调用，不再克隆
+        if (std::count(perConfig.begin(), perConfig.end(), nullptr)) {
+            base = cloneVariant(*F, ".amp.base");
+            for (auto &variant : perConfig) {
+                if (!variant) variant = base;
+            }
+        }
+        buildDispatcher(*F, base, perConfig, index);
+
+        numVariants += created.size();
+        errs().changeColor(raw_ostream::GREEN, /*bold=*/true);
+        errs() << "\t[FatConfig] " << name << ": " << created.size() << " variant(s) for "
+               << configs.size() << " config(s)\n";
+        errs().resetColor();
+    }
+
+    if (!insertSelector(M, index, configs.size())) {
+        errs() << "\033[31m[FatConfig] main not wrapped, config 0 is always used\033[0m\n";
+    }
+
+    std::ofstream out(FatConfigMerged);
+    out << merged.dump(4);
+    out.close();
+    errs() << "[FatConfig] " << numVariants << " variant(s), merged config written to " << FatConfigMerged << "\n";
+
+    ParseConfigPass parseConfig(FatConfigMerged);
+    ParseConfigResult result = parseConfig.run(M, AM);
+    // 变体与分发函数已经建好，此时不能退回 -json-config 的配置降精，也不能留下未降精的多配置模块
+    if (!result.changes) {
+        errs() << "\033[31m[FatConfig] cannot load merged config " << FatConfigMerged << "\033[0m\n";
+        exit(1);
+    }
+    PrecisionLoweringPass(result.changes).run(M, AM);
+    return PreservedAnalyses::none();
+}
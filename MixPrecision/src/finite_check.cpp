@@ -0,0 +1,208 @@
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+
+#include <set>
+
+#include "change_precision.hpp"
+#include "finite_check.hpp"
+#include "pass_stats.hpp"
+
+cl::opt<bool> CheckFinite(
+    "check-finite", cl::init(false),
+    cl::desc("Exit with code 86 on the first Inf/NaN produced by lowered code"));
+
+// 地址属于降精变量时返回其 ID：变量本身（标量、数组）或降精指针变量指向的内存
+static string getLoweredID(Value *pointer) {
+    Value *object = getUnderlyingObject(pointer);
+    if (auto *load = dyn_cast<LoadInst>(object)) {
+        object = getUnderlyingObject(load->getPointerOperand());
+    }
+    auto *alloca = dyn_cast<AllocaInst>(object);
+    MDNode *node = alloca ? alloca->getMetadata(LoweredVarMD) : nullptr;
+    return node ? cast<MDString>(node->getOperand(0))->getString().str() : "";
+}
+
+// 报告降精变量的 ID，GA 据此处理失败的配置；fptrunc 取它写入或读出的降精变量，
+// 都找不到时才按源码位置命名
+static string getCheckID(Instruction &inst) {
+    string id;
+    if (auto *store = dyn_cast<StoreInst>(&inst)) {
+        id = getLoweredID(store->getPointerOperand());
+    } else if (auto *trunc = dyn_cast<FPTruncInst>(&inst)) {
+        for (User *user : trunc->users()) {
+            if (auto *store = dyn_cast<StoreInst>(user); store && store->getValueOperand() == trunc) {
+                id = getLoweredID(store->getPointerOperand());
+                if (!id.empty()) break;
+            }
+        }
+        Value *source = trunc->getOperand(0);
+        if (auto *ext = dyn_cast<FPExtInst>(source)) source = ext->getOperand(0);
+        if (auto *load = dyn_cast<LoadInst>(source); id.empty() && load) {
+            id = getLoweredID(load->getPointerOperand());
+        }
+    }
+    if (!id.empty()) return id;
+
+    id = inst.getFunction()->getName().str();
+    if (const DILocation *loc = inst.getDebugLoc()) {
+        id += ":" + std::to_string(loc->getLine()) + ":" + std::to_string(loc->getColumn());
+    }
+    return id;
+}
+
+static bool isLoweredStore(StoreInst *store) {
+    auto *alloca = dyn_cast<AllocaInst>(getUnderlyingObject(store->getPointerOperand()));
+    return alloca && alloca->getMetadata(LoweredVarMD) &&
+           store->getValueOperand()->getType()->isFloatingPointTy();
+}
+
+static bool isLoweredTrunc(FPTruncInst *trunc) {
+    Type *type = trunc->getDestTy();
+    if (!type->isHalfTy() && !type->isFloatTy()) return false;
+    // 源码中原本就有的 fptrunc（用户自己写成 float 的值）不算降精产生的值
+    if (!trunc->getMetadata(LoweredTruncMD)) return false;
+    // 只用于写入降精变量的 fptrunc 由 store 的检查覆盖
+    for (User *user : trunc->users()) {
+        auto *store = dyn_cast<StoreInst>(user);
+        if (!store || !isLoweredStore(store)) return true;
+    }
+    return trunc->use_empty();
+}
+
+void FiniteCheckPass::accumulate(Instruction *after, Value *value, Mask &mask, const string &id) {
+    auto [it, inserted] = mask.index.insert({id, mask.ids.size()});
+    if (inserted) mask.ids.push_back(id);
+    unsigned bit = it->second % 64;
+
+    IRBuilder<> builder(after->getNextNode());
+    // Inf - Inf 与 NaN - NaN 都是 NaN，有限值相减为 0
+    Value *diff = builder.CreateFSub(value, value);
+    Value *bad = builder.CreateFCmpUNO(diff, ConstantFP::get(value->getType(), 0.0));
+    Value *flag = builder.CreateShl(builder.CreateZExt(bad, builder.getInt64Ty()), bit);
+    Value *current = builder.CreateLoad(builder.getInt64Ty(), mask.slot);
+    builder.CreateStore(builder.CreateOr(current, flag), mask.slot);
+}
+
+GlobalVariable *FiniteCheckPass::getTable(Module &M, Mask &mask) {
+    if (mask.table) return mask.table;
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+
+    vector<Constant *> ids;
+    for (const string &id : mask.ids) {
+        auto *str = new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(context), id.size() + 1), true,
+                                       GlobalValue::PrivateLinkage, ConstantDataArray::getString(context, id),
+                                       "amp.finite.id");
+        ids.push_back(ConstantExpr::getPointerCast(str, ptrTy));
+    }
+    auto *tableTy = ArrayType::get(ptrTy, ids.size());
+    mask.table = new GlobalVariable(M, tableTy, true, GlobalValue::PrivateLinkage,
+                                    ConstantArray::get(tableTy, ids), "amp.finite.ids");
+    return mask.table;
+}
+
+void FiniteCheckPass::insertCheck(Instruction *before, Mask &mask) {
+    Module &M = *before->getModule();
+    IRBuilder<> builder(before);
+    Value *bits = builder.CreateLoad(builder.getInt64Ty(), mask.slot);
+    Value *failed = builder.CreateICmpNE(bits, builder.getInt64(0));
+
+    Instruction *then = SplitBlockAndInsertIfThen(failed, before, /*Unreachable=*/true);
+    then->getParent()->setName("amp.nonfinite");
+    builder.SetInsertPoint(then);
+
+    Type *ptrTy = PointerType::getUnqual(M.getContext());
+    FunctionCallee report = M.getOrInsertFunction(
+        NonFiniteReport, FunctionType::get(builder.getVoidTy(), {builder.getInt64Ty(), ptrTy, builder.getInt32Ty()},
+                                           false));
+    if (auto *fn = dyn_cast<Function>(report.getCallee())) {
+        fn->setDoesNotReturn();
+        fn->addFnAttr(Attribute::Cold);
+    }
+    builder.CreateCall(report, {bits, getTable(M, mask), builder.getInt32(mask.ids.size())});
+}
+
+bool FiniteCheckPass::runOnFunction(Function &F) {
+    vector<Instruction *> candidates;
+    for (auto &BB : F) {
+        for (auto &inst : BB) {
+            if (auto *store = dyn_cast<StoreInst>(&inst); store && isLoweredStore(store)) {
+                candidates.push_back(store);
+            } else if (auto *trunc = dyn_cast<FPTruncInst>(&inst); trunc && isLoweredTrunc(trunc)) {
+                candidates.push_back(trunc);
+            }
+        }
+    }
+    if (candidates.empty()) return false;
+
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+
+    // 掩码的 alloca 放在入口并清零，不在循环中的值共用 nullptr 对应的掩码
+    map<Loop *, Mask> masks;
+    IRBuilder<> entryBuilder(&*F.getEntryBlock().getFirstInsertionPt());
+    auto getMask = [&](Loop *loop) -> Mask & {
+        Mask &mask = masks[loop];
+        if (!mask.slot) {
+            mask.slot = entryBuilder.CreateAlloca(entryBuilder.getInt64Ty(), nullptr, "amp.finite.mask");
+        }
+        return mask;
+    };
+
+    set<BasicBlock *> straightBlocks;
+    for (Instruction *inst : candidates) {
+        Loop *loop = LI.getLoopFor(inst->getParent());
+        Value *value = isa<StoreInst>(inst) ? cast<StoreInst>(inst)->getValueOperand() : inst;
+        accumulate(inst, value, getMask(loop), getCheckID(*inst));
+        if (!loop) straightBlocks.insert(inst->getParent());
+    }
+
+    Instruction *afterAllocas = &*F.getEntryBlock().getFirstInsertionPt();
+    while (isa<AllocaInst>(afterAllocas)) afterAllocas = afterAllocas->getNextNode();
+    entryBuilder.SetInsertPoint(afterAllocas);
+    for (auto &[loop, mask] : masks) {
+        entryBuilder.CreateStore(entryBuilder.getInt64(0), mask.slot);
+    }
+
+    // 先收集全部检查点再改 CFG，拆块之后 LoopInfo 不再可用
+    vector<pair<Instruction *, Mask *>> checks;
+    for (auto &[loop, mask] : masks) {
+        if (!loop) {
+            for (BasicBlock *BB : straightBlocks) checks.push_back({BB->getTerminator(), &mask});
+            continue;
+        }
+        // 最内层循环只在出口判断，循环体内只有按位或，不引入提前退出的分支，不妨碍向量化；
+        // 含子循环的外层循环（如 GMRES 的重启循环）不会被向量化，每次迭代末尾在 latch 上检查，不必等到整个求解结束
+        if (!loop->isInnermost()) {
+            SmallVector<BasicBlock *, 4> latches;
+            loop->getLoopLatches(latches);
+            for (BasicBlock *latch : latches) checks.push_back({latch->getTerminator(), &mask});
+        }
+        SmallVector<BasicBlock *, 4> exits;
+        loop->getUniqueExitBlocks(exits);
+        for (BasicBlock *exit : exits) checks.push_back({&*exit->getFirstInsertionPt(), &mask});
+        for (BasicBlock *BB : loop->blocks()) {
+            if (isa<ReturnInst>(BB->getTerminator())) checks.push_back({BB->getTerminator(), &mask});
+        }
+    }
+    for (auto &[before, mask] : checks) {
+        insertCheck(before, *mask);
+    }
+
+    if (!AmpQuiet) {
+        errs() << "\t[FiniteCheck] " << F.getName() << ": " << candidates.size() << " value(s), "
+               << checks.size() << " check point(s)\n";
+    }
+    return true;
+}
+
+PreservedAnalyses FiniteCheckPass::run(Module &M, ModuleAnalysisManager &) {
+    bool changed = false;
+    for (auto &F : M) {
+        if (!F.isDeclaration()) changed |= runOnFunction(F);
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -0,0 +1,77 @@
+#include <llvm/Support/raw_ostream.h>
+
+#include "fork_server.hpp"
+
+Function *wrapMain(Module &M, StringRef origName,
+                   function_ref<void(IRBuilder<> &, Value *, Value *)> hook) {
+    Function *origMain = M.getFunction("main");
+    if (!origMain || origMain->isDeclaration()) {
+        errs() << "\033[31m[wrapMain] no main definition\033[0m\n";
+        return nullptr;
+    }
+
+    // 只处理 int main() / int main(int, char **[, char **]) 两种形式
+    FunctionType *mainTy = origMain->getFunctionType();
+    if (!mainTy->getReturnType()->isIntegerTy() || mainTy->getNumParams() == 1) {
+        errs() << "\033[31m[wrapMain] unsupported main signature\033[0m\n";
+        return nullptr;
+    }
+
+    LLVMContext &context = M.getContext();
+    origMain->setName(origName);
+    origMain->setLinkage(GlobalValue::InternalLinkage);
+
+    Function *newMain = Function::Create(mainTy, GlobalValue::ExternalLinkage, "main", M);
+    newMain->copyAttributesFrom(origMain);
+    newMain->setLinkage(GlobalValue::ExternalLinkage);
+
+    IRBuilder<> builder(BasicBlock::Create(context, "entry", newMain));
+    Type *ptrTy = PointerType::getUnqual(context);
+    Type *intTy = Type::getInt32Ty(context);
+
+    // 没有参数的 main 也交给 hook 一份空的 argc/argv，便于统一处理
+    Value *argcSlot = builder.CreateAlloca(intTy, nullptr, "argc.addr");
+    Value *argvSlot = builder.CreateAlloca(ptrTy, nullptr, "argv.addr");
+    if (mainTy->getNumParams() >= 2) {
+        newMain->getArg(0)->setName("argc");
+        newMain->getArg(1)->setName("argv");
+        builder.CreateStore(builder.CreateTruncOrBitCast(newMain->getArg(0), intTy), argcSlot);
+        builder.CreateStore(newMain->getArg(1), argvSlot);
+    } else {
+        builder.CreateStore(ConstantInt::get(intTy, 0), argcSlot);
+        builder.CreateStore(ConstantPointerNull::get(cast<PointerType>(ptrTy)), argvSlot);
+    }
+
+    hook(builder, argcSlot, argvSlot);
+
+    SmallVector<Value *, 3> args;
+    if (mainTy->getNumParams() >= 2) {
+        args.push_back(builder.CreateSExtOrTrunc(builder.CreateLoad(intTy, argcSlot),
+                                                 mainTy->getParamType(0)));
+        args.push_back(builder.CreateLoad(ptrTy, argvSlot));
+        for (unsigned i = 2; i < mainTy->getNumParams(); i++) args.push_back(newMain->getArg(i));
+    }
+    builder.CreateRet(builder.CreateCall(origMain, args));
+    return newMain;
+}
+
+PreservedAnalyses ForkServerPass::run(Module &M, ModuleAnalysisManager &) {
+    if (M.getFunction(ForkServerOrigMain)) {
+        errs() << "[ForkServer] main already wrapped\n";
+        return PreservedAnalyses::all();
+    }
+
+    Function *newMain = wrapMain(M, ForkServerOrigMain, [&](IRBuilder<> &builder, Value *argcSlot, Value *argvSlot) {
+        Type *ptrTy = PointerType::getUnqual(M.getContext());
+        FunctionCallee entry = M.getOrInsertFunction(
+            ForkServerEntry, FunctionType::get(builder.getVoidTy(), {ptrTy, ptrTy}, false));
+        builder.CreateCall(entry, {argcSlot, argvSlot});
+    });
+    if (!newMain) {
+        errs() << "\033[31m[ForkServer] skipped\033[0m\n";
+        return PreservedAnalyses::all();
+    }
+
+    errs() << "\033[32m[ForkServer] main wrapped with " << ForkServerEntry << "\033[0m\n";
+    return PreservedAnalyses::none();
+}
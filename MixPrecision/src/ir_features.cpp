@@ -0,0 +1,185 @@
+#include <llvm/Analysis/BranchProbabilityInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <set>
+
+#include "change_precision.hpp"
+#include "ir_features.hpp"
+#include "pass_stats.hpp"
+
+cl::opt<string> IRFeaturesOut(
+    "ir-features-out", cl::init(""), cl::desc("Write static IR features of the lowered module to this file"));
+
+static string precisionName(Type *type) {
+    type = type->getScalarType();
+    if (type->isHalfTy()) return "half";
+    if (type->isBFloatTy()) return "bfloat";
+    if (type->isFloatTy()) return "float";
+    if (type->isDoubleTy()) return "double";
+    if (type->isFloatingPointTy()) return "other";
+    return "int";
+}
+
+// 浮点运算的操作名；不是浮点运算时返回空串。llvm.fmuladd.f32 之类取中间一段
+static string fpOpName(Instruction &inst) {
+    if (isa<FCmpInst>(inst)) return "fcmp";
+    if (!inst.getType()->isFPOrFPVectorTy()) return "";
+    if (isa<BinaryOperator>(inst) || isa<UnaryOperator>(inst)) return inst.getOpcodeName();
+    if (auto *call = dyn_cast<CallInst>(&inst)) {
+        Function *callee = call->getCalledFunction();
+        if (!callee) return "call";
+        StringRef name = callee->getName();
+        if (name.consume_front("llvm.")) return name.split('.').first.str();
+        return "call";
+    }
+    return "";
+}
+
+bool IRFeaturesPass::isSimpleInnermost(Loop *loop) {
+    if (!loop || !loop->getSubLoops().empty()) return false;
+    if (!loop->getLoopLatch() || !loop->getExitingBlock()) return false;
+    for (BasicBlock *BB : loop->blocks()) {
+        for (auto &inst : *BB) {
+            if (auto *call = dyn_cast<CallInst>(&inst); call && !isa<IntrinsicInst>(call)) return false;
+        }
+    }
+    return true;
+}
+
+// 沿 def-use 链从降精变量的 load 出发，看值是否流到比较、select 条件或分支
+void IRFeaturesPass::traceLowered(AllocaInst *alloca, Features &features) {
+    features["lowered.vars"] += 1;
+
+    vector<Value *> worklist;
+    for (User *user : alloca->users()) {
+        if (isa<LoadInst>(user)) worklist.push_back(user);
+    }
+    set<Value *> visited;
+    bool reachCmp = false, reachBranch = false;
+    while (!worklist.empty() && !(reachCmp && reachBranch)) {
+        Value *value = worklist.back();
+        worklist.pop_back();
+        if (!visited.insert(value).second) continue;
+        for (User *user : value->users()) {
+            if (isa<CmpInst>(user)) reachCmp = true;
+            if (isa<BranchInst>(user) || isa<SwitchInst>(user)) reachBranch = true;
+            if (auto *select = dyn_cast<SelectInst>(user); select && select->getCondition() == value) {
+                reachBranch = true;
+            }
+            // store 与调用之后不再追踪
+            if (isa<Instruction>(user) && !isa<StoreInst>(user) && !isa<CallBase>(user)) {
+                worklist.push_back(user);
+            }
+        }
+    }
+    if (reachCmp) features["lowered.reach_cmp"] += 1;
+    if (reachBranch) features["lowered.reach_branch"] += 1;
+}
+
+void IRFeaturesPass::visitFunction(Function &F, Features &features) {
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+    BranchProbabilityInfo BPI(F, LI);
+    BlockFrequencyInfo BFI(F, BPI, LI);
+    double entryFreq = BFI.getEntryFreq() ? (double)BFI.getEntryFreq() : 1.0;
+
+    map<Loop *, bool> simpleLoops;
+    for (Loop *loop : LI.getLoopsInPreorder()) simpleLoops[loop] = isSimpleInnermost(loop);
+
+    for (auto &BB : F) {
+        double freq = BFI.getBlockFreq(&BB).getFrequency() / entryFreq;
+        unsigned depth = LI.getLoopDepth(&BB);
+        double depthWeight = std::pow(10.0, depth);
+        Loop *loop = LI.getLoopFor(&BB);
+        string placement = depth ? "loop" : "outside";
+
+        for (auto &inst : BB) {
+            features["module.instructions"] += 1;
+
+            if (auto *cast = dyn_cast<CastInst>(&inst)) {
+                Type *src = cast->getSrcTy(), *dst = cast->getDestTy();
+                if (src->isFPOrFPVectorTy() || dst->isFPOrFPVectorTy()) {
+                    string op = cast->getOpcodeName();
+                    features["cvt." + op + "." + precisionName(src) + "." + precisionName(dst)] += 1;
+                    features["cvt." + op + "." + placement] += 1;
+                    features["cvt." + op + "." + placement + ".freq"] += freq;
+                    features["cvt.total"] += 1;
+                    features["cvt.total.freq"] += freq;
+                    continue;
+                }
+            }
+
+            Type *accessType = nullptr;
+            string access;
+            if (auto *load = dyn_cast<LoadInst>(&inst)) {
+                accessType = load->getType();
+                access = "load";
+            } else if (auto *store = dyn_cast<StoreInst>(&inst)) {
+                accessType = store->getValueOperand()->getType();
+                access = "store";
+            }
+            if (accessType && accessType->isFPOrFPVectorTy()) {
+                double bytes = F.getParent()->getDataLayout().getTypeStoreSize(accessType).getFixedValue();
+                string key = "mem." + access + "." + precisionName(accessType) + ".bytes";
+                features[key] += bytes;
+                features[key + ".freq"] += bytes * freq;
+                continue;
+            }
+
+            string op = fpOpName(inst);
+            if (op.empty()) continue;
+            Type *type = isa<FCmpInst>(inst) ? inst.getOperand(0)->getType() : inst.getType();
+            string key = "fp." + precisionName(type) + "." + op;
+            features[key] += 1;
+            features[key + ".freq"] += freq;
+            features[key + ".depth"] += depthWeight;
+            features["fp." + precisionName(type) + ".total.freq"] += freq;
+
+            features["vector.fp_ops.freq"] += freq;
+            if (type->isVectorTy() || (loop && simpleLoops[loop])) features["vector.vectorizable.freq"] += freq;
+        }
+    }
+
+    for (auto &inst : instructions(F)) {
+        if (auto *alloca = dyn_cast<AllocaInst>(&inst); alloca && alloca->getMetadata(LoweredVarMD)) {
+            traceLowered(alloca, features);
+        }
+    }
+}
+
+map<string, double> IRFeaturesPass::extract(Module &M) {
+    Features features;
+    for (auto &F : M) {
+        if (F.isDeclaration()) continue;
+        features["module.functions"] += 1;
+        visitFunction(F, features);
+    }
+
+    double total = features["vector.fp_ops.freq"];
+    features["vector.fraction"] = total > 0 ? features["vector.vectorizable.freq"] / total : 0;
+    features["lowered.vars"] += 0;
+    features["lowered.reach_cmp"] += 0;
+    features["lowered.reach_branch"] += 0;
+    return features;
+}
+
+PreservedAnalyses IRFeaturesPass::run(Module &M, ModuleAnalysisManager &) {
+    Features features = extract(M);
+    string path = IRFeaturesOut.empty() ? "ir_features.json" : IRFeaturesOut.getValue();
+    std::ofstream out(path);
+    if (!out) {
+        errs() << "\033[31m[IRFeatures] cannot write " << path << "\033[0m\n";
+        return PreservedAnalyses::all();
+    }
+    out << nlohmann::json(features).dump() << "\n";
+    if (!AmpQuiet) {
+        errs() << "\033[32m[IRFeatures] " << features.size() << " feature(s) written to " << path << "\033[0m\n";
+    }
+    return PreservedAnalyses::all();
+}
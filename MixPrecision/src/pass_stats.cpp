@@ -0,0 +1,67 @@
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+
+#include "pass_stats.hpp"
+
+cl::opt<bool> AmpQuiet("amp-quiet", cl::desc("Do not log every changed variable and processed function"));
+cl::opt<string> AmpStatsOut("amp-stats-out", cl::desc("Write pass counters and phase timings as JSON"),
+                            cl::init(""));
+
+namespace {
+struct PhaseTotal {
+    double seconds = 0;
+    uint64_t count = 0;
+};
+
+bool collectPhases = false;
+StringMap<PhaseTotal> phases;
+}  // namespace
+
+PhaseTimer::PhaseTimer(const char *group, const char *name)
+    : trace(group, name ? name : ""), group(group), name(name) {
+    if (collectPhases) start = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!collectPhases) return;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    PhaseTotal &total = phases[name ? (Twine(group) + "." + name).str() : group];
+    total.seconds += elapsed.count();
+    total.count++;
+}
+
+void beginPassStats() {
+    if (!AmpStatsOut.empty()) {
+        // 计数器在第一次累加时才登记，必须在任何 pass 计数之前打开
+        EnableStatistics(/*DoPrintOnExit=*/false);
+        collectPhases = true;
+        phases.clear();
+    }
+}
+
+void endPassStats() {
+    if (!collectPhases) return;
+    collectPhases = false;
+
+    string statistics;
+    raw_string_ostream stream(statistics);
+    PrintStatisticsJSON(stream);
+    stream.flush();
+
+    nlohmann::json summary = {{"statistics", nlohmann::json::parse(statistics, nullptr, false)},
+                              {"phases", nlohmann::json::object()}};
+    for (auto &entry : phases) {
+        summary["phases"][entry.getKey().str()] = {{"seconds", entry.getValue().seconds},
+                                                   {"count", entry.getValue().count}};
+    }
+
+    std::ofstream out(AmpStatsOut.getValue());
+    if (!out) {
+        errs() << "\033[31m[PassStats] cannot write " << AmpStatsOut << "\033[0m\n";
+        return;
+    }
+    out << summary.dump(2) << "\n";
+}
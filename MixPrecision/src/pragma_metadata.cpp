@@ -0,0 +1,202 @@
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "pass_stats.hpp"
+#include "pragma_metadata.hpp"
+
+// 解析 "<line>:<col>"
+static bool parseLineCol(StringRef text, unsigned &line, unsigned &col) {
+    auto [lineStr, colStr] = text.split(':');
+    return !lineStr.getAsInteger(10, line) && !colStr.getAsInteger(10, col);
+}
+
+bool PragmaRegion::contains(unsigned line, unsigned col) const {
+    if (line < beginLine || line > endLine) return false;
+    if (line == beginLine && col < beginCol) return false;
+    if (line == endLine && col > endCol) return false;
+    return true;
+}
+
+// automxprec.region;id=<file>:<line>;begin=<line>:<col>;end=<line>:<col>[;precision=<ty>;mode=<full|storage>]
+bool PragmaRegion::parse(StringRef annotation, PragmaRegion &region) {
+    SmallVector<StringRef, 8> fields;
+    annotation.split(fields, ';');
+    if (fields.empty() || fields[0] != PragmaRegionAnnotation) return false;
+
+    for (StringRef field : fields) {
+        auto [key, value] = field.split('=');
+        if (key == "id") {
+            region.id = value.str();
+        } else if (key == "begin") {
+            if (!parseLineCol(value, region.beginLine, region.beginCol)) return false;
+        } else if (key == "end") {
+            if (!parseLineCol(value, region.endLine, region.endCol)) return false;
+        } else if (key == "precision") {
+            region.precision = value.str();
+        } else if (key == "mode") {
+            region.storageOnly = value == "storage";
+        }
+    }
+    return region.beginLine > 0 && region.endLine >= region.beginLine;
+}
+
+bool getPragmaPrecision(const Instruction &inst, PragmaPrecision &result) {
+    MDNode *node = inst.getMetadata(PragmaPrecisionMD);
+    if (!node || node->getNumOperands() != 3) return false;
+
+    auto getString = [&](unsigned i) -> string {
+        auto *str = dyn_cast<MDString>(node->getOperand(i));
+        return str ? str->getString().str() : "";
+    };
+    result.id = getString(0);
+    result.type = getString(1);
+    result.storageOnly = getString(2) == "storage";
+    return !result.type.empty();
+}
+
+// llvm.global.annotations 中的 (被注解的全局值, 注解字符串)
+static vector<pair<Value *, StringRef>> getGlobalAnnotations(Module &M) {
+    vector<pair<Value *, StringRef>> result;
+    GlobalVariable *annotations = M.getGlobalVariable("llvm.global.annotations");
+    if (!annotations || !annotations->hasInitializer()) return result;
+
+    auto *array = dyn_cast<ConstantArray>(annotations->getInitializer());
+    if (!array) return result;
+
+    for (Value *op : array->operands()) {
+        auto *entry = dyn_cast<ConstantStruct>(op);
+        if (!entry || entry->getNumOperands() < 2) continue;
+
+        StringRef annotation;
+        if (!getConstantStringInfo(entry->getOperand(1), annotation)) continue;
+        result.push_back({entry->getOperand(0)->stripPointerCasts(), annotation});
+    }
+    return result;
+}
+
+map<Function *, vector<PragmaRegion>> PragmaMetadataPass::collectRegions(Module &M) {
+    map<Function *, vector<PragmaRegion>> regions;
+    for (auto &[target, annotation] : getGlobalAnnotations(M)) {
+        auto *function = dyn_cast<Function>(target);
+        PragmaRegion region;
+        if (function && PragmaRegion::parse(annotation, region)) {
+            regions[function].push_back(region);
+        }
+    }
+    return regions;
+}
+
+bool PragmaMetadataPass::annotateFunction(Function &F, const vector<PragmaRegion> &regions) {
+    LLVMContext &context = F.getContext();
+    bool changed = false;
+
+    // 嵌套区域取带 precision 子句的最内层，即起始位置最靠后的那个；col 为 0 时只比较行号
+    auto findRegion = [&](unsigned line, unsigned col) -> const PragmaRegion * {
+        const PragmaRegion *found = nullptr;
+        for (const auto &region : regions) {
+            if (region.precision.empty()) continue;
+            bool inside = col ? region.contains(line, col)
+                              : line >= region.beginLine && line <= region.endLine;
+            if (!inside) continue;
+            if (!found || region.beginLine > found->beginLine ||
+                (region.beginLine == found->beginLine && region.beginCol > found->beginCol)) {
+                found = &region;
+            }
+        }
+        return found;
+    };
+
+    auto tag = [&](Instruction &inst, const PragmaRegion &region) {
+        inst.setMetadata(PragmaPrecisionMD,
+                         MDNode::get(context, {MDString::get(context, region.id),
+                                               MDString::get(context, region.precision),
+                                               MDString::get(context, region.storageOnly ? "storage" : "full")}));
+        changed = true;
+    };
+
+    for (auto &BB : F) {
+        for (auto &inst : BB) {
+            // alloca 本身没有调试位置，按 dbg.declare 中变量的声明行判断
+            if (auto *declare = dyn_cast<DbgDeclareInst>(&inst)) {
+                auto *alloca = dyn_cast_or_null<AllocaInst>(declare->getAddress());
+                DILocalVariable *var = declare->getVariable();
+                if (!alloca || !var || var->getLine() == 0) continue;
+                if (const PragmaRegion *region = findRegion(var->getLine(), 0)) {
+                    tag(*alloca, *region);
+                }
+                continue;
+            }
+
+            if (!isa<LoadInst>(inst) && !isa<StoreInst>(inst) && !isa<CallInst>(inst)) continue;
+            if (isa<DbgInfoIntrinsic>(inst)) continue;
+
+            const DILocation *loc = inst.getDebugLoc();
+            if (!loc) continue;
+            if (const PragmaRegion *region = findRegion(loc->getLine(), loc->getColumn())) {
+                tag(inst, *region);
+            }
+        }
+    }
+    return changed;
+}
+
+bool PragmaMetadataPass::annotateKeeps(Module &M) {
+    bool changed = false;
+    for (auto &[target, annotation] : getGlobalAnnotations(M)) {
+        // 静态局部变量的注解直接挂在变量上，文件作用域的全局变量挂在引用它的函数上：automxprec.keep;global=<名字>
+        GlobalVariable *global = nullptr;
+        if (annotation == PragmaKeepAnnotation) {
+            global = dyn_cast<GlobalVariable>(target);
+        } else if (auto [prefix, name] = annotation.split(";global="); prefix == PragmaKeepAnnotation) {
+            global = M.getGlobalVariable(name, /*AllowInternal=*/true);
+        }
+        if (global && !global->getMetadata(PragmaKeepMD)) {
+            global->setMetadata(PragmaKeepMD, MDNode::get(M.getContext(), {}));
+            changed = true;
+        }
+    }
+
+    vector<Instruction *> consumed;
+    for (auto &F : M) {
+        for (auto &BB : F) {
+            for (auto &inst : BB) {
+                auto *intrinsic = dyn_cast<IntrinsicInst>(&inst);
+                if (!intrinsic || intrinsic->getIntrinsicID() != Intrinsic::var_annotation) continue;
+
+                StringRef annotation;
+                if (!getConstantStringInfo(intrinsic->getArgOperand(1), annotation) ||
+                    annotation != PragmaKeepAnnotation) {
+                    continue;
+                }
+                if (auto *alloca = dyn_cast<AllocaInst>(intrinsic->getArgOperand(0)->stripPointerCasts())) {
+                    alloca->setMetadata(PragmaKeepMD, MDNode::get(M.getContext(), {}));
+                }
+                consumed.push_back(intrinsic);
+            }
+        }
+    }
+
+    // 注解调用已经转成元数据，删掉以免干扰后续对 alloca 使用者的分析
+    for (Instruction *inst : consumed) {
+        Value *address = inst->getOperand(0);
+        inst->eraseFromParent();
+        if (auto *cast = dyn_cast<Instruction>(address)) {
+            if (cast->use_empty() && !isa<AllocaInst>(cast)) cast->eraseFromParent();
+        }
+    }
+    return changed || !consumed.empty();
+}
+
+PreservedAnalyses PragmaMetadataPass::run(Module &M, ModuleAnalysisManager &) {
+    bool changed = annotateKeeps(M);
+
+    for (auto &[function, regions] : collectRegions(M)) {
+        if (!AmpQuiet) errs() << "[PragmaMetadata] " << function->getName() << ": " << regions.size() << " region(s)\n";
+        changed |= annotateFunction(*function, regions);
+    }
+
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -1,3 +1,4 @@
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/IR/Module.h>
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include <llvm/Support/CommandLine.h>
@@ -8,6 +9,18 @@
 
 #include "precision_lowering.hpp"
 #include "change_precision.hpp"
+#include "pragma_metadata.hpp"
+#include "finite_check.hpp"
+#include "ir_features.hpp"
+#include "pass_stats.hpp"
+
+#define DEBUG_TYPE "precision-lowering"
+
+AMP_STATISTIC(NumBinOpsLowered, "Binary operators recomputed in the narrower operand type");
+AMP_STATISTIC(NumSIToFPLowered, "Binary operators with an sitofp operand recomputed in the narrower type");
+AMP_STATISTIC(NumLoweringExtInserted, "fpext casts inserted by precision lowering");
+AMP_STATISTIC(NumLoweringTruncInserted, "fptrunc casts inserted by precision lowering");
+AMP_STATISTIC(NumLoweringCastInserted, "Casts inserted to unify binary operand types");
 
 constexpr unsigned MAX_OPCODE = llvm::Instruction::OtherOpsEnd;
 
@@ -24,11 +37,27 @@ const std::bitset<MAX_OPCODE> OpsBitset = initOpsBitset();
 
 
 llvm::PreservedAnalyses PrecisionLoweringPass::run(llvm::Module &module, llvm::ModuleAnalysisManager &AM){
+    beginPassStats();
+    // 记下源码中原有的 fptrunc，降精之后其余的 fptrunc 都是本 pass 插入的
+    vector<WeakVH> originalTruncs;
+    for (auto &F : module) {
+        for (auto &BB : F) {
+            for (auto &inst : BB) {
+                if (isa<FPTruncInst>(inst)) originalTruncs.push_back(WeakVH(&inst));
+            }
+        }
+    }
+
     ModulePassManager MPM;
-    MPM.addPass(ChangePrecisionPass());
+    if (changes) {
+        MPM.addPass(ChangePrecisionPass(changes));
+    } else {
+        MPM.addPass(PragmaMetadataPass());
+        MPM.addPass(ChangePrecisionPass());
+    }
     MPM.run(module, AM);
 
-    errs() << "Start precision lowering:\n";
+    if (!AmpQuiet) errs() << "Start precision lowering:\n";
     debugInfo.processModule(module);
     
     for (llvm::Function &F : module) {
@@ -38,15 +67,47 @@ llvm::PreservedAnalyses PrecisionLoweringPass::run(llvm::Module &module, llvm::M
         if (F.hasFnAttribute(llvm::Attribute::OptimizeNone))
             F.removeFnAttr(llvm::Attribute::OptimizeNone);
 
+        PhaseTimer timer("PrecisionLowering");
         runOnFunction(F);
     }
 
+    tagLoweredTruncs(module, originalTruncs);
+
+    // 在插入检查之前提取特征，检查代码不计入
+    if (!IRFeaturesOut.empty()) {
+        PhaseTimer timer("IRFeatures");
+        IRFeaturesPass().run(module, AM);
+    }
+
+    if (CheckFinite) {
+        PhaseTimer timer("FiniteCheck");
+        FiniteCheckPass().run(module, AM);
+    }
 
-    errs() << "Precision lowering completed!\n";
+    if (!AmpQuiet) errs() << "Precision lowering completed!\n";
+    endPassStats();
     return PreservedAnalyses::none();
 }
 
 
+void PrecisionLoweringPass::tagLoweredTruncs(Module &module, const vector<WeakVH> &originalTruncs) {
+    // 原有的 fptrunc 被删除后句柄置空，地址复用给新指令也不会被误认为原有
+    SmallPtrSet<Value *, 32> original;
+    for (auto &handle : originalTruncs) {
+        if (handle) original.insert(handle);
+    }
+    LLVMContext &context = module.getContext();
+    for (auto &F : module) {
+        for (auto &BB : F) {
+            for (auto &inst : BB) {
+                if (isa<FPTruncInst>(inst) && !original.count(&inst)) {
+                    inst.setMetadata(LoweredTruncMD, MDNode::get(context, {}));
+                }
+            }
+        }
+    }
+}
+
 bool PrecisionLoweringPass::hasSIToFPInst(BinaryOperator *binOp) {
     Value *op0 = binOp->getOperand(0);
     Value *op1 = binOp->getOperand(1);
@@ -60,7 +121,7 @@ bool PrecisionLoweringPass::hasSIToFPInst(BinaryOperator *binOp) {
 bool PrecisionLoweringPass::runOnFunction(Function &func){
     string funcName = func.getName().str();
     if(!func.isDeclaration()){
-        errs()<<"\tProcessing function:"<<funcName<<"\n";
+        if (!AmpQuiet) errs()<<"\tProcessing function:"<<funcName<<"\n";
         for(auto &bb: func){
             for(auto &inst: bb){
                 if(auto binOpInst = dyn_cast<BinaryOperator>(&inst)){
@@ -73,11 +134,13 @@ bool PrecisionLoweringPass::runOnFunction(Function &func){
 
                             assert(spInst && castInst && "Operands must be SIToFPInst and CastInst");
 
+                            NumSIToFPLowered++;
                             spInst = new SIToFPInst(spInst->getOperand(0), castInst->getOperand(0)->getType(), "", binOpInst);
                             BinaryOperator *newTarget = BinaryOperator::Create(binOpInst->getOpcode(), castInst->getOperand(0), spInst, "", binOpInst);
 
                             if (newTarget->getType()->getTypeID() < binOpInst->getType()->getTypeID()) {
                                 FPExtInst *ext = new FPExtInst(newTarget, binOpInst->getType(), "", binOpInst);
+                                NumLoweringExtInserted++;
                                 binOpInst->replaceAllUsesWith(ext);
                             }
                             else {
@@ -115,16 +178,20 @@ bool PrecisionLoweringPass::runOnFunction(Function &func){
 
                             if (val1->getType()->getTypeID() != val2->getType()->getTypeID()) {
                                 smallerVal = CastInst::CreateFPCast(smallerVal, largerType, "", binOpInst);
+                                NumLoweringCastInserted++;
                             }
+                            NumBinOpsLowered++;
                             
                             BinaryOperator *newTarget = BinaryOperator::Create(binOpInst->getOpcode(), val1, val2, "", binOpInst);
 
                             if (newTarget->getType()->getTypeID() < binOpInst->getType()->getTypeID()) {
                                 FPExtInst *ext = new FPExtInst(newTarget, binOpInst->getType(), "", binOpInst);
+                                NumLoweringExtInserted++;
                                 binOpInst->replaceAllUsesWith(ext);
                             }
                             else if(newTarget->getType()->getTypeID() > binOpInst->getType()->getTypeID()){
                                 FPTruncInst *tru = new FPTruncInst(newTarget, binOpInst->getType(), "", binOpInst);
+                                NumLoweringTruncInserted++;
                                 binOpInst->replaceAllUsesWith(tru);
                             }
                             else{
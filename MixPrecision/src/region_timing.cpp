@@ -0,0 +1,241 @@
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+#include <set>
+
+#include "region_timing.hpp"
+
+static cl::list<string> TimeFunctions(
+    "time-functions", cl::CommaSeparated,
+    cl::desc("Functions timed by region-timing in addition to the pragma regions"));
+
+Value *RegionTimingPass::readCounter(IRBuilder<> &builder, Module &M) {
+    Triple triple(M.getTargetTriple());
+    Type *int64Ty = builder.getInt64Ty();
+
+    // 用户态可读的虚拟计数器；llvm.readcyclecounter 在 aarch64 上读的是 PMCCNTR_EL0，用户态会陷入
+    if (triple.isAArch64()) {
+        InlineAsm *mrs = InlineAsm::get(FunctionType::get(int64Ty, false), "mrs $0, cntvct_el0", "=r",
+                                        /*hasSideEffects=*/true);
+        return builder.CreateCall(mrs);
+    }
+    if (triple.isX86()) {
+        return builder.CreateIntrinsic(Intrinsic::readcyclecounter, {}, {});
+    }
+    return builder.CreateCall(M.getOrInsertFunction(TimingNow, FunctionType::get(int64Ty, false)));
+}
+
+void RegionTimingPass::emitStart(IRBuilder<> &builder, Module &M, AllocaInst *slot) {
+    builder.CreateStore(readCounter(builder, M), slot);
+}
+
+void RegionTimingPass::emitStop(IRBuilder<> &builder, Module &M, AllocaInst *slot, unsigned index) {
+    Type *int64Ty = builder.getInt64Ty();
+    Value *now = readCounter(builder, M);
+    Value *elapsed = builder.CreateSub(now, builder.CreateLoad(int64Ty, slot));
+
+    Value *ticks = builder.CreateConstInBoundsGEP2_32(table->getValueType(), table, 0, index * 2);
+    Value *calls = builder.CreateConstInBoundsGEP2_32(table->getValueType(), table, 0, index * 2 + 1);
+    builder.CreateStore(builder.CreateAdd(builder.CreateLoad(int64Ty, ticks), elapsed), ticks);
+    builder.CreateStore(builder.CreateAdd(builder.CreateLoad(int64Ty, calls), builder.getInt64(1)), calls);
+}
+
+// 取最外层的调用位置，行列号才属于当前函数的源码
+static const DILocation *getSourceLoc(const Instruction &inst) {
+    const DILocation *loc = inst.getDebugLoc();
+    while (loc && loc->getInlinedAt()) loc = loc->getInlinedAt();
+    return loc && loc->getLine() ? loc : nullptr;
+}
+
+// 插桩位置：源块只有一个后继时放在其末尾，目标块只有一个前驱时放在其开头，否则拆边
+static Instruction *getEdgeInsertPoint(BasicBlock *from, BasicBlock *to) {
+    if (from->getSingleSuccessor() == to) return from->getTerminator();
+    if (to->getSinglePredecessor() == from) return &*to->getFirstInsertionPt();
+    return SplitEdge(from, to)->getTerminator();
+}
+
+bool RegionTimingPass::instrumentRegion(Function &F, const PragmaRegion &region, unsigned index) {
+    // 1. 把跨越区域边界的基本块拆开，使每个块要么完全在区域内，要么完全在区域外。
+    //    没有调试位置的指令跟随前面最近的有位置指令，块首的则跟随块内第一条有位置指令
+    vector<BasicBlock *> blocks;
+    for (auto &BB : F) blocks.push_back(&BB);
+
+    set<BasicBlock *> inside;
+    for (BasicBlock *BB : blocks) {
+        vector<pair<Instruction *, int>> states;
+        int first = -1;
+        for (auto &inst : *BB) {
+            int state = -1;
+            if (const DILocation *loc = getSourceLoc(inst)) {
+                state = region.contains(loc->getLine(), loc->getColumn());
+                if (first < 0) first = state;
+            }
+            states.push_back({&inst, state});
+        }
+        if (first < 0) continue;
+
+        int current = first;
+        BasicBlock *block = BB;
+        vector<Instruction *> splits;
+        for (auto &[inst, state] : states) {
+            if (state < 0 || state == current) continue;
+            // PHI 与 alloca 之前不能拆，推迟到第一条可以拆的指令
+            if (isa<PHINode>(inst) || isa<AllocaInst>(inst)) continue;
+            splits.push_back(inst);
+            current = state;
+        }
+
+        bool in = first;
+        for (Instruction *inst : splits) {
+            if (in) inside.insert(block);
+            block = block->splitBasicBlock(inst, block->getName() + ".timing");
+            in = !in;
+        }
+        if (in) inside.insert(block);
+    }
+    if (inside.empty()) return false;
+
+    // 2. 计时起点放在函数入口的 alloca 中，在所有进入区域的边上写入，离开区域的边上累加
+    IRBuilder<> entryBuilder(&*F.getEntryBlock().getFirstInsertionPt());
+    AllocaInst *slot = entryBuilder.CreateAlloca(entryBuilder.getInt64Ty(), nullptr, "amp.timing.start");
+
+    vector<pair<BasicBlock *, BasicBlock *>> entries, exits;
+    vector<Instruction *> returns;
+    for (BasicBlock *BB : inside) {
+        if (BB == &F.getEntryBlock()) entries.push_back({nullptr, BB});
+        for (BasicBlock *pred : predecessors(BB)) {
+            if (!inside.count(pred)) entries.push_back({pred, BB});
+        }
+        for (BasicBlock *succ : successors(BB)) {
+            if (!inside.count(succ)) exits.push_back({BB, succ});
+        }
+        if (isa<ReturnInst>(BB->getTerminator())) returns.push_back(BB->getTerminator());
+    }
+
+    Module &M = *F.getParent();
+    for (auto [from, to] : entries) {
+        Instruction *point = from ? getEdgeInsertPoint(from, to) : slot->getNextNode();
+        if (!from) {
+            while (isa<AllocaInst>(point)) point = point->getNextNode();
+        }
+        IRBuilder<> builder(point);
+        emitStart(builder, M, slot);
+    }
+    for (auto [from, to] : exits) {
+        IRBuilder<> builder(getEdgeInsertPoint(from, to));
+        emitStop(builder, M, slot, index);
+    }
+    for (Instruction *ret : returns) {
+        IRBuilder<> builder(ret);
+        emitStop(builder, M, slot, index);
+    }
+    return true;
+}
+
+void RegionTimingPass::instrumentFunction(Function &F, unsigned index) {
+    Module &M = *F.getParent();
+    IRBuilder<> builder(&*F.getEntryBlock().getFirstInsertionPt());
+    AllocaInst *slot = builder.CreateAlloca(builder.getInt64Ty(), nullptr, "amp.timing.start");
+
+    Instruction *point = slot->getNextNode();
+    while (isa<AllocaInst>(point)) point = point->getNextNode();
+    builder.SetInsertPoint(point);
+    emitStart(builder, M, slot);
+
+    for (auto &BB : F) {
+        if (auto *ret = dyn_cast<ReturnInst>(BB.getTerminator())) {
+            builder.SetInsertPoint(ret);
+            emitStop(builder, M, slot, index);
+        }
+    }
+}
+
+// 生成名字表并在全局构造函数中向运行时登记
+void RegionTimingPass::registerTable(Module &M) {
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+
+    vector<Constant *> ids, kinds;
+    for (auto &timer : timers) {
+        ids.push_back(ConstantExpr::getPointerCast(
+            new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(context), timer.id.size() + 1), true,
+                               GlobalValue::PrivateLinkage, ConstantDataArray::getString(context, timer.id),
+                               "amp.timing.id"),
+            ptrTy));
+        kinds.push_back(ConstantExpr::getPointerCast(
+            new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(context), timer.kind.size() + 1), true,
+                               GlobalValue::PrivateLinkage, ConstantDataArray::getString(context, timer.kind),
+                               "amp.timing.kind"),
+            ptrTy));
+    }
+    auto *namesTy = ArrayType::get(ptrTy, timers.size());
+    auto *idTable = new GlobalVariable(M, namesTy, true, GlobalValue::PrivateLinkage,
+                                       ConstantArray::get(namesTy, ids), "amp.timing.ids");
+    auto *kindTable = new GlobalVariable(M, namesTy, true, GlobalValue::PrivateLinkage,
+                                         ConstantArray::get(namesTy, kinds), "amp.timing.kinds");
+
+    Type *int32Ty = Type::getInt32Ty(context);
+    FunctionCallee registerFn = M.getOrInsertFunction(
+        TimingRegister, FunctionType::get(Type::getVoidTy(context), {ptrTy, ptrTy, ptrTy, int32Ty}, false));
+
+    Function *ctor = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+                                      GlobalValue::InternalLinkage, "amp.timing.init", M);
+    IRBuilder<> builder(BasicBlock::Create(context, "entry", ctor));
+    builder.CreateCall(registerFn, {table, idTable, kindTable, builder.getInt32(timers.size())});
+    builder.CreateRetVoid();
+    appendToGlobalCtors(M, ctor, 0);
+}
+
+PreservedAnalyses RegionTimingPass::run(Module &M, ModuleAnalysisManager &) {
+    timers.clear();
+
+    // 先确定计时项，表的大小决定了插桩时的地址计算
+    vector<pair<Function *, PragmaRegion>> regions;
+    for (auto &[function, list] : PragmaMetadataPass::collectRegions(M)) {
+        for (auto &region : list) {
+            regions.push_back({function, region});
+            timers.push_back({region.id, "region"});
+        }
+    }
+
+    vector<Function *> functions;
+    for (const string &name : TimeFunctions) {
+        Function *F = M.getFunction(name);
+        if (!F || F->isDeclaration()) {
+            errs() << "\033[31m[RegionTiming] function " << name << " not found\033[0m\n";
+            continue;
+        }
+        functions.push_back(F);
+        timers.push_back({name, "function"});
+    }
+
+    if (timers.empty()) {
+        errs() << "[RegionTiming] nothing to time\n";
+        return PreservedAnalyses::all();
+    }
+
+    // 每项两个 i64：累计计数器差值、进入次数
+    Type *tableTy = ArrayType::get(Type::getInt64Ty(M.getContext()), timers.size() * 2);
+    table = new GlobalVariable(M, tableTy, false, GlobalValue::InternalLinkage,
+                               Constant::getNullValue(tableTy), "amp.timing.table");
+
+    unsigned index = 0;
+    for (auto &[function, region] : regions) {
+        if (!instrumentRegion(*function, region, index)) {
+            errs() << "\033[31m[RegionTiming] region " << region.id << " has no debug locations\033[0m\n";
+        }
+        index++;
+    }
+    for (Function *F : functions) {
+        instrumentFunction(*F, index++);
+    }
+
+    registerTable(M);
+    errs() << "\033[32m[RegionTiming] " << timers.size() << " timer(s) inserted\033[0m\n";
+    return PreservedAnalyses::none();
+}
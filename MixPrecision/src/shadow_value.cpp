@@ -0,0 +1,224 @@
+#include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+#include "change_precision.hpp"
+#include "shadow_value.hpp"
+
+// 只给标量 half/bfloat/float/double 配影子，更宽的类型与向量保持原样
+bool ShadowValuePass::isShadowed(Type *type) {
+    return type->isHalfTy() || type->isBFloatTy() || type->isFloatTy() || type->isDoubleTy();
+}
+
+Value *ShadowValuePass::toDouble(IRBuilder<> &builder, Value *value) {
+    Type *doubleTy = builder.getDoubleTy();
+    return value->getType() == doubleTy ? value : builder.CreateFPExt(value, doubleTy);
+}
+
+// 没有影子的值（参数、普通调用的返回值等）在使用处扩展成 double 作为影子
+Value *ShadowValuePass::getShadow(Value *value, Instruction *before, ShadowMap &shadows) {
+    auto it = shadows.find(value);
+    if (it != shadows.end()) return it->second;
+
+    LLVMContext &context = value->getContext();
+    if (auto *constant = dyn_cast<ConstantFP>(value)) {
+        APFloat widened = constant->getValueAPF();
+        bool losesInfo;
+        widened.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven, &losesInfo);
+        return ConstantFP::get(context, widened);
+    }
+    if (isa<UndefValue>(value)) return UndefValue::get(Type::getDoubleTy(context));
+
+    IRBuilder<> builder(before);
+    return toDouble(builder, value);
+}
+
+// 浮点参数换成影子后在 double 上调用同一个数学内建函数
+Value *ShadowValuePass::shadowIntrinsic(CallInst *call, Instruction *after, ShadowMap &shadows) {
+    auto *intrinsic = dyn_cast<IntrinsicInst>(call);
+    if (!intrinsic) return nullptr;
+    switch (intrinsic->getIntrinsicID()) {
+        case Intrinsic::sqrt: case Intrinsic::fabs: case Intrinsic::fma: case Intrinsic::fmuladd:
+        case Intrinsic::sin: case Intrinsic::cos: case Intrinsic::exp: case Intrinsic::exp2:
+        case Intrinsic::log: case Intrinsic::log2: case Intrinsic::log10: case Intrinsic::pow:
+        case Intrinsic::floor: case Intrinsic::ceil: case Intrinsic::trunc: case Intrinsic::rint:
+        case Intrinsic::nearbyint: case Intrinsic::round: case Intrinsic::minnum: case Intrinsic::maxnum:
+        case Intrinsic::copysign:
+            break;
+        default:
+            return nullptr;
+    }
+
+    IRBuilder<> builder(after);
+    vector<Value *> args;
+    for (Value *arg : intrinsic->args()) {
+        args.push_back(arg->getType() == call->getType() ? getShadow(arg, after, shadows) : arg);
+    }
+    Function *wide = Intrinsic::getDeclaration(call->getModule(), intrinsic->getIntrinsicID(),
+                                               {builder.getDoubleTy()});
+    return builder.CreateCall(wide, args, call->getName() + ".shadow");
+}
+
+// 写入的地址属于降精变量时返回变量编号：变量本身（标量、数组）或降精指针变量指向的内存
+int ShadowValuePass::findVariable(Value *pointer) {
+    Value *object = getUnderlyingObject(pointer);
+    if (auto *load = dyn_cast<LoadInst>(object)) {
+        object = getUnderlyingObject(load->getPointerOperand());
+    }
+    auto *alloca = dyn_cast<AllocaInst>(object);
+    MDNode *node = alloca ? alloca->getMetadata(LoweredVarMD) : nullptr;
+    if (!node) return -1;
+
+    string id = cast<MDString>(node->getOperand(0))->getString().str();
+    auto [it, inserted] = variableIndex.insert({id, variables.size()});
+    if (inserted) variables.push_back(id);
+    return it->second;
+}
+
+void ShadowValuePass::instrumentStore(StoreInst *store, ShadowMap &shadows) {
+    Value *value = store->getValueOperand();
+    Value *shadow = getShadow(value, store, shadows);
+    IRBuilder<> builder(store);
+    // 同时记下程序值，读出时据此判断内存是否被未插桩的代码改写过
+    builder.CreateCall(storeFn, {store->getPointerOperand(), shadow, toDouble(builder, value)});
+
+    int variable = findVariable(store->getPointerOperand());
+    if (variable < 0) return;
+    // ULP 以写入值的类型（即降精后的类型）计
+    int bits = APFloat::semanticsPrecision(value->getType()->getFltSemantics()) - 1;
+    Value *id = builder.CreateAdd(builder.CreateLoad(builder.getInt32Ty(), base), builder.getInt32(variable));
+    builder.CreateCall(checkFn, {id, toDouble(builder, value), shadow, builder.getInt32(bits)});
+}
+
+bool ShadowValuePass::instrumentFunction(Function &F) {
+    ShadowMap shadows;
+    Type *doubleTy = Type::getDoubleTy(F.getContext());
+
+    // 先为浮点 phi 建好影子 phi，回边上的值最后再填
+    vector<pair<PHINode *, PHINode *>> phis;
+    for (auto &BB : F) {
+        for (PHINode &phi : BB.phis()) {
+            if (isShadowed(phi.getType())) phis.push_back({&phi, nullptr});
+        }
+    }
+    for (auto &[phi, shadow] : phis) {
+        shadow = PHINode::Create(doubleTy, phi->getNumIncomingValues(), phi->getName() + ".shadow",
+                                 phi->getParent()->getFirstNonPHI());
+        shadows[phi] = shadow;
+    }
+
+    vector<StoreInst *> stores;
+    ReversePostOrderTraversal<Function *> rpo(&F);
+    for (BasicBlock *BB : rpo) {
+        vector<Instruction *> insts;
+        for (auto &inst : *BB) {
+            if (!isa<PHINode>(inst) && !inst.isTerminator()) insts.push_back(&inst);
+        }
+
+        for (Instruction *inst : insts) {
+            if (auto *store = dyn_cast<StoreInst>(inst)) {
+                if (isShadowed(store->getValueOperand()->getType())) stores.push_back(store);
+                continue;
+            }
+            if (!isShadowed(inst->getType())) continue;
+
+            Instruction *after = inst->getNextNode();
+            IRBuilder<> builder(after);
+            Value *shadow = nullptr;
+            if (auto *binary = dyn_cast<BinaryOperator>(inst)) {
+                shadow = builder.CreateBinOp(binary->getOpcode(), getShadow(binary->getOperand(0), after, shadows),
+                                             getShadow(binary->getOperand(1), after, shadows));
+            } else if (inst->getOpcode() == Instruction::FNeg) {
+                shadow = builder.CreateFNeg(getShadow(inst->getOperand(0), after, shadows));
+            } else if (isa<FPTruncInst>(inst) || isa<FPExtInst>(inst)) {
+                // 截断前的值就是截断结果的影子
+                shadow = getShadow(inst->getOperand(0), after, shadows);
+            } else if (isa<SIToFPInst>(inst)) {
+                shadow = builder.CreateSIToFP(inst->getOperand(0), doubleTy);
+            } else if (isa<UIToFPInst>(inst)) {
+                shadow = builder.CreateUIToFP(inst->getOperand(0), doubleTy);
+            } else if (auto *select = dyn_cast<SelectInst>(inst)) {
+                shadow = builder.CreateSelect(select->getCondition(),
+                                              getShadow(select->getTrueValue(), after, shadows),
+                                              getShadow(select->getFalseValue(), after, shadows));
+            } else if (auto *load = dyn_cast<LoadInst>(inst)) {
+                shadow = builder.CreateCall(loadFn, {load->getPointerOperand(), toDouble(builder, load)});
+            } else if (auto *call = dyn_cast<CallInst>(inst)) {
+                shadow = shadowIntrinsic(call, after, shadows);
+            }
+            if (shadow) {
+                if (auto *shadowInst = dyn_cast<Instruction>(shadow); shadowInst && !shadowInst->hasName()) {
+                    shadowInst->setName(inst->getName() + ".shadow");
+                }
+                shadows[inst] = shadow;
+            }
+        }
+    }
+
+    for (auto &[phi, shadow] : phis) {
+        for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+            BasicBlock *incoming = phi->getIncomingBlock(i);
+            shadow->addIncoming(getShadow(phi->getIncomingValue(i), incoming->getTerminator(), shadows), incoming);
+        }
+    }
+    for (StoreInst *store : stores) instrumentStore(store, shadows);
+    return !phis.empty() || !stores.empty() || !shadows.empty();
+}
+
+// 变量名表在全局构造函数中登记，运行时返回本模块变量编号的起点
+void ShadowValuePass::registerVariables(Module &M) {
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+
+    vector<Constant *> names;
+    for (const string &id : variables) {
+        names.push_back(ConstantExpr::getPointerCast(
+            new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(context), id.size() + 1), true,
+                               GlobalValue::PrivateLinkage, ConstantDataArray::getString(context, id),
+                               "amp.shadow.id"),
+            ptrTy));
+    }
+    auto *namesTy = ArrayType::get(ptrTy, names.size());
+    auto *nameTable = new GlobalVariable(M, namesTy, true, GlobalValue::PrivateLinkage,
+                                         ConstantArray::get(namesTy, names), "amp.shadow.ids");
+
+    Type *int32Ty = Type::getInt32Ty(context);
+    FunctionCallee registerFn =
+        M.getOrInsertFunction(ShadowRegister, FunctionType::get(int32Ty, {ptrTy, int32Ty}, false));
+    Function *ctor = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+                                      GlobalValue::InternalLinkage, "amp.shadow.init", M);
+    IRBuilder<> builder(BasicBlock::Create(context, "entry", ctor));
+    builder.CreateStore(builder.CreateCall(registerFn, {nameTable, builder.getInt32(names.size())}), base);
+    builder.CreateRetVoid();
+    appendToGlobalCtors(M, ctor, 0);
+}
+
+PreservedAnalyses ShadowValuePass::run(Module &M, ModuleAnalysisManager &) {
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+    Type *doubleTy = Type::getDoubleTy(context);
+    Type *int32Ty = Type::getInt32Ty(context);
+    Type *voidTy = Type::getVoidTy(context);
+    loadFn = M.getOrInsertFunction(ShadowLoad, FunctionType::get(doubleTy, {ptrTy, doubleTy}, false));
+    storeFn = M.getOrInsertFunction(ShadowStore, FunctionType::get(voidTy, {ptrTy, doubleTy, doubleTy}, false));
+    checkFn = M.getOrInsertFunction(ShadowCheck,
+                                    FunctionType::get(voidTy, {int32Ty, doubleTy, doubleTy, int32Ty}, false));
+    base = new GlobalVariable(M, int32Ty, false, GlobalValue::PrivateLinkage, ConstantInt::get(int32Ty, 0),
+                              "amp.shadow.base");
+
+    variableIndex.clear();
+    variables.clear();
+    unsigned instrumented = 0;
+    for (auto &F : M) {
+        if (F.isDeclaration() || F.getName().startswith("__amp_")) continue;
+        if (instrumentFunction(F)) instrumented++;
+    }
+    registerVariables(M);
+
+    errs() << "\033[32m[ShadowValue] " << instrumented << " function(s), " << variables.size()
+           << " lowered variable(s) checked\033[0m\n";
+    return PreservedAnalyses::none();
+}
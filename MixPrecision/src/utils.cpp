@@ -1,5 +1,15 @@
 #include "../include/utils.hpp"
 #include "precision_lowering.hpp"
+#include "pragma_metadata.hpp"
+#include "fork_server.hpp"
+#include "fat_config.hpp"
+#include "region_timing.hpp"
+#include "finite_check.hpp"
+#include "watchdog.hpp"
+#include "canonical_hash.hpp"
+#include "ir_features.hpp"
+#include "shadow_value.hpp"
+#include "call_record.hpp"
 #include "../include/ParseConfig.hpp"
 #include "../include/CreateConfigFile.hpp"
 #include "llvm/IR/Argument.h"
@@ -175,6 +185,57 @@ extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo llvmGetPassPluginIn
             return true;
           }
  
+          if (Name == "pragma-metadata") {
+            MPM.addPass(PragmaMetadataPass());
+            return true;
+          }
+
+          // 包装 main，须排在 fat-config 等同样包装 main 的 pass 之后
+          if (Name == "fork-server") {
+            MPM.addPass(ForkServerPass());
+            return true;
+          }
+
+          if (Name == "fat-config") {
+            MPM.addPass(FatConfigPass());
+            return true;
+          }
+
+          if (Name == "region-timing") {
+            MPM.addPass(RegionTimingPass());
+            return true;
+          }
+
+          if (Name == "finite-check") {
+            MPM.addPass(FiniteCheckPass());
+            return true;
+          }
+
+          if (Name == "convergence-watchdog") {
+            MPM.addPass(ConvergenceWatchdogPass());
+            return true;
+          }
+
+          if (Name == "canonical-hash") {
+            MPM.addPass(CanonicalHashPass());
+            return true;
+          }
+
+          if (Name == "ir-features") {
+            MPM.addPass(IRFeaturesPass());
+            return true;
+          }
+
+          if (Name == "shadow-value") {
+            MPM.addPass(ShadowValuePass());
+            return true;
+          }
+
+          if (Name == "record-call") {
+            MPM.addPass(CallRecordPass());
+            return true;
+          }
+
           if (Name == "pl") {
             MPM.addPass(PrecisionLoweringPass());
             return true;
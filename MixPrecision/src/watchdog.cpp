@@ -0,0 +1,143 @@
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "watchdog.hpp"
+
+static cl::list<string> Watchdogs(
+    "watchdog", cl::desc("<function>:<line>[:<col>]:<residual>, loop and residual variable to watch"));
+static cl::opt<unsigned> WatchdogPatience(
+    "watchdog-patience", cl::init(10),
+    cl::desc("Iterations without a new minimum residual before aborting"));
+static cl::opt<double> WatchdogBudget(
+    "watchdog-budget", cl::init(0), cl::desc("Seconds allowed from entering the loop, 0 for no limit"));
+
+bool ConvergenceWatchdogPass::parseSpec(StringRef text, Spec &spec) {
+    SmallVector<StringRef, 4> fields;
+    text.split(fields, ':');
+    if (fields.size() != 3 && fields.size() != 4) return false;
+
+    spec.text = text.str();
+    spec.function = fields.front().str();
+    spec.residual = fields.back().str();
+    if (fields[1].getAsInteger(10, spec.line) || spec.line == 0) return false;
+    if (fields.size() == 4 && fields[2].getAsInteger(10, spec.col)) return false;
+    return !spec.function.empty() && !spec.residual.empty();
+}
+
+// 与 region 配置一致：按循环起始位置匹配，同一行的嵌套循环取最外层
+Loop *ConvergenceWatchdogPass::findLoop(LoopInfo &LI, const Spec &spec) {
+    for (Loop *loop : LI.getLoopsInPreorder()) {
+        DebugLoc loc = loop->getStartLoc();
+        if (!loc || loc.getLine() != spec.line) continue;
+        if (spec.col && loc.getCol() != spec.col) continue;
+        return loop;
+    }
+    return nullptr;
+}
+
+// 先按调试信息中的源码变量名找，再按 IR 名字找局部变量，最后找同名全局变量
+Value *ConvergenceWatchdogPass::findResidual(Function &F, const string &name) {
+    for (auto &BB : F) {
+        for (auto &inst : BB) {
+            if (auto *declare = dyn_cast<DbgDeclareInst>(&inst)) {
+                if (declare->getVariable() && declare->getVariable()->getName() == name) {
+                    if (auto *alloca = dyn_cast_or_null<AllocaInst>(declare->getAddress())) return alloca;
+                }
+            }
+        }
+    }
+    for (auto &inst : F.getEntryBlock()) {
+        if (auto *alloca = dyn_cast<AllocaInst>(&inst); alloca && alloca->getName() == name) return alloca;
+    }
+    return F.getParent()->getGlobalVariable(name, /*AllowInternal=*/true);
+}
+
+bool ConvergenceWatchdogPass::instrument(Function &F, const Spec &spec, unsigned id) {
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+    Loop *loop = findLoop(LI, spec);
+    if (!loop) {
+        errs() << "\033[31m[Watchdog] no loop at line " << spec.line << " in " << spec.function << "\033[0m\n";
+        return false;
+    }
+
+    Value *residual = findResidual(F, spec.residual);
+    Type *type = nullptr;
+    if (auto *alloca = dyn_cast_or_null<AllocaInst>(residual)) type = alloca->getAllocatedType();
+    if (auto *global = dyn_cast_or_null<GlobalVariable>(residual)) type = global->getValueType();
+    // 残差可能已经被降精，按当前类型读取后扩展到 double
+    if (!type || !type->isFloatingPointTy()) {
+        errs() << "\033[31m[Watchdog] residual " << spec.residual << " is not a floating-point variable\033[0m\n";
+        return false;
+    }
+
+    Module &M = *F.getParent();
+    LLVMContext &context = M.getContext();
+    Type *ptrTy = PointerType::getUnqual(context);
+    Type *doubleTy = Type::getDoubleTy(context);
+    Type *int32Ty = Type::getInt32Ty(context);
+    FunctionCallee step = M.getOrInsertFunction(
+        WatchdogStep,
+        FunctionType::get(Type::getVoidTy(context), {int32Ty, doubleTy, ptrTy, int32Ty, doubleTy}, false));
+
+    FunctionCallee begin = M.getOrInsertFunction(
+        WatchdogBegin, FunctionType::get(Type::getVoidTy(context), {int32Ty}, false));
+
+    IRBuilder<> builder(context);
+    Constant *name = nullptr;
+
+    // 每次进入循环前重置：最小残差、停滞计数与计时都从这一次求解开始
+    SmallVector<BasicBlock *, 4> entering;
+    for (BasicBlock *pred : predecessors(loop->getHeader())) {
+        if (!loop->contains(pred)) entering.push_back(pred);
+    }
+    for (BasicBlock *pred : entering) {
+        builder.SetInsertPoint(pred->getTerminator());
+        builder.CreateCall(begin, {builder.getInt32(id)});
+    }
+
+    // 每次迭代末尾（回边之前）残差已经更新
+    SmallVector<BasicBlock *, 4> latches;
+    loop->getLoopLatches(latches);
+    for (BasicBlock *latch : latches) {
+        builder.SetInsertPoint(latch->getTerminator());
+        if (!name) name = builder.CreateGlobalStringPtr(spec.text, "amp.watchdog.name", 0, &M);
+        Value *value = builder.CreateLoad(type, residual, spec.residual + ".watch");
+        value = builder.CreateFPCast(value, doubleTy);
+        builder.CreateCall(step, {builder.getInt32(id), value, name, builder.getInt32(WatchdogPatience),
+                                  ConstantFP::get(doubleTy, WatchdogBudget)});
+    }
+
+    errs() << "\033[32m[Watchdog] " << spec.text << ": " << entering.size() << " entry(s), " << latches.size()
+           << " latch(es)\033[0m\n";
+    return !latches.empty();
+}
+
+PreservedAnalyses ConvergenceWatchdogPass::run(Module &M, ModuleAnalysisManager &) {
+    bool changed = false;
+    unsigned id = 0;
+    for (const string &text : Watchdogs) {
+        if (id >= WatchdogMax) {
+            errs() << "\033[31m[Watchdog] at most " << WatchdogMax << " loops can be watched, ignoring \"" << text
+                   << "\" and the rest\033[0m\n";
+            break;
+        }
+        Spec spec;
+        if (!parseSpec(text, spec)) {
+            errs() << "\033[31m[Watchdog] bad spec \"" << text << "\", expected <function>:<line>[:<col>]:<residual>\033[0m\n";
+            continue;
+        }
+        Function *F = M.getFunction(spec.function);
+        if (!F || F->isDeclaration()) {
+            errs() << "\033[31m[Watchdog] function " << spec.function << " not found\033[0m\n";
+            continue;
+        }
+        changed |= instrument(*F, spec, id++);
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
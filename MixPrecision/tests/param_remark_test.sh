@@ -0,0 +1,42 @@
+#!/bin/bash
+# 参数基因：配置里的变量名是参数名 A，降精作用在落栈的 A.addr 上。
+# change-precision 的 remark 中 Variable 必须是 A，评估脚本才能按 函数.变量:类型 认出被阻止的变更。
+# LIBMIX 为 libmix.so 的路径，OPT 默认为 PATH 中的 opt
+set -eu
+opt=${OPT:-opt}
+if [ -z "${LIBMIX:-}" ] || ! command -v "$opt" >/dev/null; then
+    echo "SKIP: set LIBMIX (and OPT if opt is not in PATH)"
+    exit 77
+fi
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/param.ll" <<'IR'
+define double @f(double %A) {
+entry:
+  %A.addr = alloca double, align 8
+  store double %A, ptr %A.addr, align 8
+  %0 = load double, ptr %A.addr, align 8
+  %mul = fmul double %0, %0
+  ret double %mul
+}
+IR
+echo '{"localVar": [{"name": "A", "function": "f", "type": "float"}]}' > "$work/config.json"
+
+# 不加 -disable-verify，pass 产生的 IR 同时要通过校验
+if ! "$opt" -load "$LIBMIX" -load-pass-plugin "$LIBMIX" -passes=pl -json-config="$work/config.json" \
+    -pass-remarks-output="$work/remarks.yaml" -S "$work/param.ll" -o "$work/out.ll" >"$work/opt.log" 2>&1; then
+    echo "opt failed or the output does not verify:"
+    tail -n 20 "$work/opt.log"
+    exit 1
+fi
+
+if ! grep -q "Pass: *change-precision" "$work/remarks.yaml"; then
+    echo "no change-precision remark emitted"
+    exit 1
+fi
+if grep -E "Variable: +" "$work/remarks.yaml" | grep -vqE "Variable: +A$"; then
+    echo "remark names a variable other than the configured parameter A:"
+    grep -E "Variable: +" "$work/remarks.yaml"
+    exit 1
+fi
@@ -0,0 +1,26 @@
+#!/bin/bash
+# 插件测试：每个 *_test.sh 直接运行，退出码 0 为通过、77 为跳过。
+# 需要 LIBMIX=<libmix.so 路径>，opt 不在 PATH 中时另设 OPT。
+# 用法：tests/run_tests.sh [测试名...]
+set -u
+cd "$(dirname "$0")"
+
+tests=("$@")
+if [ ${#tests[@]} -eq 0 ]; then
+    for f in *_test.sh; do [ -e "$f" ] && tests+=("$f"); done
+fi
+
+failed=0
+for t in "${tests[@]}"; do
+    bash "$t"
+    status=$?
+    if [ $status -eq 77 ]; then
+        echo -e "\033[33mSKIP $t\033[0m"
+    elif [ $status -ne 0 ]; then
+        failed=$((failed + 1))
+        echo -e "\033[31mFAIL $t\033[0m"
+    else
+        echo -e "\033[32mPASS $t\033[0m"
+    fi
+done
+exit $((failed > 0))
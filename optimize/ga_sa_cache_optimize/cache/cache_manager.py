@@ -12,6 +12,10 @@ class CacheManager:
         self.cache_file = cache_file
         self.tested_configs: Set[str] = set()
         self.config_details: Dict[str, Dict[str, Any]] = {}
+        # 降精、-O2 之后模块的规范化哈希 -> 适应度，不同配置生成相同代码时直接复用
+        self.code_fitness: Dict[str, float] = {}
+        # 降精 pass 备注报告做不到的变更 function.name:type -> 备注名与原因，生成个体时避开
+        self.blocked_changes: Dict[str, Dict[str, str]] = {}
         self.load_cache()
 
     def get_config_hash(self, config: Dict[str, Any]) -> str:
@@ -57,6 +61,23 @@ class CacheManager:
         if len(self.tested_configs) % 10 == 0:
             self.save_cache()
 
+    def get_code_fitness(self, code_hash: str) -> Optional[float]:
+        return self.code_fitness.get(code_hash)
+
+    def record_code_fitness(self, code_hash: str, fitness: float):
+        self.code_fitness[code_hash] = fitness
+
+    def record_blocked_change(
+        self, function: str, name: str, var_type: str, remark: str, reason: str = ""
+    ):
+        key = f"{function}.{name}:{var_type}"
+        if key not in self.blocked_changes:
+            print(f"Blocked change {key}: {remark} {reason}".rstrip())
+        self.blocked_changes[key] = {"remark": remark, "reason": reason}
+
+    def is_change_blocked(self, function: str, name: str, var_type: str) -> bool:
+        return f"{function}.{name}:{var_type}" in self.blocked_changes
+
     def get_tested_configs_count(self) -> int:
         return len(self.tested_configs)
 
@@ -78,6 +99,8 @@ class CacheManager:
 
                     self.tested_configs = set(cache_data.get("hashes", []))
                     self.config_details = cache_data.get("configs", {})
+                    self.code_fitness = cache_data.get("code_hashes", {})
+                    self.blocked_changes = cache_data.get("blocked_changes", {})
                     print(
                         f"Loaded {len(self.tested_configs)} tested "
                         f"configuration cache (new format)"
@@ -105,6 +128,8 @@ class CacheManager:
             cache_data = {
                 "hashes": list(self.tested_configs),
                 "configs": self.config_details,
+                "code_hashes": self.code_fitness,
+                "blocked_changes": self.blocked_changes,
                 "metadata": {
                     "total_configs": len(self.tested_configs),
                     "last_updated": datetime.now().isoformat(),
@@ -129,6 +154,8 @@ class CacheManager:
                 print(f"Cleared cache file: {self.cache_file}")
             self.tested_configs.clear()
             self.config_details.clear()
+            self.code_fitness.clear()
+            self.blocked_changes.clear()
             print("Cleared tested configurations in memory")
         except Exception as e:
             print(f"Failed to clear cache file: {e}")
@@ -11,6 +11,15 @@ class ConfigDeduplication:
         self.scalar_types = ["double", "float", "half"]
         self.pointer_types = ["double*", "float*", "half*"]
 
+    def _allowed_types(self, var: Dict[str, Any], candidates: List[str]) -> List[str]:
+        """去掉降精 pass 备注过做不到的类型，全被排除时保留当前类型"""
+        allowed = [
+            t
+            for t in candidates
+            if not self.cache_manager.is_change_blocked(var["function"], var["name"], t)
+        ]
+        return allowed or [var["type"]]
+
     def create_random_individual(
         self, initial_configs: List[Dict[str, Any]]
     ) -> Dict[str, Any]:
@@ -23,9 +32,13 @@ class ConfigDeduplication:
 
             for var in individual.get("localVar", []):
                 if var["type"].endswith("*"):
-                    var["type"] = random.choice(self.pointer_types)
+                    var["type"] = random.choice(
+                        self._allowed_types(var, self.pointer_types)
+                    )
                 else:
-                    var["type"] = random.choice(self.scalar_types)
+                    var["type"] = random.choice(
+                        self._allowed_types(var, self.scalar_types)
+                    )
 
             if not self.cache_manager.is_config_tested(individual):
                 return individual
@@ -36,12 +49,20 @@ class ConfigDeduplication:
             if random.random() < 0.3:
                 if var["type"].endswith("*"):
                     current_type = var["type"]
-                    other_types = [t for t in self.pointer_types if t != current_type]
+                    other_types = [
+                        t
+                        for t in self._allowed_types(var, self.pointer_types)
+                        if t != current_type
+                    ]
                     if other_types:
                         var["type"] = random.choice(other_types)
                 else:
                     current_type = var["type"]
-                    other_types = [t for t in self.scalar_types if t != current_type]
+                    other_types = [
+                        t
+                        for t in self._allowed_types(var, self.scalar_types)
+                        if t != current_type
+                    ]
                     if other_types:
                         var["type"] = random.choice(other_types)
 
@@ -2,7 +2,10 @@
 
 import os
 import copy
+import json
 import statistics
+import subprocess
+from concurrent.futures import ThreadPoolExecutor
 from typing import List, Dict, Any, Tuple
 
 
@@ -21,6 +24,8 @@ from core.evolution_engine import EvolutionEngine
 from core.sa_patch import SAPatch
 from core.group_search_engine import GroupSearchEngine
 from proxy_models.surrogate_optimizer_data1 import SurrogateOptimizerData1
+from proxy_models.xgboost_model_manager_data1 import XGBoostModelManagerData1
+from proxy_models.config import MODEL_CONFIG
 import numpy as np
 
 
@@ -127,7 +132,6 @@ class GeneticOptimizer:
         else:
             self.surrogate_available = False
 
-
         self.fitness_evaluator = FitnessEvaluator(
             self.config_manager,
             self.cache_manager,
@@ -137,6 +141,19 @@ class GeneticOptimizer:
             self.output_base,
         )
 
+        # 设置了 GA_SA_AMP_SURROGATE 与 GA_SA_SURROGATE_TOP 时，每代先用 amp-surrogate
+        # 给全部个体打分，只有得分最好的 N 个进入后续评估，其余按 skip 处理。
+        # 打分的原生模型以实测个体降精后模块的 IR 特征（ir_features.json）为输入、实测适应度为目标，
+        # 每代按已记录的样本重新训练，因此实测时总是写出 IR 特征
+        self.amp_surrogate = os.environ.get("GA_SA_AMP_SURROGATE")
+        self.surrogate_top = int(os.environ.get("GA_SA_SURROGATE_TOP", "0"))
+        self.native_surrogate_model = os.path.join(
+            self.output_base, "ir_surrogate_native.json"
+        )
+        self.native_model_samples = 0
+        if self.amp_surrogate and self.surrogate_top > 0:
+            self.fitness_evaluator.ir_features = True
+
 
         self.best_config = None
         self.best_fitness = float("inf")
@@ -173,9 +190,40 @@ class GeneticOptimizer:
             fitness_values = []
             early_termination_triggered = False
 
+            screened = self._prescreen_with_amp_surrogate(population, generation)
+
+            def evaluation_strategy_for(index, individual):
+                if screened is not None and index not in screened:
+                    return "skip"
+                return self._should_use_surrogate(individual)
+
+            # 批量评估时先定下每个个体的评估方式，需要实测的一次交给 amp-eval
+            strategies = None
+            batch_fitness = {}
+            if getattr(self.fitness_evaluator, "batch_enabled", False):
+                strategies = [
+                    evaluation_strategy_for(i, ind) for i, ind in enumerate(population)
+                ]
+                actual = [
+                    i for i, s in enumerate(strategies) if s not in ("skip", "surrogate")
+                ]
+                if actual:
+                    batch_fitness = (
+                        self.fitness_evaluator.evaluate_batch(
+                            [population[i] for i in actual],
+                            [f"gen{generation}_ind{i}" for i in actual],
+                            incumbent_fitness=self.best_fitness,
+                        )
+                        or {}
+                    )
+
             for i, individual in enumerate(population):
 
-                evaluation_strategy = self._should_use_surrogate(individual)
+                evaluation_strategy = (
+                    strategies[i]
+                    if strategies is not None
+                    else evaluation_strategy_for(i, individual)
+                )
 
                 if evaluation_strategy == "skip":
                     print(
@@ -194,9 +242,13 @@ class GeneticOptimizer:
                 else:
                     print(f"Using actual evaluation for individual {i}")
                     try:
-                        fitness = self.fitness_evaluator.evaluate_fitness(
-                            individual, f"gen{generation}_ind{i}"
-                        )
+                        individual_id = f"gen{generation}_ind{i}"
+                        if individual_id in batch_fitness:
+                            fitness = batch_fitness[individual_id]
+                        else:
+                            fitness = self.fitness_evaluator.evaluate_fitness(
+                                individual, individual_id
+                            )
                     except Exception as eval_error:
                         print(
                             f"ERROR: Actual evaluation failed for individual {i}: {eval_error}"
@@ -435,6 +487,98 @@ class GeneticOptimizer:
             print(f"Feature extraction failed: {e}")
             return {}
 
+    def _train_native_surrogate(self) -> bool:
+        """用实测个体记录下的 IR 特征与适应度训练原生模型并导出为 JSON，样本不足时返回 False"""
+        samples = self.fitness_evaluator.load_ir_samples()
+        if len(samples) < MODEL_CONFIG["surrogate_optimizer"]["min_training_samples"]:
+            return False
+        if len(samples) == self.native_model_samples:
+            return True
+
+        # 特征只列出模块中出现的项，缺少的计数即为 0
+        feature_names = sorted(
+            {name for sample in samples for name in sample["features"]}
+        )
+        X = np.array(
+            [
+                [sample["features"].get(name, 0.0) for name in feature_names]
+                for sample in samples
+            ]
+        )
+        y = np.array([sample["fitness"] for sample in samples])
+        XGBoostModelManagerData1(model_dir=self.output_base).export_native_model(
+            self.native_surrogate_model, X, y, feature_names
+        )
+        self.native_model_samples = len(samples)
+        return True
+
+    def _prescreen_with_amp_surrogate(self, population, generation):
+        """用 amp-surrogate 一次给整代个体打分，返回保留下来的个体下标；不做预筛时返回 None"""
+        if (
+            not self.amp_surrogate
+            or self.surrogate_top <= 0
+            or generation == 0
+            or len(population) <= self.surrogate_top
+            or not self._train_native_surrogate()
+        ):
+            return None
+
+        # 特征取自降精后的模块：每个个体只跑 pl 与 ir-features，不做代码生成与运行。
+        # 已实测过的配置走缓存，不必打分；其余个体并行提取，-j 与 amp-eval 相同
+        feature_base = os.path.join(self.output_base, f"gen{generation}_surrogate")
+        unscored = {
+            i
+            for i, individual in enumerate(population)
+            if self.cache_manager.is_config_evaluated_actually(individual)
+        }
+        pending = [i for i in range(len(population)) if i not in unscored]
+        jobs = int(os.environ.get("GA_SA_AMP_EVAL_JOBS") or os.cpu_count() or 1)
+        with ThreadPoolExecutor(max_workers=jobs) as executor:
+            extracted = executor.map(
+                lambda i: self.fitness_evaluator.extract_ir_features(
+                    population[i], os.path.join(feature_base, f"individual_{i}")
+                ),
+                pending,
+            )
+            candidates = []
+            for i, features in zip(pending, extracted):
+                if features is None:
+                    unscored.add(i)
+                else:
+                    candidates.append({"id": i, "features": features})
+        if len(candidates) <= self.surrogate_top:
+            return None
+
+        candidates_file = os.path.join(
+            self.output_base, f"gen{generation}_surrogate_candidates.jsonl"
+        )
+        with open(candidates_file, "w") as f:
+            for candidate in candidates:
+                f.write(json.dumps(candidate) + "\n")
+
+        cmd = [
+            self.amp_surrogate,
+            "-model",
+            self.native_surrogate_model,
+            candidates_file,
+            "-top",
+            str(self.surrogate_top),
+        ]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(f"amp-surrogate failed, no pre-screening: {result.stderr.strip()}")
+            return None
+        print(result.stderr.strip())
+
+        kept = {json.loads(line)["id"] for line in result.stdout.splitlines() if line}
+        # 已实测过、或降精失败拿不到特征的个体不参与排名，照常交给后续评估
+        kept |= unscored
+        print(
+            f"amp-surrogate kept {len(kept)} of {len(population)} individual(s) "
+            f"for generation {generation + 1}"
+        )
+        return kept
+
     def _should_use_surrogate(self, config: Dict[str, Any]) -> str:
 
 
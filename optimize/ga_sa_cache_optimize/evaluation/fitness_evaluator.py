@@ -1,8 +1,9 @@
 import os
 import json
 import copy
+import math
 import subprocess
-from typing import Dict, Any
+from typing import Dict, Any, List
 
 
 import sys
@@ -14,6 +15,14 @@ from config.config_manager import ConfigManager
 from config.conversion_steps import ConversionSteps
 from evaluation.performance_parser import PerformanceParser
 
+# -check-finite 插桩的程序遇到 Inf/NaN 时的退出码，见 AMPPipeline/runtime/amp_nonfinite.c
+AMP_NONFINITE_EXIT = 86
+# 收敛看门狗触发时的退出码，见 AMPPipeline/runtime/amp_watchdog.c
+AMP_WATCHDOG_EXIT = 87
+# 这些备注表示配置中的变更做不到，见 MixPrecision/include/change_remarks.hpp；
+# Blocked 是 PartiallyApplied 的逐个使用者明细，不单独计入
+BLOCKING_REMARKS = ("Rejected", "PartiallyApplied", "UnknownType", "NotFound")
+
 
 class FitnessEvaluator:
 
@@ -45,6 +54,74 @@ class FitnessEvaluator:
             os.path.join(self.ga_sa_improved_dir, "hpllink.ll"),
         )
 
+        # 设置后改用 fork server 运行：amp-run 只启动一次 qemu，每次测试由程序内的桩代码 fork
+        self.amp_run = os.environ.get("GA_SA_AMP_RUN")
+        self.forksrv_runtime = os.environ.get("GA_SA_FORKSRV_RUNTIME")
+        self.use_fork_server = bool(self.amp_run and self.forksrv_runtime)
+        # 设置后最后一步降精加上非有限值检查，溢出的配置在第一次出现 Inf/NaN 时即退出
+        self.nonfinite_runtime = os.environ.get("GA_SA_NONFINITE_RUNTIME")
+        # 收敛看门狗：GA_SA_WATCHDOG 为 <function>:<line>[:<col>]:<residual>，可用 ; 分隔多个
+        self.watchdog_specs = [
+            spec for spec in os.environ.get("GA_SA_WATCHDOG", "").split(";") if spec
+        ]
+        self.watchdog_runtime = os.environ.get("GA_SA_WATCHDOG_RUNTIME")
+        self.watchdog_patience = os.environ.get("GA_SA_WATCHDOG_PATIENCE")
+        self.watchdog_budget = os.environ.get("GA_SA_WATCHDOG_BUDGET")
+        # 影子值诊断：设置后每个降精变量带 double 影子，运行结束写出 amp_shadow.json（按误差排序）
+        self.shadow_runtime = os.environ.get("GA_SA_SHADOW_RUNTIME")
+        # 区域计时：设置后给 #pragma AutoMxPrec 区域（及 GA_SA_TIME_FUNCTIONS 中逗号分隔的函数）插桩，
+        # 程序退出时写出 amp_timing.json
+        self.timing_runtime = os.environ.get("GA_SA_TIMING_RUNTIME")
+        self.time_functions = os.environ.get("GA_SA_TIME_FUNCTIONS")
+        # 构建产物缓存：GA_SA_AMP_CACHE 为 amp-cache 路径，相同模块、配置与工具链直接复用可执行文件
+        self.amp_cache = os.environ.get("GA_SA_AMP_CACHE")
+        self.amp_cache_dir = os.environ.get(
+            "GA_SA_AMP_CACHE_DIR", os.path.join(output_base, "artifact_cache")
+        )
+        self.amp_cache_max_mb = os.environ.get("GA_SA_AMP_CACHE_MAX_MB", "0")
+        self._toolchain_version = None
+        # 设置后每步降精写出 pass_stats_<step>.json（计数器与各阶段耗时），便于按配置跟踪 pass 开销
+        self.pass_stats = bool(os.environ.get("GA_SA_PASS_STATS"))
+        # 设置后降精 pass 不再逐个变量输出日志
+        self.pass_quiet = bool(os.environ.get("GA_SA_PASS_QUIET"))
+        # 设置后每步降精写出 remarks_<step>.yaml（优化备注），做不到的变更记入缓存，之后生成个体时避开
+        self.pass_remarks = bool(os.environ.get("GA_SA_PASS_REMARKS"))
+        # 设置后最后一步降精写出 ir_features.json（降精后模块的静态特征，可供代理模型使用）
+        self.ir_features = bool(os.environ.get("GA_SA_IR_FEATURES"))
+        # 写出 IR 特征时，每个实测成功的个体把特征与适应度追加到这里，作为 amp-surrogate 原生模型的训练样本
+        self.ir_samples_file = os.path.join(output_base, "ir_feature_samples.jsonl")
+        # 静态吞吐估计：GA_SA_AMP_MCA 为 amp-mca 路径，GA_SA_AMP_MCA_FUNCTIONS 为逗号分隔的函数名
+        self.amp_mca = os.environ.get("GA_SA_AMP_MCA")
+        self.amp_mca_functions = os.environ.get("GA_SA_AMP_MCA_FUNCTIONS")
+        # 设置后在 -O2 之后计算模块的规范化哈希，生成相同代码的配置直接复用已有适应度
+        self.canonical_hash = bool(os.environ.get("GA_SA_CANONICAL_HASH"))
+        # 按函数增量代码生成：GA_SA_AMP_CODEGEN 为 amp-codegen 路径，代替 llc 并按函数复用目标文件
+        self.amp_codegen = os.environ.get("GA_SA_AMP_CODEGEN")
+        self.amp_codegen_cache_dir = os.environ.get(
+            "GA_SA_AMP_CODEGEN_CACHE_DIR", os.path.join(output_base, "object_cache")
+        )
+        # 批量评估：GA_SA_AMP_EVAL 为 amp-eval 路径，一代中需要实测的个体交给它流水并行评估，
+        # GA_SA_AMP_EVAL_JOBS 为总工作线程数。fork server、产物缓存、增量代码生成、规范化哈希与
+        # 静态吞吐估计都是逐个体的流程，启用其中任何一项时仍逐个评估
+        self.amp_eval = os.environ.get("GA_SA_AMP_EVAL")
+        self.amp_eval_jobs = os.environ.get("GA_SA_AMP_EVAL_JOBS")
+        self.batch_enabled = bool(self.amp_eval) and not (
+            self.use_fork_server
+            or self.amp_cache
+            or self.amp_codegen
+            or self.canonical_hash
+            or self.amp_mca
+        )
+        # 低噪声测量：GA_SA_ISOLATE 时 amp-eval 给每个运行线程独占 CPU 并关闭 ASLR，
+        # 逐个评估（fork server 或直接启动 qemu）时同样绑到允许集合的最后一个 CPU，与 amp-eval 默认一致；
+        # GA_SA_PERF_COUNTERS 时记录 cycles/instructions/缓存缺失（amp-eval 写到 measurement.json，
+        # fork server 写到 qemu_output_<n>.json），GA_SA_FIXED_FREQUENCY 时在有权限时固定频率
+        self.isolate = bool(os.environ.get("GA_SA_ISOLATE"))
+        self.perf_counters = bool(os.environ.get("GA_SA_PERF_COUNTERS"))
+        self.fixed_frequency = bool(os.environ.get("GA_SA_FIXED_FREQUENCY"))
+        # 重复竞赛：GA_SA_RACE 为每个个体最多运行的次数，amp-eval 在得分区间与当前最优分开时提前停止
+        self.race_max = int(os.environ.get("GA_SA_RACE", "0"))
+
         self._baseline_T0 = None
 
     def evaluate_fitness(self, config: Dict[str, Any], individual_id: str) -> float:
@@ -66,119 +143,60 @@ class FitnessEvaluator:
 
         try:
 
-            current_ll = self.initial_ll
-            current_config = copy.deepcopy(self.config_manager.get_baseline_config())
-
-            target_config = config
-            conversion_steps = self.conversion_steps.get_conversion_steps(
-                current_config, target_config
-            )
-
-            steps_len = len(conversion_steps)
-            print(f"Individual {individual_id} conversion steps: {steps_len}")
-
-            for step_idx, step_config in enumerate(conversion_steps):
-
-                step_config_file = os.path.join(
-                    individual_dir, f"step_{step_idx}_config.json"
-                )
-                self.config_manager.save_config(step_config, step_config_file)
-
-                working_config_file = os.path.join(individual_dir, "config.json")
-                self.config_manager.save_config(step_config, working_config_file)
-
-                output_ll = os.path.join(
-                    arm64_output_dir, f"step_{step_idx}_optimized.ll"
-                )
-
-                libmix_path = os.environ["GA_SA_LIBMIX_PATH"]
-
-                opt_cmd = [
-                    "opt",
-                    f"-load-pass-plugin={libmix_path}",
-                    current_ll,
-                    "-S",
-                    "-o",
-                    output_ll,
-                    "-passes=pl",
-                ]
-
-                result = subprocess.run(
-                    opt_cmd,
-                    cwd=individual_dir,
-                    capture_output=True,
-                    text=True,
+            exec_path = os.path.join(arm64_output_dir, "hpl_exec_optimized")
+            code_hash = None
+            artifact_key = self._artifact_key(config, individual_dir)
+            if artifact_key and self._fetch_artifact(artifact_key, "exec", exec_path):
+                print(f"Individual {individual_id} executable restored from artifact cache")
+            elif not self._lower_and_optimize(
+                config, individual_id, individual_dir, arm64_output_dir
+            ):
+                return float("inf")
+            else:
+                if self.amp_mca:
+                    self._static_throughput(
+                        individual_id, individual_dir, arm64_output_dir
+                    )
+                code_hash = self._read_code_hash(individual_dir)
+                known_fitness = (
+                    self.cache_manager.get_code_fitness(code_hash) if code_hash else None
                 )
-                if result.returncode != 0:
+                if known_fitness is not None:
                     print(
-                        f"opt failed for individual {individual_id} "
-                        f"step {step_idx}: {result.stderr}"
+                        f"Individual {individual_id} compiles to already evaluated code "
+                        f"{code_hash[:12]}, reusing fitness"
                     )
+                    self.cache_manager.mark_config_as_tested(
+                        config, fitness=known_fitness, evaluation_type="code_hash"
+                    )
+                    return known_fitness
+                if not self._codegen_and_link(
+                    individual_id, individual_dir, arm64_output_dir
+                ):
                     return float("inf")
-
-                current_ll = output_ll
-                current_config = step_config
-
-            final_ll = os.path.join(arm64_output_dir, "hpllink_optimized.ll")
-            if os.path.exists(current_ll):
-                import shutil
-
-                shutil.copy2(current_ll, final_ll)
-
-            opt_o2_cmd = ["opt", final_ll, "-S", "-o", final_ll, "-O2"]
-
-            result = subprocess.run(
-                opt_o2_cmd,
-                cwd=individual_dir,
-                capture_output=True,
-                text=True,
-            )
-            if result.returncode != 0:
-                print(f"opt -O2 failed for individual {individual_id}: {result.stderr}")
-                return float("inf")
-
-            final_config_file = os.path.join(individual_dir, "config.json")
-            self.config_manager.save_config(target_config, final_config_file)
-
-            llc_cmd = [
-                "llc",
-                os.path.join(arm64_output_dir, "hpllink_optimized.ll"),
-                "-o",
-                os.path.join(arm64_output_dir, "hpllink_optimized.s"),
-            ]
-
-            result = subprocess.run(
-                llc_cmd, cwd=individual_dir, capture_output=True, text=True
-            )
-            if result.returncode != 0:
-                print(f"llc failed for individual {individual_id}: {result.stderr}")
-                return float("inf")
-
-            clang_cmd = [
-                "clang",
-                "--target=aarch64-linux-gnu",
-                "-march=armv8.2-a+fp16",
-                "-O2",
-                "-static",
-                os.path.join(arm64_output_dir, "hpllink_optimized.s"),
-                "-o",
-                os.path.join(arm64_output_dir, "hpl_exec_optimized"),
-                "-lm",
-            ]
-
-            result = subprocess.run(
-                clang_cmd,
-                cwd=individual_dir,
-                capture_output=True,
-                text=True,
-            )
-            if result.returncode != 0:
-                print(f"clang failed for individual {individual_id}: {result.stderr}")
-                return float("inf")
+                if artifact_key:
+                    self._store_artifacts(artifact_key, arm64_output_dir)
 
             qemu_outputs = []
 
-            for test_run in range(self.test_num):
+            if self.use_fork_server:
+                qemu_outputs = self._run_with_fork_server(
+                    os.path.join(arm64_output_dir, "hpl_exec_optimized"), individual_dir
+                )
+                if qemu_outputs is None:
+                    print(f"amp-run failed for individual {individual_id}")
+                    return float("inf")
+                for qemu_output in qemu_outputs:
+                    if qemu_output["returncode"] != 0:
+                        self._report_failed_run(
+                            individual_id,
+                            individual_dir,
+                            qemu_output["returncode"],
+                            qemu_output["stderr"],
+                        )
+                        return float("inf")
+
+            for test_run in range(0 if self.use_fork_server else self.test_num):
                 qemu_cmd = [
                     "qemu-aarch64",
                     "-L",
@@ -194,6 +212,7 @@ class FitnessEvaluator:
                     cwd=individual_dir,
                     capture_output=True,
                     text=True,
+                    preexec_fn=self._pin_run if self.isolate else None,
                 )
 
                 if result.returncode == 0:
@@ -212,8 +231,8 @@ class FitnessEvaluator:
                     with open(qemu_output_file, "w") as f:
                         json.dump(qemu_output, f, indent=2)
                 else:
-                    print(
-                        f"qemu failed for individual {individual_id}: {result.stderr}"
+                    self._report_failed_run(
+                        individual_id, individual_dir, result.returncode, result.stderr
                     )
                     return float("inf")
 
@@ -232,6 +251,12 @@ class FitnessEvaluator:
                     "qemu_outputs": qemu_outputs,
                 }
 
+                # 经 region-timing 插桩的程序退出时写出各区域的累计时间
+                timing_file = os.path.join(individual_dir, "amp_timing.json")
+                if os.path.exists(timing_file):
+                    with open(timing_file) as f:
+                        qemu_summary["region_timing"] = json.load(f)["regions"]
+
                 qemu_summary_file = os.path.join(individual_dir, "qemu_summary.json")
                 with open(qemu_summary_file, "w") as f:
                     json.dump(qemu_summary, f, indent=2)
@@ -262,6 +287,9 @@ class FitnessEvaluator:
                 self.cache_manager.mark_config_as_tested(
                     config, fitness=fitness, evaluation_type="actual"
                 )
+                if code_hash:
+                    self.cache_manager.record_code_fitness(code_hash, fitness)
+                self._record_ir_sample(individual_dir, fitness)
 
                 print(f"Individual {individual_id} final_marks: {-fitness:.4f}")
                 return fitness
@@ -271,3 +299,618 @@ class FitnessEvaluator:
         except Exception as e:
             print(f"Error evaluating individual {individual_id}: {e}")
             return float("inf")
+
+    def evaluate_batch(self, configs, individual_ids, incumbent_fitness=None):
+        """经由 amp-eval 评估一批配置，返回 {individual_id: fitness}；amp-eval 本身失败时返回 None。
+        incumbent_fitness 为目前最好的适应度，竞赛时作为对手"""
+        batch_dir = os.path.join(self.output_base, "amp_eval")
+        os.makedirs(batch_dir, exist_ok=True)
+        baseline_file = os.path.join(batch_dir, "baseline_config.json")
+        self.config_manager.save_config(
+            self.config_manager.get_baseline_config(), baseline_file
+        )
+        population_file = os.path.join(batch_dir, "population.jsonl")
+        with open(population_file, "w") as f:
+            for individual_id, config in zip(individual_ids, configs):
+                f.write(json.dumps({"id": individual_id, "config": config}) + "\n")
+
+        cmd = [
+            self.amp_eval,
+            f"-libmix={os.environ['GA_SA_LIBMIX_PATH']}",
+            f"-module={self.initial_ll}",
+            f"-baseline={baseline_file}",
+            f"-work-dir={self.output_base}",
+            f"-run-args={self.size_num} {self.min_size} {self.max_size}",
+            f"-test-num={self.test_num}",
+            population_file,
+        ]
+        if self.amp_eval_jobs:
+            cmd.append(f"-j={self.amp_eval_jobs}")
+        if self.isolate:
+            cmd += ["-isolate", "-no-aslr"]
+        if self.perf_counters:
+            cmd.append("-perf-counters")
+        if self.fixed_frequency:
+            cmd.append("-fixed-frequency")
+        if self.race_max > 0:
+            cmd += ["-race", f"-race-max={self.race_max}"]
+            if incumbent_fitness is not None and math.isfinite(incumbent_fitness):
+                cmd.append(f"-incumbent={-incumbent_fitness}")
+        # 与 _lower_and_optimize 的逐步参数一致，{dir}/{step} 由 amp-eval 展开
+        if self.pass_quiet:
+            cmd.append("-pl-arg=-amp-quiet")
+        if self.pass_stats:
+            cmd.append("-pl-arg=-amp-stats-out={dir}/pass_stats_{step}.json")
+        if self.pass_remarks:
+            cmd.append("-pl-arg=-pass-remarks-output={dir}/remarks_{step}.yaml")
+        if self.nonfinite_runtime:
+            cmd.append("-last-pl-arg=-check-finite")
+        if self.ir_features:
+            cmd.append("-last-pl-arg=-ir-features-out={dir}/ir_features.json")
+        instrument_passes, instrument_args = self._instrument_passes()
+        cmd += [f"-o2-pass={name}" for name in instrument_passes]
+        cmd += [f"-o2-arg={arg}" for arg in instrument_args]
+        for runtime in (
+            self.nonfinite_runtime,
+            self.watchdog_runtime if self.watchdog_specs else None,
+            self.shadow_runtime,
+            self.timing_runtime,
+        ):
+            if runtime:
+                cmd.append(f"-link={runtime}")
+
+        configs_by_id = dict(zip(individual_ids, configs))
+        for config in configs:
+            self.cache_manager.mark_config_as_tested(config)
+
+        results = {}
+        process = subprocess.Popen(cmd, stdout=subprocess.PIPE, text=True)
+        for line in process.stdout:
+            result = json.loads(line)
+            individual_id = result["id"]
+            fitness = result["fitness"]
+            if "run" in result:
+                with open(os.path.join(result["dir"], "measurement.json"), "w") as f:
+                    json.dump(result["run"], f, indent=2)
+            if "race" in result:
+                race = result["race"]
+                print(
+                    f"Individual {individual_id} raced {race['runs']} runs: "
+                    f"[{race['low']:.4f}, {race['high']:.4f}] {race['decision']}"
+                )
+                with open(os.path.join(result["dir"], "race.json"), "w") as f:
+                    json.dump(race, f, indent=2)
+            if self.pass_remarks:
+                # amp-eval 与 _lower_and_optimize 同样按 conversion_steps 分 1~2 步降精
+                steps = self.conversion_steps.get_conversion_steps(
+                    self.config_manager.get_baseline_config(),
+                    configs_by_id[individual_id],
+                )
+                for step_idx in range(len(steps)):
+                    self._collect_blocked_changes(
+                        os.path.join(result["dir"], f"remarks_{step_idx}.yaml")
+                    )
+            if fitness is None:
+                print(
+                    f"Individual {individual_id} failed in {result.get('failedStage')}: "
+                    f"{result.get('error', '')}"
+                )
+                results[individual_id] = float("inf")
+                continue
+            self.cache_manager.mark_config_as_tested(
+                configs_by_id[individual_id], fitness=fitness, evaluation_type="actual"
+            )
+            self._record_ir_sample(result["dir"], fitness)
+            print(f"Individual {individual_id} final_marks: {-fitness:.4f}")
+            results[individual_id] = fitness
+        if process.wait() != 0:
+            print(f"amp-eval failed with exit code {process.returncode}")
+            return None
+        return results
+
+    def _lower_and_optimize(
+        self,
+        config: Dict[str, Any],
+        individual_id: str,
+        individual_dir: str,
+        arm64_output_dir: str,
+    ) -> bool:
+        """按配置逐步降精并 -O2，得到 hpllink_optimized.ll，失败返回 False"""
+        current_ll = self.initial_ll
+        current_config = copy.deepcopy(self.config_manager.get_baseline_config())
+
+        target_config = config
+        conversion_steps = self.conversion_steps.get_conversion_steps(
+            current_config, target_config
+        )
+
+        steps_len = len(conversion_steps)
+        print(f"Individual {individual_id} conversion steps: {steps_len}")
+
+        for step_idx, step_config in enumerate(conversion_steps):
+
+            step_config_file = os.path.join(
+                individual_dir, f"step_{step_idx}_config.json"
+            )
+            self.config_manager.save_config(step_config, step_config_file)
+
+            working_config_file = os.path.join(individual_dir, "config.json")
+            self.config_manager.save_config(step_config, working_config_file)
+
+            output_ll = os.path.join(
+                arm64_output_dir, f"step_{step_idx}_optimized.ll"
+            )
+
+            libmix_path = os.environ["GA_SA_LIBMIX_PATH"]
+
+            opt_cmd = [
+                "opt",
+                f"-load-pass-plugin={libmix_path}",
+                current_ll,
+                "-S",
+                "-o",
+                output_ll,
+                "-passes=pl",
+            ]
+            step_args = []
+            if self.pass_quiet:
+                step_args.append("-amp-quiet")
+            if self.pass_stats:
+                step_args.append(
+                    f"-amp-stats-out={os.path.join(individual_dir, f'pass_stats_{step_idx}.json')}"
+                )
+            remarks_file = os.path.join(individual_dir, f"remarks_{step_idx}.yaml")
+            if self.pass_remarks:
+                step_args.append(f"-pass-remarks-output={remarks_file}")
+            if step_idx == steps_len - 1:
+                if self.nonfinite_runtime:
+                    step_args.append("-check-finite")
+                if self.ir_features:
+                    step_args.append(
+                        f"-ir-features-out={os.path.join(individual_dir, 'ir_features.json')}"
+                    )
+            if step_args:
+                opt_cmd[1:1] = [f"-load={libmix_path}"]
+                opt_cmd += step_args
+
+            result = subprocess.run(
+                opt_cmd,
+                cwd=individual_dir,
+                capture_output=True,
+                text=True,
+            )
+            # 失败的步骤同样要读备注，里面正是失败的原因
+            if self.pass_remarks:
+                self._collect_blocked_changes(remarks_file)
+            if result.returncode != 0:
+                print(
+                    f"opt failed for individual {individual_id} "
+                    f"step {step_idx}: {result.stderr}"
+                )
+                return False
+
+            current_ll = output_ll
+            current_config = step_config
+
+        final_ll = os.path.join(arm64_output_dir, "hpllink_optimized.ll")
+        if os.path.exists(current_ll):
+            import shutil
+
+            shutil.copy2(current_ll, final_ll)
+
+        opt_o2_cmd = ["opt", final_ll, "-S", "-o", final_ll, "-O2"]
+        # 插桩 pass 放在 -O2 之前，与优化一起跑一次 opt
+        instrument_passes, instrument_args = self._instrument_passes()
+        pipeline = instrument_passes + ["default<O2>"]
+        # 规范化哈希在 -O2 之后计算，写到 code_hash.txt
+        code_hash_file = os.path.join(individual_dir, "code_hash.txt")
+        if self.canonical_hash:
+            pipeline.append("canonical-hash")
+            instrument_args = instrument_args + [f"-canonical-hash-out={code_hash_file}"]
+            if os.path.exists(code_hash_file):
+                os.remove(code_hash_file)
+        if len(pipeline) > 1:
+            libmix_path = os.environ["GA_SA_LIBMIX_PATH"]
+            opt_o2_cmd = [
+                "opt",
+                f"-load={libmix_path}",
+                f"-load-pass-plugin={libmix_path}",
+                final_ll,
+                "-S",
+                "-o",
+                final_ll,
+                f"-passes={','.join(pipeline)}",
+            ] + instrument_args
+
+        result = subprocess.run(
+            opt_o2_cmd,
+            cwd=individual_dir,
+            capture_output=True,
+            text=True,
+        )
+        if result.returncode != 0:
+            print(f"opt -O2 failed for individual {individual_id}: {result.stderr}")
+            return False
+
+        final_config_file = os.path.join(individual_dir, "config.json")
+        self.config_manager.save_config(target_config, final_config_file)
+        return True
+
+    def extract_ir_features(self, config: Dict[str, Any], feature_dir: str):
+        """只做逐步降精（不 -O2、不编译运行），返回最后一步 ir-features 给出的特征，失败返回 None"""
+        os.makedirs(feature_dir, exist_ok=True)
+        libmix_path = os.environ["GA_SA_LIBMIX_PATH"]
+        features_file = os.path.join(feature_dir, "ir_features.json")
+        if os.path.exists(features_file):
+            os.remove(features_file)
+
+        current_ll = self.initial_ll
+        conversion_steps = self.conversion_steps.get_conversion_steps(
+            copy.deepcopy(self.config_manager.get_baseline_config()), config
+        )
+        for step_idx, step_config in enumerate(conversion_steps):
+            self.config_manager.save_config(
+                step_config, os.path.join(feature_dir, "config.json")
+            )
+            output_ll = os.path.join(feature_dir, f"step_{step_idx}.ll")
+            opt_cmd = [
+                "opt",
+                f"-load={libmix_path}",
+                f"-load-pass-plugin={libmix_path}",
+                current_ll,
+                "-S",
+                "-o",
+                output_ll,
+                "-passes=pl",
+                "-amp-quiet",
+            ]
+            if step_idx == len(conversion_steps) - 1:
+                opt_cmd.append(f"-ir-features-out={features_file}")
+            result = subprocess.run(
+                opt_cmd, cwd=feature_dir, capture_output=True, text=True
+            )
+            if result.returncode != 0:
+                return None
+            current_ll = output_ll
+
+        if not os.path.exists(features_file):
+            return None
+        with open(features_file) as f:
+            return json.load(f)
+
+    def _record_ir_sample(self, individual_dir: str, fitness: float):
+        """把实测个体降精后模块的 IR 特征与适应度追加到 ir_samples_file"""
+        features_file = os.path.join(individual_dir, "ir_features.json")
+        if (
+            not self.ir_features
+            or not math.isfinite(fitness)
+            or not os.path.exists(features_file)
+        ):
+            return
+        with open(features_file) as f:
+            features = json.load(f)
+        with open(self.ir_samples_file, "a") as f:
+            f.write(json.dumps({"features": features, "fitness": fitness}) + "\n")
+
+    def load_ir_samples(self) -> List[Dict[str, Any]]:
+        """读出 _record_ir_sample 记录的全部样本"""
+        if not os.path.exists(self.ir_samples_file):
+            return []
+        with open(self.ir_samples_file) as f:
+            return [json.loads(line) for line in f if line.strip()]
+
+    def _codegen_and_link(
+        self, individual_id: str, individual_dir: str, arm64_output_dir: str
+    ) -> bool:
+        """把 hpllink_optimized.ll 编译链接为 hpl_exec_optimized，失败返回 False"""
+
+        if self.amp_codegen:
+            link_inputs = self._incremental_codegen(
+                individual_id, individual_dir, arm64_output_dir
+            )
+            if link_inputs is None:
+                return False
+        else:
+            llc_cmd = [
+                "llc",
+                os.path.join(arm64_output_dir, "hpllink_optimized.ll"),
+                "-o",
+                os.path.join(arm64_output_dir, "hpllink_optimized.s"),
+            ]
+
+            result = subprocess.run(
+                llc_cmd, cwd=individual_dir, capture_output=True, text=True
+            )
+            if result.returncode != 0:
+                print(f"llc failed for individual {individual_id}: {result.stderr}")
+                return False
+            link_inputs = [os.path.join(arm64_output_dir, "hpllink_optimized.s")]
+
+        clang_cmd = [
+            "clang",
+            "--target=aarch64-linux-gnu",
+            "-march=armv8.2-a+fp16",
+            "-O2",
+            "-static",
+            *link_inputs,
+            "-o",
+            os.path.join(arm64_output_dir, "hpl_exec_optimized"),
+            "-lm",
+        ]
+        if self.nonfinite_runtime:
+            clang_cmd.insert(-1, self.nonfinite_runtime)
+        if self.watchdog_specs and self.watchdog_runtime:
+            clang_cmd.insert(-1, self.watchdog_runtime)
+        if self.shadow_runtime:
+            clang_cmd.insert(-1, self.shadow_runtime)
+        if self.timing_runtime:
+            clang_cmd.insert(-1, self.timing_runtime)
+        if self.use_fork_server:
+            runtime_include = os.path.join(
+                os.path.dirname(os.path.dirname(self.forksrv_runtime)), "include"
+            )
+            clang_cmd[-1:-1] = [self.forksrv_runtime, f"-I{runtime_include}"]
+
+        result = subprocess.run(
+            clang_cmd,
+            cwd=individual_dir,
+            capture_output=True,
+            text=True,
+        )
+        if result.returncode != 0:
+            print(f"clang failed for individual {individual_id}: {result.stderr}")
+            return False
+        return True
+
+    def _static_throughput(
+        self, individual_id: str, individual_dir: str, arm64_output_dir: str
+    ):
+        """用 amp-mca 估计最内层循环的周期数，结果写到 mca.json，不影响适应度"""
+        cmd = [self.amp_mca, os.path.join(arm64_output_dir, "hpllink_optimized.ll")]
+        if self.amp_mca_functions:
+            cmd.append(f"-functions={self.amp_mca_functions}")
+        result = subprocess.run(cmd, cwd=individual_dir, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(f"amp-mca failed for individual {individual_id}: {result.stderr}")
+            return
+        with open(os.path.join(individual_dir, "mca.json"), "w") as f:
+            f.write(result.stdout)
+        weighted_total = json.loads(result.stdout)["weightedTotal"]
+        print(f"Individual {individual_id} static loop cycles: {weighted_total:.2f}")
+
+    def _read_code_hash(self, individual_dir: str):
+        code_hash_file = os.path.join(individual_dir, "code_hash.txt")
+        if not self.canonical_hash or not os.path.exists(code_hash_file):
+            return None
+        with open(code_hash_file) as f:
+            return f.read().strip() or None
+
+    def _incremental_codegen(
+        self, individual_id: str, individual_dir: str, arm64_output_dir: str
+    ):
+        """用 amp-codegen 按函数生成目标文件，IR 未变的函数复用缓存，返回目标文件列表"""
+        objects_dir = os.path.join(arm64_output_dir, "objects")
+        objects_list = os.path.join(objects_dir, "objects.txt")
+        cmd = [
+            self.amp_codegen,
+            os.path.join(arm64_output_dir, "hpllink_optimized.ll"),
+            "-o",
+            objects_dir,
+            "-cache-dir",
+            self.amp_codegen_cache_dir,
+            f"-max-size={self.amp_cache_max_mb}",
+            "-list",
+            objects_list,
+        ]
+        result = subprocess.run(cmd, cwd=individual_dir, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(f"amp-codegen failed for individual {individual_id}: {result.stderr}")
+            return None
+        print(result.stderr.strip())
+        with open(objects_list) as f:
+            return [line.strip() for line in f if line.strip()]
+
+    def _artifact_key(self, config: Dict[str, Any], individual_dir: str):
+        """计算 (基准模块, 规范化配置, 工具链) 对应的缓存键，未启用或失败时返回 None"""
+        if not self.amp_cache:
+            return None
+        if self._toolchain_version is None:
+            versions = []
+            for tool in ("opt", "llc", "clang"):
+                result = subprocess.run(
+                    [tool, "--version"], capture_output=True, text=True
+                )
+                versions.append(result.stdout.strip())
+            self._toolchain_version = "\n".join(versions)
+
+        # 插桩与链接进来的运行时同样决定产物内容，一并计入工具链部分；
+        # 运行时与 libMix 一样按文件内容计入，原地重新编译后不会命中旧的可执行文件
+        instrument_passes, instrument_args = self._instrument_passes()
+        runtimes = {
+            "nonfinite": self.nonfinite_runtime,
+            "watchdog": self.watchdog_runtime if self.watchdog_specs else None,
+            "shadow": self.shadow_runtime,
+            "timing": self.timing_runtime,
+            "forksrv": self.forksrv_runtime if self.use_fork_server else None,
+        }
+        runtimes = {name: path for name, path in runtimes.items() if path}
+        toolchain = "\n".join(
+            [self._toolchain_version]
+            + instrument_passes
+            + instrument_args
+            + [f"runtime={name}" for name in runtimes]
+        )
+        config_file = os.path.join(individual_dir, "cache_key_config.json")
+        self.config_manager.save_config(config, config_file)
+        cmd = [
+            self.amp_cache,
+            "key",
+            "-module",
+            self.initial_ll,
+            "-config",
+            config_file,
+            f"-toolchain={toolchain}",
+            f"-toolchain-file={os.environ['GA_SA_LIBMIX_PATH']}",
+        ] + [f"-toolchain-file={path}" for path in runtimes.values()]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(f"amp-cache key failed: {result.stderr}")
+            return None
+        return result.stdout.strip()
+
+    def _fetch_artifact(self, key: str, artifact: str, dest: str) -> bool:
+        cmd = [self.amp_cache, "get", "-dir", self.amp_cache_dir, key, artifact, dest]
+        return subprocess.run(cmd, capture_output=True).returncode == 0
+
+    def _store_artifacts(self, key: str, arm64_output_dir: str):
+        """保存降精后的 IR、汇编与可执行文件，由 amp-cache 负责原子写入与容量淘汰"""
+        artifacts = {
+            "ll": "hpllink_optimized.ll",
+            "s": "hpllink_optimized.s",
+            "exec": "hpl_exec_optimized",
+        }
+        for artifact, name in artifacts.items():
+            # 增量代码生成时没有汇编文件
+            if not os.path.exists(os.path.join(arm64_output_dir, name)):
+                continue
+            cmd = [
+                self.amp_cache,
+                "put",
+                "-dir",
+                self.amp_cache_dir,
+                f"-max-size={self.amp_cache_max_mb}",
+                key,
+                artifact,
+                os.path.join(arm64_output_dir, name),
+            ]
+            subprocess.run(cmd, capture_output=True)
+
+    def _instrument_passes(self):
+        """根据环境变量决定 -O2 之前要加的插桩 pass 及其参数"""
+        passes, args = [], []
+        if self.watchdog_specs and self.watchdog_runtime:
+            passes.append("convergence-watchdog")
+            args += [f"-watchdog={spec}" for spec in self.watchdog_specs]
+            if self.watchdog_patience:
+                args.append(f"-watchdog-patience={self.watchdog_patience}")
+            if self.watchdog_budget:
+                args.append(f"-watchdog-budget={self.watchdog_budget}")
+        if self.shadow_runtime:
+            passes.append("shadow-value")
+        if self.timing_runtime:
+            passes.append("region-timing")
+            if self.time_functions:
+                args.append(f"-time-functions={self.time_functions}")
+        # fork server 包装 main 放在最后，其他插桩（以及 fat-config 的配置选择）插入的 main 入口逻辑
+        # 都在 fork 之后执行；fat-config 遇到已被包装的 main 会报错
+        if self.use_fork_server:
+            passes.append("fork-server")
+        return passes, args
+
+    def _collect_blocked_changes(self, remarks_file: str):
+        """读 YAML 备注，把做不到的变更记入缓存。备注带 !Missed 等自定义标签，这里逐行解析"""
+        if not os.path.exists(remarks_file):
+            return
+        remarks, remark = [], None
+        with open(remarks_file, "r", encoding="utf-8") as f:
+            for line in f:
+                line = line.rstrip("\n")
+                if line.startswith("--- !"):
+                    remark = {"kind": line[5:].strip(), "args": {}}
+                    remarks.append(remark)
+                elif remark is None:
+                    continue
+                elif line.startswith("Name:"):
+                    remark["name"] = line.split(":", 1)[1].strip()
+                elif line.startswith("  - ") and ":" in line:
+                    key, value = line[4:].split(":", 1)
+                    # 参数名在同一条备注里可能重复（如多个 String），只保留第一个
+                    remark["args"].setdefault(key.strip(), value.strip().strip("'\""))
+        for remark in remarks:
+            args = remark["args"]
+            if remark["kind"] != "Missed" or remark.get("name") not in BLOCKING_REMARKS:
+                continue
+            if not all(key in args for key in ("Function", "Variable", "Type")):
+                continue
+            self.cache_manager.record_blocked_change(
+                args["Function"],
+                args["Variable"],
+                args["Type"],
+                remark["name"],
+                args.get("Reason", ""),
+            )
+
+    def _run_cpu(self) -> int:
+        return max(os.sched_getaffinity(0))
+
+    def _pin_run(self):
+        os.sched_setaffinity(0, {self._run_cpu()})
+
+    def _report_failed_run(self, individual_id, individual_dir, returncode, stderr):
+        if returncode == AMP_WATCHDOG_EXIT:
+            print(
+                f"individual {individual_id} stopped by convergence watchdog: "
+                f"{stderr.strip()}"
+            )
+        elif returncode == AMP_NONFINITE_EXIT:
+            print(
+                f"individual {individual_id} produced a non-finite value: "
+                f"{stderr.strip()}"
+            )
+            with open(os.path.join(individual_dir, "nonfinite.txt"), "w") as f:
+                f.write(stderr)
+        else:
+            print(f"qemu failed for individual {individual_id}: {stderr}")
+
+    def _run_with_fork_server(self, exec_path: str, individual_dir: str):
+        """经由 amp-run 完成 test_num 次运行，返回与逐次启动 qemu 相同格式的结果"""
+        cmd = [
+            self.amp_run,
+            "-n",
+            str(self.test_num),
+            "-args",
+            f"{self.size_num} {self.min_size} {self.max_size}",
+            "-C",
+            individual_dir,
+        ]
+        if self.isolate:
+            cmd += ["-cpus", str(self._run_cpu()), "-no-aslr"]
+        if self.perf_counters:
+            cmd.append("-perf-counters")
+        if self.fixed_frequency:
+            cmd.append("-fixed-frequency")
+        cmd += [
+            "--",
+            "qemu-aarch64",
+            "-L",
+            "/usr/aarch64-linux-gnu",
+            exec_path,
+        ]
+        result = subprocess.run(cmd, cwd=individual_dir, capture_output=True, text=True)
+
+        qemu_outputs = []
+        for test_run, line in enumerate(result.stdout.splitlines()):
+            run = json.loads(line)
+            qemu_output = {
+                "test_run": test_run + 1,
+                "stdout": run["stdout"],
+                "stderr": run["stderr"],
+                "returncode": run["exitCode"],
+                "seconds": run["seconds"],
+            }
+            if "counters" in run:
+                qemu_output["counters"] = run["counters"]
+            qemu_outputs.append(qemu_output)
+
+            qemu_output_file = os.path.join(
+                individual_dir, f"qemu_output_{test_run + 1}.json"
+            )
+            with open(qemu_output_file, "w") as f:
+                json.dump(qemu_output, f, indent=2)
+        if result.returncode != 0:
+            print(result.stderr)
+            # amp-run 返回 2 表示有运行失败，其退出码（86/87 等）交给调用方照常处理；
+            # 没有任何失败的运行记录说明是 amp-run 自身出错
+            if not any(output["returncode"] != 0 for output in qemu_outputs):
+                return None
+        return qemu_outputs
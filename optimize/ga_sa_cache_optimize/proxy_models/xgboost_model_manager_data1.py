@@ -228,6 +228,32 @@ class XGBoostModelManagerData1:
         print(f"特征数量: {len(self.feature_names)}")
         print(f"增强特征数量: {len(self.enhanced_feature_names)}")
 
+    def export_native_model(
+        self, path: str, X: np.ndarray, y: np.ndarray, feature_names: List[str]
+    ):
+        """直接在给定特征上训练一个同参数的 XGBoost 模型并保存为 JSON，供 amp-surrogate 本地推理。
+
+        特征工程引擎（GBDT 叶子编号 + 交互特征）无法在本地复现，
+        因此导出的模型不经过它，特征按名字与 amp-surrogate 的输入对应。
+        遗传算法用实测个体的 IR 特征（ir_features.json）训练它，见 GeneticOptimizer._train_native_surrogate。
+        """
+        native_model = xgb.XGBRegressor(
+            n_estimators=self.n_estimators,
+            max_depth=self.max_depth,
+            learning_rate=self.learning_rate,
+            subsample=self.subsample,
+            colsample_bytree=self.colsample_bytree,
+            reg_alpha=self.reg_alpha,
+            reg_lambda=self.reg_lambda,
+            random_state=self.random_state,
+            n_jobs=self.n_jobs,
+            enable_categorical=False,
+        )
+        native_model.fit(X, y)
+        native_model.get_booster().feature_names = list(feature_names)
+        native_model.save_model(path)
+        print(f"本地推理模型已保存到: {path}")
+
     def get_feature_importance(self) -> Dict[str, float]:
 
         if not self.is_trained:
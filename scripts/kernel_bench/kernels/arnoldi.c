@@ -0,0 +1,47 @@
+/* GMRES 的一步 Arnoldi：w = A * v_k，再对 v_0..v_k 做修正 Gram-Schmidt 正交化，对应 HPL-AI gmres.c */
+#include <math.h>
+
+#include "bench.h"
+
+void kb_arnoldi(int n, int k, double *A, int lda, double *V, int ldv, double *H) {
+    double *w = V + (k + 1) * ldv;
+    for (int i = 0; i < n; i++) w[i] = 0.0;
+    for (int j = 0; j < n; j++) {
+        double vj = V[j + k * ldv];
+        for (int i = 0; i < n; i++) w[i] += A[i + j * lda] * vj;
+    }
+    for (int j = 0; j <= k; j++) {
+        double dot = 0.0;
+        for (int i = 0; i < n; i++) dot += w[i] * V[i + j * ldv];
+        H[j] = dot;
+        for (int i = 0; i < n; i++) w[i] -= dot * V[i + j * ldv];
+    }
+    double norm = 0.0;
+    for (int i = 0; i < n; i++) norm += w[i] * w[i];
+    norm = sqrt(norm);
+    H[k + 1] = norm;
+    double scale = 1.0 / norm;
+    for (int i = 0; i < n; i++) w[i] *= scale;
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 2048);
+    int reps = bench_arg(argc, argv, 2, 5);
+    int k = 30;
+    unsigned seed = 5;
+    double *A = malloc(sizeof(double) * n * n);
+    double *V = malloc(sizeof(double) * n * (k + 2));
+    double *H = malloc(sizeof(double) * (k + 2));
+    for (int i = 0; i < n * n; i++) A[i] = bench_rand(&seed);
+    for (int i = 0; i < n * (k + 1); i++) V[i] = bench_rand(&seed);
+    for (int r = 0; r < reps; r++) {
+        bench_start();
+        kb_arnoldi(n, k, A, n, V, n, H);
+        bench_stop();
+    }
+    bench_report("arnoldi", 2.0 * n * n + 4.0 * n * (k + 1) + 3.0 * n);
+    free(A);
+    free(V);
+    free(H);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/* 内核基准的公共计时与输出。
+ * 计时状态放在全局变量里、辅助函数不进 include 列表，降精配置只会改到内核与 main 中的数据，
+ * 不会把计时变量一起降成 float/half。 */
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static struct timespec bench_t0;
+static double bench_best = -1;
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline void bench_start(void) { clock_gettime(CLOCK_MONOTONIC, &bench_t0); }
+
+/* 结束一次计时，保留各次中最快的一次 */
+static inline void bench_stop(void) {
+    double elapsed = bench_now() - ((double)bench_t0.tv_sec + (double)bench_t0.tv_nsec * 1e-9);
+    if (bench_best < 0 || elapsed < bench_best) bench_best = elapsed;
+}
+
+/* 一行输出，run_kernels.py 据此解析 */
+static inline void bench_report(const char *kernel, double flops) {
+    printf("KERNEL=%s SECONDS=%.9f GFLOPS=%.6f\n", kernel, bench_best, flops / bench_best * 1e-9);
+}
+
+/* 命令行：<n> <重复次数> */
+static inline int bench_arg(int argc, char **argv, int index, int fallback) {
+    return argc > index ? atoi(argv[index]) : fallback;
+}
+
+/* 确定性的伪随机数，取值在 [-0.5, 0.5) */
+static inline double bench_rand(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (double)((*state >> 8) & 0xffffff) / 16777216.0 - 0.5;
+}
+
+#endif
@@ -0,0 +1,26 @@
+/* 双精度矩阵与低精度工作矩阵之间的复制转换，对应 HPL-AI convert.c；每个元素计一次运算 */
+#include "bench.h"
+
+void kb_convert(int m, int n, double *src, int lds, double *dst, int ldd) {
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < m; i++) dst[i + j * ldd] = src[i + j * lds];
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 2048);
+    int reps = bench_arg(argc, argv, 2, 10);
+    unsigned seed = 6;
+    double *src = malloc(sizeof(double) * n * n);
+    double *dst = malloc(sizeof(double) * n * n);
+    for (int i = 0; i < n * n; i++) src[i] = bench_rand(&seed);
+    for (int r = 0; r < reps; r++) {
+        bench_start();
+        kb_convert(n, n, src, n, dst, n);
+        bench_stop();
+    }
+    bench_report("convert", 1.0 * n * n);
+    free(src);
+    free(dst);
+    return 0;
+}
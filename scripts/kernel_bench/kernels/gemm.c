@@ -0,0 +1,37 @@
+/* C = alpha * A * B + beta * C，列主序，对应 HPL-AI blas.c 中的 GEMM */
+#include "bench.h"
+
+void kb_gemm(int m, int n, int k, double alpha, double *A, int lda, double *B, int ldb, double beta, double *C,
+             int ldc) {
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < m; i++) C[i + j * ldc] *= beta;
+        for (int l = 0; l < k; l++) {
+            double temp = alpha * B[l + j * ldb];
+            for (int i = 0; i < m; i++) C[i + j * ldc] += temp * A[i + l * lda];
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 256);
+    int reps = bench_arg(argc, argv, 2, 5);
+    unsigned seed = 1;
+    double *A = malloc(sizeof(double) * n * n);
+    double *B = malloc(sizeof(double) * n * n);
+    double *C = malloc(sizeof(double) * n * n);
+    for (int i = 0; i < n * n; i++) {
+        A[i] = bench_rand(&seed);
+        B[i] = bench_rand(&seed);
+        C[i] = 0;
+    }
+    for (int r = 0; r < reps; r++) {
+        bench_start();
+        kb_gemm(n, n, n, -1.0, A, n, B, n, 1.0, C, n);
+        bench_stop();
+    }
+    bench_report("gemm", 2.0 * n * n * n);
+    free(A);
+    free(B);
+    free(C);
+    return 0;
+}
@@ -0,0 +1,34 @@
+/* y = alpha * A * x + beta * y，列主序，对应 HPL-AI blas.c 中的 GEMV（残差计算） */
+#include "bench.h"
+
+void kb_gemv(int m, int n, double alpha, double *A, int lda, double *x, double beta, double *y) {
+    for (int i = 0; i < m; i++) y[i] *= beta;
+    for (int j = 0; j < n; j++) {
+        double temp = alpha * x[j];
+        for (int i = 0; i < m; i++) y[i] += temp * A[i + j * lda];
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 2048);
+    int reps = bench_arg(argc, argv, 2, 10);
+    unsigned seed = 2;
+    double *A = malloc(sizeof(double) * n * n);
+    double *x = malloc(sizeof(double) * n);
+    double *y = malloc(sizeof(double) * n);
+    for (int i = 0; i < n * n; i++) A[i] = bench_rand(&seed);
+    for (int i = 0; i < n; i++) {
+        x[i] = bench_rand(&seed);
+        y[i] = 0;
+    }
+    for (int r = 0; r < reps; r++) {
+        bench_start();
+        kb_gemv(n, n, 1.0, A, n, x, 0.5, y);
+        bench_stop();
+    }
+    bench_report("gemv", 2.0 * n * n);
+    free(A);
+    free(x);
+    free(y);
+    return 0;
+}
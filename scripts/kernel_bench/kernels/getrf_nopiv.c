@@ -0,0 +1,37 @@
+/* 不选主元的 LU 分解（右看、逐列），对应 HPL-AI dgetrf_nopiv.c */
+#include "bench.h"
+
+void kb_getrf_nopiv(int m, int n, double *A, int lda) {
+    int steps = m < n ? m : n;
+    for (int j = 0; j < steps; j++) {
+        double pivot = A[j + j * lda];
+        double scale = 1.0 / pivot;
+        for (int i = j + 1; i < m; i++) A[i + j * lda] *= scale;
+        for (int k = j + 1; k < n; k++) {
+            double temp = A[j + k * lda];
+            for (int i = j + 1; i < m; i++) A[i + k * lda] -= A[i + j * lda] * temp;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 384);
+    int reps = bench_arg(argc, argv, 2, 3);
+    unsigned seed = 4;
+    double *A = malloc(sizeof(double) * n * n);
+    double *work = malloc(sizeof(double) * n * n);
+    /* 与 HPL-AI matgen 一样对角占优，不选主元也稳定 */
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) A[i + j * n] = bench_rand(&seed) + (i == j ? n : 0);
+    }
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < n * n; i++) work[i] = A[i];
+        bench_start();
+        kb_getrf_nopiv(n, n, work, n);
+        bench_stop();
+    }
+    bench_report("getrf_nopiv", 2.0 / 3.0 * n * n * n);
+    free(A);
+    free(work);
+    return 0;
+}
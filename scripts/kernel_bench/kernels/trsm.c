@@ -0,0 +1,39 @@
+/* 解 L * X = B（L 为单位下三角，左侧、不转置），列主序，对应 HPL-AI blas.c 中的 TRSM */
+#include "bench.h"
+
+void kb_trsm(int m, int n, double alpha, double *A, int lda, double *B, int ldb) {
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < m; i++) B[i + j * ldb] *= alpha;
+        for (int k = 0; k < m; k++) {
+            double temp = B[k + j * ldb];
+            if (temp != 0.0) {
+                for (int i = k + 1; i < m; i++) B[i + j * ldb] -= temp * A[i + k * lda];
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = bench_arg(argc, argv, 1, 256);
+    int reps = bench_arg(argc, argv, 2, 5);
+    unsigned seed = 3;
+    double *A = malloc(sizeof(double) * n * n);
+    double *B = malloc(sizeof(double) * n * n);
+    double *work = malloc(sizeof(double) * n * n);
+    /* 对角占优，多次求解不会溢出 */
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) A[i + j * n] = i == j ? 1.0 : bench_rand(&seed) / n;
+    }
+    for (int i = 0; i < n * n; i++) B[i] = bench_rand(&seed);
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < n * n; i++) work[i] = B[i];
+        bench_start();
+        kb_trsm(n, n, 1.0, A, n, work, n);
+        bench_stop();
+    }
+    bench_report("trsm", 1.0 * n * n * n);
+    free(A);
+    free(B);
+    free(work);
+    return 0;
+}
@@ -0,0 +1,316 @@
+"""内核基准：用预设配置对 HPL-AI 中的典型内核降精，本机编译运行，检查降精后代码的质量。
+
+每个内核（kernels/*.c，内核函数名为 kb_<内核名>）依次：
+  clang -O0 生成 .ll -> create-config 列出变量 -> 按预设配置改类型 -> pl 降精
+  -> opt -O2（记录向量化备注）-> clang 编译链接 -> 运行 <重复次数> 次取最快
+
+报告每个内核、每个配置的 Gflops、内核函数中剩余的类型转换条数，以及循环/SLP 向量化情况。
+--compare 与之前的报告比较，转换变多、向量化变少或 Gflops 下降超过 --tolerance 时返回 1，
+修改访问者（change_inst 等）之后据此检查有没有代码质量回退。
+
+    python3 run_kernels.py --plugin libMix.so.17 -o report.json
+    python3 run_kernels.py --plugin libMix.so.17 --compare report.json --kernels gemm,trsm
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+KERNEL_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "kernels")
+
+# 配置名 -> (要改的类型前缀, 新精度)。storage 只改数组（指针），full 连同标量一起改
+CONFIGS = {
+    "all-double": None,
+    "storage-float": ("pointer", "float"),
+    "storage-half": ("pointer", "half"),
+    "full-float": ("all", "float"),
+    "full-half": ("all", "half"),
+}
+
+# 各内核默认的问题规模与重复次数，与 kernels/*.c 中的默认值一致
+DEFAULT_ARGS = {
+    "gemm": (256, 5),
+    "gemv": (2048, 10),
+    "trsm": (256, 5),
+    "getrf_nopiv": (384, 3),
+    "arnoldi": (2048, 5),
+    "convert": (2048, 10),
+}
+
+CAST_RE = re.compile(r"=\s+(fpext|fptrunc|sitofp|uitofp|fptosi|fptoui)\b")
+VECTOR_FP_RE = re.compile(r"=\s+(fadd|fsub|fmul|fdiv|fneg)\s+(fast\s+)?<\d+ x (half|float|double)>")
+
+
+def run(cmd, log_file, cwd=None):
+    """运行一步，命令与输出追加到 log_file"""
+    result = subprocess.run(cmd, cwd=cwd, capture_output=True, text=True)
+    with open(log_file, "a", encoding="utf-8") as f:
+        f.write("$ " + " ".join(cmd) + "\n" + result.stdout + result.stderr + "\n")
+    return result
+
+
+def make_config(variables, config_name):
+    """create-config 给出的变量表 -> 预设配置；只写需要改的条目，int、ptr 等不动"""
+    rule = CONFIGS[config_name]
+    config = {"localVar": []}
+    if rule is None:
+        return config
+    scope, precision = rule
+    for var in variables.get("localVar", []):
+        var_type = var.get("type", "")
+        if not var_type.startswith("double"):
+            continue
+        is_pointer = var_type.endswith("*")
+        if scope == "pointer" and not is_pointer:
+            continue
+        config["localVar"].append(
+            {
+                "function": var["function"],
+                "name": var["name"],
+                "type": precision + var_type[len("double") :],
+            }
+        )
+    return config
+
+
+def function_body(ll_text, function):
+    """取出 define ... @function( 到对应 } 之间的文本"""
+    match = re.search(r"^define [^\n]*@" + re.escape(function) + r"\(", ll_text, re.M)
+    if not match:
+        return ""
+    end = ll_text.find("\n}", match.start())
+    return ll_text[match.start() : end if end >= 0 else len(ll_text)]
+
+
+def code_quality(ll_file, function):
+    with open(ll_file, "r", encoding="utf-8") as f:
+        body = function_body(f.read(), function)
+    casts = {}
+    for op in CAST_RE.findall(body):
+        casts[op] = casts.get(op, 0) + 1
+    return {
+        "casts": sum(casts.values()),
+        "castsByOp": casts,
+        "vectorFPOps": len(VECTOR_FP_RE.findall(body)),
+    }
+
+
+def vectorization(remarks_file, function):
+    """统计内核函数的 loop-vectorize / slp-vectorizer 备注。备注带自定义 YAML 标签，逐行解析"""
+    status = {"loopsVectorized": 0, "loopsMissed": 0, "slpVectorized": 0, "missedReasons": []}
+    if not os.path.exists(remarks_file):
+        return status
+    remark = None
+
+    def flush(remark):
+        if not remark or remark.get("Function") != function:
+            return
+        pass_name, name, kind = remark.get("Pass"), remark.get("Name"), remark["kind"]
+        if pass_name == "loop-vectorize":
+            if kind == "Passed":
+                status["loopsVectorized"] += 1
+            elif kind in ("Missed", "Analysis"):
+                status["loopsMissed"] += kind == "Missed"
+                if name not in status["missedReasons"]:
+                    status["missedReasons"].append(name)
+        elif pass_name == "slp-vectorizer" and kind == "Passed":
+            status["slpVectorized"] += 1
+
+    with open(remarks_file, "r", encoding="utf-8") as f:
+        for line in f:
+            if line.startswith("--- !"):
+                flush(remark)
+                remark = {"kind": line[5:].strip()}
+            elif remark is not None and re.match(r"^(Pass|Name|Function):", line):
+                key, value = line.split(":", 1)
+                remark[key] = value.strip().strip("'\"")
+    flush(remark)
+    return status
+
+
+def bench_kernel(kernel, args, work_dir):
+    kernel_dir = os.path.join(work_dir, kernel)
+    os.makedirs(kernel_dir, exist_ok=True)
+    log = os.path.join(kernel_dir, "build.log")
+    if os.path.exists(log):
+        os.remove(log)
+    function = "kb_" + kernel
+    cflags = args.cflags.split()
+    plugin = [f"-load={args.plugin}", f"-load-pass-plugin={args.plugin}"]
+
+    # -O0 但不加 optnone，降精之后还要 -O2；保留值名，配置按名字找变量
+    base_ll = os.path.join(kernel_dir, "base.ll")
+    source = os.path.join(KERNEL_DIR, kernel + ".c")
+    cmd = [args.clang] + cflags
+    cmd += ["-O0", "-Xclang", "-disable-O0-optnone", "-fno-discard-value-names"]
+    cmd += ["-emit-llvm", "-S", source, "-o", base_ll]
+    if run(cmd, log).returncode != 0:
+        return {"error": f"clang failed, see {log}"}
+
+    # 只列内核与 main 的变量，bench.h 中的计时函数不进配置
+    for name, content in (
+        ("include.txt", f"{function}\nmain\n"),
+        ("exclude.txt", ""),
+        ("include_global.txt", ""),
+    ):
+        with open(os.path.join(kernel_dir, name), "w", encoding="utf-8") as f:
+            f.write(content)
+    variables_file = os.path.join(kernel_dir, "variables.json")
+    cmd = [args.opt] + plugin + ["-passes=create-config", f"-filename={variables_file}"]
+    cmd += ["-disable-output", base_ll]
+    if run(cmd, log, cwd=kernel_dir).returncode != 0:
+        return {"error": f"create-config failed, see {log}"}
+    with open(variables_file, "r", encoding="utf-8") as f:
+        variables = json.load(f)
+
+    size, reps = DEFAULT_ARGS.get(kernel, (0, 1))
+    size, reps = args.size or size, args.reps or reps
+    results = {}
+    for config_name in args.configs:
+        config_dir = os.path.join(kernel_dir, config_name)
+        os.makedirs(config_dir, exist_ok=True)
+        config = make_config(variables, config_name)
+        config_file = os.path.join(config_dir, "config.json")
+        with open(config_file, "w", encoding="utf-8") as f:
+            json.dump(config, f, indent=2)
+        result = {"configEntries": len(config["localVar"])}
+        results[config_name] = result
+
+        lowered_ll = os.path.join(config_dir, "lowered.ll")
+        if config["localVar"]:
+            cmd = [args.opt] + plugin + ["-passes=pl", f"-json-config={config_file}"]
+            cmd += ["-amp-quiet", base_ll, "-S", "-o", lowered_ll]
+            if run(cmd, log, cwd=config_dir).returncode != 0:
+                result["error"] = "pl failed"
+                continue
+        else:
+            shutil.copy2(base_ll, lowered_ll)
+
+        optimized_ll = os.path.join(config_dir, "optimized.ll")
+        remarks_file = os.path.join(config_dir, "o2_remarks.yaml")
+        cmd = [args.opt, "-passes=default<O2>", lowered_ll, "-S", "-o", optimized_ll]
+        cmd += [f"-pass-remarks-output={remarks_file}"]
+        cmd += ["-pass-remarks-filter=loop-vectorize|slp-vectorizer"]
+        if run(cmd, log).returncode != 0:
+            result["error"] = "opt -O2 failed"
+            continue
+        result.update(code_quality(optimized_ll, function))
+        result["vectorization"] = vectorization(remarks_file, function)
+
+        exe = os.path.join(config_dir, "kernel")
+        cmd = [args.clang] + cflags + ["-O2", optimized_ll, "-o", exe, "-lm"]
+        if run(cmd, log).returncode != 0:
+            result["error"] = "link failed"
+            continue
+        cmd = args.runner.split() + [exe, str(size), str(reps)]
+        run_result = run(cmd, log)
+        match = re.search(r"SECONDS=(\S+) GFLOPS=(\S+)", run_result.stdout)
+        if run_result.returncode != 0 or not match:
+            result["error"] = f"run failed with exit code {run_result.returncode}"
+            continue
+        result["seconds"] = float(match.group(1))
+        result["gflops"] = float(match.group(2))
+    return results
+
+
+def print_table(report):
+    print(f"{'kernel':<14}{'config':<15}{'Gflops':>10}{'casts':>7}{'vecops':>8}{'vloops':>8}{'slp':>5}")
+    for kernel, results in report["kernels"].items():
+        if "error" in results:
+            print(f"{kernel:<14}{results['error']}")
+            continue
+        for config_name, r in results.items():
+            if "error" in r and "casts" not in r:
+                print(f"{kernel:<14}{config_name:<15}{r['error']}")
+                continue
+            vec = r["vectorization"]
+            gflops = f"{r['gflops']:.3f}" if "gflops" in r else r.get("error", "-")
+            print(
+                f"{kernel:<14}{config_name:<15}{gflops:>10}{r['casts']:>7}"
+                f"{r['vectorFPOps']:>8}{vec['loopsVectorized']:>8}{vec['slpVectorized']:>5}"
+            )
+
+
+def compare(report, baseline, tolerance):
+    """返回回退列表：转换变多、向量化变少、Gflops 相对下降超过 tolerance"""
+    regressions = []
+    for kernel, results in report["kernels"].items():
+        for config_name, new in results.items():
+            old = baseline.get("kernels", {}).get(kernel, {}).get(config_name)
+            if not isinstance(new, dict) or not isinstance(old, dict):
+                continue
+            where = f"{kernel}/{config_name}"
+            if "error" in new and "error" not in old:
+                regressions.append(f"{where}: {new['error']}")
+                continue
+            if new.get("casts", 0) > old.get("casts", 0):
+                regressions.append(f"{where}: casts {old['casts']} -> {new['casts']}")
+            new_vec, old_vec = new.get("vectorization", {}), old.get("vectorization", {})
+            for key in ("loopsVectorized", "slpVectorized"):
+                if new_vec.get(key, 0) < old_vec.get(key, 0):
+                    regressions.append(f"{where}: {key} {old_vec[key]} -> {new_vec.get(key, 0)}")
+            if "gflops" in new and "gflops" in old and old["gflops"] > 0:
+                change = new["gflops"] / old["gflops"] - 1
+                if change < -tolerance:
+                    regressions.append(
+                        f"{where}: Gflops {old['gflops']:.3f} -> {new['gflops']:.3f} ({change:+.1%})"
+                    )
+    return regressions
+
+
+def main():
+    kernels = sorted(f[:-2] for f in os.listdir(KERNEL_DIR) if f.endswith(".c"))
+    parser = argparse.ArgumentParser(description="Kernel benchmarks for lowered code quality")
+    parser.add_argument("--plugin", default=os.environ.get("GA_SA_LIBMIX_PATH"), help="MixPrecision plugin")
+    parser.add_argument("--clang", default="clang")
+    parser.add_argument("--opt", default="opt")
+    parser.add_argument("--cflags", default="-march=native", help="Flags for clang (target, -march)")
+    parser.add_argument("--runner", default="", help="Launcher prefix, e.g. 'qemu-aarch64 -L /usr/aarch64-linux-gnu'")
+    parser.add_argument("--kernels", default=",".join(kernels))
+    parser.add_argument("--configs", default=",".join(CONFIGS))
+    parser.add_argument("--size", type=int, default=0, help="Problem size, kernel default if 0")
+    parser.add_argument("--reps", type=int, default=0, help="Repetitions, kernel default if 0")
+    parser.add_argument("--work-dir", default="kernel_bench_out")
+    parser.add_argument("--compare", help="Earlier report to check for regressions")
+    parser.add_argument("--tolerance", type=float, default=0.05, help="Allowed relative Gflops drop")
+    parser.add_argument("-o", "--output", default=None)
+    args = parser.parse_args()
+
+    if not args.plugin:
+        parser.error("--plugin (or GA_SA_LIBMIX_PATH) is required")
+    args.configs = [c for c in args.configs.split(",") if c]
+    unknown = [c for c in args.configs if c not in CONFIGS]
+    if unknown:
+        parser.error(f"unknown config(s): {', '.join(unknown)}")
+    args.work_dir = os.path.abspath(args.work_dir)
+
+    report = {"cflags": args.cflags, "runner": args.runner, "kernels": {}}
+    for kernel in [k for k in args.kernels.split(",") if k]:
+        if kernel not in kernels:
+            parser.error(f"unknown kernel {kernel}")
+        print(f"=== {kernel} ===", file=sys.stderr)
+        report["kernels"][kernel] = bench_kernel(kernel, args, args.work_dir)
+
+    print_table(report)
+    output = args.output or os.path.join(args.work_dir, "report.json")
+    with open(output, "w", encoding="utf-8") as f:
+        json.dump(report, f, indent=2)
+    print(f"Report written to {output}")
+
+    if args.compare:
+        with open(args.compare, "r", encoding="utf-8") as f:
+            baseline = json.load(f)
+        regressions = compare(report, baseline, args.tolerance)
+        for line in regressions:
+            print(f"REGRESSION {line}")
+        if regressions:
+            sys.exit(1)
+        print("No regressions")
+
+
+if __name__ == "__main__":
+    main()